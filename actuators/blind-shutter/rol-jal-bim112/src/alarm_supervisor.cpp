@@ -0,0 +1,80 @@
+/*
+ *  alarm_supervisor.cpp - Device wide monitoring of the alarm objects of the
+ *                         channels.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "alarm_supervisor.h"
+
+AlarmSupervisor::AlarmSupervisor()
+  : queued(0)
+{
+}
+
+void AlarmSupervisor::start(unsigned int monitor, unsigned int time, unsigned int now)
+{
+    unsigned int end = now + time;
+    unsigned int i;
+
+    if (monitor >= MAX_ALARM_MONITORS)
+        return;
+    stop(monitor);
+    // the monitoring times are far below 2^31 ms, the difference is wrap safe
+    for (i = queued; i && ((int) (end - expiry[i - 1]) < 0); i--)
+    {
+        expiry[i] = expiry[i - 1];
+        queue[i]  = queue[i - 1];
+    }
+    expiry[i] = end;
+    queue[i]  = monitor;
+    queued++;
+}
+
+void AlarmSupervisor::stop(unsigned int monitor)
+{
+    unsigned int i, j;
+    for (i = 0, j = 0; i < queued; i++)
+    {
+        if (queue[i] != monitor)
+        {
+            expiry[j]  = expiry[i];
+            queue[j++] = queue[i];
+        }
+    }
+    queued = j;
+}
+
+int AlarmSupervisor::nextExpired(unsigned int now)
+{
+    if (!queued || ((int) (now - expiry[0]) < 0))
+        return -1;
+    int monitor = queue[0];
+    queued--;
+    for (unsigned int i = 0; i < queued; i++)
+    {
+        expiry[i] = expiry[i + 1];
+        queue[i]  = queue[i + 1];
+    }
+    return monitor;
+}
+
+unsigned int AlarmSupervisor::timeToDeadline(unsigned int now) const
+{
+    if (!queued)
+        return 0xFFFFFFFF;
+    int diff = expiry[0] - now;
+    return diff > 0 ? diff : 0;
+}
+
+bool AlarmSupervisor::isRunning(unsigned int monitor) const
+{
+    for (unsigned int i = 0; i < queued; i++)
+    {
+        if (queue[i] == monitor)
+            return true;
+    }
+    return false;
+}
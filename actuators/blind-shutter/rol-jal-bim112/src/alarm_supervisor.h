@@ -0,0 +1,73 @@
+/*
+ *  alarm_supervisor.h - Device wide monitoring of the alarm objects of the
+ *                       channels.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef ROL_JAL_BIM112_SRC_ALARM_SUPERVISOR_H_
+#define ROL_JAL_BIM112_SRC_ALARM_SUPERVISOR_H_
+
+#define MAX_ALARM_MONITORS 32 //!< 8 channels with 4 alarms each
+
+/**
+ * An active alarm with a monitoring time is released if its object is not
+ * sent again within that time (e.g. a failed wind sensor must not block
+ * the shutters forever).
+ *
+ * Instead of a timeout per alarm and channel which has to be checked in
+ * every loop, the running monitors are kept in one list sorted by their
+ * expiry time. Only the first entry has to be compared with the current
+ * time, the channel is notified when its monitor expires.
+ *
+ * A monitor is identified by its number: channel * NO_OF_ALARMS + alarm.
+ */
+class AlarmSupervisor
+{
+public:
+    AlarmSupervisor();
+
+    /**
+     * Start or re-trigger a monitor.
+     *
+     * @param monitor the number of the monitor
+     * @param time the monitoring time in ms
+     * @param now the current time in ms (millis())
+     */
+    void start(unsigned int monitor, unsigned int time, unsigned int now);
+
+    /**
+     * Stop a monitor, stopping a monitor which does not run has no effect.
+     */
+    void stop(unsigned int monitor);
+
+    /**
+     * @param now the current time in ms (millis())
+     * @return the next monitor which has expired, -1 if none
+     */
+    int nextExpired(unsigned int now);
+
+    /**
+     * @param now the current time in ms (millis())
+     * @return the ms until the next monitor expires, 0xFFFFFFFF if no
+     *         monitor is running
+     */
+    unsigned int timeToDeadline(unsigned int now) const;
+
+    bool isRunning(unsigned int monitor) const;
+    unsigned int runningMonitors(void) const;
+
+protected:
+    unsigned int  expiry[MAX_ALARM_MONITORS]; //!< millis() when the monitors expire, sorted
+    unsigned char queue[MAX_ALARM_MONITORS];  //!< the running monitors in the order of their expiry
+    unsigned int  queued;                     //!< number of running monitors
+};
+
+inline unsigned int AlarmSupervisor::runningMonitors(void) const
+{
+    return queued;
+}
+
+#endif /* ROL_JAL_BIM112_SRC_ALARM_SUPERVISOR_H_ */
@@ -25,6 +25,9 @@
 #endif
 
 Channel * channels[NO_OF_CHANNELS];
+
+static unsigned int channelsWakeup; //!< millis() when the channels have to be processed again
+static bool         channelsIdle;   //!< no channel has a deadline, wait for the next command
 #ifdef MEM_TEST
 Blind b0 = Blind(0, 0);
 Blind b1 = Blind(1, 1);
@@ -32,8 +35,23 @@ Blind b2 = Blind(2, 2);
 Shutter b3 = Shutter(3, 3);
 #endif
 
+void wakeupChannels(void)
+{
+    channelsIdle   = false;
+    channelsWakeup = millis();
+}
+
+unsigned int timeToWakeup(void)
+{
+    int diff = channelsWakeup - millis();
+    if (channelsIdle)
+        return NO_DEADLINE;
+    return diff > 0 ? diff : 0;
+}
+
 void objectUpdated(int objno)
 {
+    wakeupChannels();
     if (objno >= 13)
     {   // handle the com objects specific to one channel
         unsigned int channel = (objno - 13) / 20;
@@ -100,6 +118,7 @@ void checkHandActuation(void)
     {
         return;
     }
+    wakeupChannels();
 
     if (btnNumber & 0x01)
     {
@@ -117,28 +136,67 @@ void checkHandActuation(void)
     }
 }
 
-void checkPeriodicFuntions(void)
+bool checkPeriodicFuntions(void)
 {
-    for (unsigned int i = 0; i < NO_OF_CHANNELS; i++)
-    {
-        Channel * chn = channels[i];
-        if (chn)
-            chn->periodic();
-    }
+    bool due = !channelsIdle && ((int) (millis() - channelsWakeup) >= 0);
+    if (due)
+    {   // at least one channel has reached its deadline
+        unsigned int next = NO_DEADLINE;
+        int monitor;
+        while ((monitor = alarmSupervisor.nextExpired(millis())) >= 0)
+        {   // notify only the channel whose alarm has not been sent again in time
+            Channel * chn = channels[monitor / NO_OF_ALARMS];
+            if (chn)
+                chn->alarmExpired(monitor % NO_OF_ALARMS);
+        }
+        for (unsigned int i = 0; i < NO_OF_CHANNELS; i++)
+        {
+            Channel * chn = channels[i];
+            if (chn)
+            {
+                chn->periodic();
+                unsigned int deadline = chn->timeToDeadline();
+                if (deadline < next)
+                    next = deadline;
+            }
+        }
 
-    if (PWMDisabled.expired() || PWMDisabled.stopped()) // if (PWMDisabled.started () && PWMDisabled.expired()) // this was never triggered
-    {
-        Channel::startPWM();  // re-enable the PWM
+        if (PWMDisabled.expired() || PWMDisabled.stopped()) // if (PWMDisabled.started () && PWMDisabled.expired()) // this was never triggered
+        {
+            Channel::startPWM();  // re-enable the PWM
+        }
+        else if (PWMDisabled.remaining() < next)
+        {
+            next = PWMDisabled.remaining();
+        }
+        if (alarmSupervisor.timeToDeadline(millis()) < next)
+        {
+            next = alarmSupervisor.timeToDeadline(millis());
+        }
+
+        int objno;
+        while ((objno = statusCoalescer.nextDue(millis())) >= 0)
+        {   // send the collected status changes
+            bcu.comObjects->objectWritten(objno);
+        }
+        if (statusCoalescer.timeToDeadline(millis()) < next)
+        {
+            next = statusCoalescer.timeToDeadline(millis());
+        }
+        channelsIdle   = next == NO_DEADLINE;
+        channelsWakeup = millis() + next;
     }
     if (handAct != nullptr)
     {
         checkHandActuation();
     }
+    return due;
 }
 
 void initApplication(void)
 {
     Channel::initPWM(PIN_PWM);  // configure digital pin PIO3_2 (PIN_PWM) and timer16_0 for PWM
+    wakeupChannels();
 
     unsigned int address = currentVersion->baseAddress;
 
@@ -22,9 +22,25 @@ extern Channel * channels[NO_OF_CHANNELS];
 void objectUpdated(int objno);
 
 /**
- * Called during each iteration of the main loop
+ * Called during each iteration of the main loop. The channels are only
+ * processed when the earliest deadline of all channels has been reached or
+ * a command has been received in the meantime.
+ *
+ * @return true if the channels have been processed
+ */
+bool checkPeriodicFuntions(void);
+
+/**
+ * Process the channels in the next iteration of the main loop, regardless
+ * of their deadlines
+ */
+void wakeupChannels(void);
+
+/**
+ * @return the ms until checkPeriodicFuntions() will process the channels
+ *         again, NO_DEADLINE if they wait for a command
  */
-void checkPeriodicFuntions(void);
+unsigned int timeToWakeup(void);
 
 /**
  * Called during the initialization of the application
@@ -15,12 +15,14 @@ Blind::Blind(unsigned int number, unsigned int address)
   : Channel(number, address)
   , slatMoveForTime(0)
   , slatPosition(0)
-  , slatStartPosition(-1)
+  , slatPositionFine(0)
+  , slatStartPosition(0)
   , slatTargetPosition(-1)
   , slatSavedPosition(-1)
 {
     shortTime = bcu.userEeprom->getUInt16(address +   6);
     slatTime  = bcu.userEeprom->getUInt16(address +  8);
+    slatFactor = travelFactor(slatTime);
     for (unsigned int i = 0; i < NO_OF_SCENES; i++)
     {
         sceneSlatPos[i] = bcu.userEeprom->getUInt8(address + 24 + i);
@@ -80,31 +82,37 @@ void Blind::moveSlatFor(unsigned int time, unsigned int direction)
 
 bool Blind::_trackSlatPosition(void)
 {
-    unsigned int moveBy = timeToPercentage(startTime, slatTime);
+    int moveBy = timeToTravel(startTime, slatFactor, slatTime);
     bool slatPosReached = false;
     if (direction == UP)
     {
-        slatPosition = slatStartPosition - moveBy;
-        if (slatPosition <= 0)
+        slatPositionFine = slatStartPosition - moveBy;
+        if (slatPositionFine <= 0)
         {
-            slatPosition = 0;
+            slatPositionFine = 0;
             state = MOVE;
             startTime = millis();
         }
-        slatPosReached = slatPosition <= slatTargetPosition;
     }
     else
     {
-        slatPosition = slatStartPosition + moveBy;
-        if (slatPosition >= 255)
+        slatPositionFine = slatStartPosition + moveBy;
+        if (slatPositionFine >= POS_FIXED(255))
         {
-            slatPosition = 255;
+            slatPositionFine = POS_FIXED(255);
             state = MOVE;
             startTime = millis();
         }
-        slatPosReached = slatPosition >= slatTargetPosition;
     }
-    bcu.comObjects->objectSetValue(firstObjNo + COM_OBJ_SLAT_POSITION, slatPosition);
+    short newSlatPosition = POS_ROUND(slatPositionFine);
+    if (newSlatPosition != slatPosition)
+    {   // update the status object only if the reported position changes
+        slatPosition = newSlatPosition;
+        bcu.comObjects->objectSetValue(firstObjNo + COM_OBJ_SLAT_POSITION, slatPosition);
+    }
+    if (direction == UP)
+         slatPosReached = slatPosition <= slatTargetPosition;
+    else slatPosReached = slatPosition >= slatTargetPosition;
     if (  (   slatMoveForTime
           && (elapsed(startTime) >= slatMoveForTime)
           )
@@ -143,7 +151,7 @@ bool Blind::_inSavedPosition(void)
 
 void Blind::_startTracking(void)
 {
-    slatStartPosition = slatPosition;
+    slatStartPosition = slatPositionFine;
     Channel::_startTracking();
 }
 
@@ -182,8 +190,8 @@ bool Blind::_restorePosition(void)
 
 void Blind::_sendPosition()
 {
-    bcu.comObjects->objectWrite(firstObjNo + COM_OBJ_POSITION, position);
-    bcu.comObjects->objectWrite(firstObjNo + COM_OBJ_SLAT_POSITION, slatPosition);
+    _writeStatus(COM_OBJ_POSITION, position);
+    _writeStatus(COM_OBJ_SLAT_POSITION, slatPosition);
 }
 
 void Blind::_moveToOneBitPostion()
@@ -41,6 +41,7 @@ class Blind: public Channel
     virtual void _moveToOneBitPostion();
 
     unsigned int   slatTime;                          //!< time the slats need from fully closed to fully open
+    uint64_t       slatFactor;                        //!< reciprocal of the slat time, see travelFactor()
     unsigned int   slatPosAfterMove;                  //!< position the slats should take after a move command
     unsigned short slatAutoPosition;                  //!< slat position of the last automatic drive
     unsigned int   slatMoveForTime;                   //!< specify for how long the blind should be moved
@@ -51,7 +52,8 @@ class Blind: public Channel
 
     // track position of slats
              short slatPosition;         //!< current channel position
-             short slatStartPosition;    //!< position when the movement started
+             int   slatPositionFine;     //!< current channel position (fixed point, see POS_FRACTION_BITS)
+             int   slatStartPosition;    //!< position when the movement started (fixed point)
              short slatTargetPosition;   //!< requested target position
              short slatSavedPosition;    //!< position before an automatic commands was triggered
 };
@@ -18,7 +18,13 @@ MASK0701 bcu = MASK0701();
 const int outputPins[NO_OF_OUTPUTS] =
     { PIN_IO1, PIN_IO2, PIN_IO3, PIN_IO4, PIN_IO5, PIN_IO6, PIN_IO7, PIN_IO8 };
 
-Timeout PWMDisabled;
+DeadlineTimeout PWMDisabled;
+
+RelayArbiter relayArbiter(RELAY_SPACING, RELAY_BUDGET);
+
+StatusCoalescer statusCoalescer(STATUS_WINDOW, STATUS_BUDGET);
+
+AlarmSupervisor alarmSupervisor;
 
 
 
@@ -58,6 +64,23 @@ void Channel::setPWMtoMaxDuty()
     TIMER_PWM.match(MAT2, PWM_DUTY_MAX);  // match MAT2 when the timer reaches this value
 }
 
+/*
+ *  switch on the relays granted by the relayArbiter
+ */
+void Channel::switchRequestedOutputs()
+{
+    unsigned int granted = relayArbiter.process(millis());
+    if (!granted)
+        return;
+    for (unsigned int i = 0; i < NO_OF_OUTPUTS; i++)
+    {
+        if (granted & (1 << i))
+            digitalWrite(outputPins[i], OUTPUT_HIGH);
+    }
+    Channel::setPWMtoMaxDuty();     // set PWM to maximum pulse width so relays can switch
+    PWMDisabled.start(PWM_TIMEOUT); // start timer to reset PWM back to normal pulse width
+}
+
 Channel::Channel(unsigned int number, unsigned int address)
   : shortTime(0)
   , number(number)
@@ -72,7 +95,8 @@ Channel::Channel(unsigned int number, unsigned int address)
   , moveForTime(0)
   , startTime(0)
   , position(0)
-  , startPosition(-1)
+  , positionFine(0)
+  , startPosition(0)
   , targetPosition(-1)
   , savedPosition(-1)
   , handAct_(nullptr)
@@ -120,6 +144,9 @@ Channel::Channel(unsigned int number, unsigned int address)
     obj24Config    = bcu.userEeprom->getUInt8(address + 66);
     oneBitPosition = bcu.userEeprom->getUInt8(address + 67);
 
+    openFactor     = travelFactor(openTime);
+    closeFactor    = travelFactor(closeTime);
+
     if (extMoveTime != 0)
     {
         openTimeExt    = openTime  * extMoveTime / 100;
@@ -263,10 +290,39 @@ void Channel::objectUpdateCh(unsigned int objno)
     }
 }
 
-unsigned int Channel::timeToPercentage(unsigned int startTime, unsigned int maxTime)
+/*
+ * the reciprocal POS_FULL_TRAVEL * 2^32 / maxTime, calculated once so that the position tracking in the main
+ * loop needs no division. Together with the correction in travel() the tracked position is
+ * exactly diff * POS_FULL_TRAVEL / maxTime for every configurable travel time.
+ */
+uint64_t Channel::travelFactor(unsigned int maxTime)
+{
+    if (!maxTime)
+        return 0;
+    return ((uint64_t) POS_FULL_TRAVEL << 32) / maxTime;
+}
+
+/*
+ * the distance travelled in diff ms as fixed point number, at most the full travel
+ */
+unsigned int Channel::travel(unsigned int diff, uint64_t factor, unsigned int maxTime)
+{
+    if (diff >= maxTime)
+        return POS_FULL_TRAVEL;
+    // diff < maxTime, so diff * factor < POS_FULL_TRAVEL * 2^32 can't overflow. As the factor is rounded down,
+    // the result is the exact quotient or one less than it.
+    unsigned int result = (diff * factor) >> 32;
+    if ((uint64_t) (result + 1) * maxTime <= (uint64_t) diff * POS_FULL_TRAVEL)
+        result++;
+    return result;
+}
+
+/*
+ * the distance travelled since startTime as fixed point number, at most the full travel
+ */
+unsigned int Channel::timeToTravel(unsigned int startTime, uint64_t factor, unsigned int maxTime)
 {
-    unsigned int diff = millis() - startTime;
-    return (diff * 256) / maxTime;
+    return travel(millis() - startTime, factor, maxTime);
 }
 
 void Channel::startUp(void)
@@ -296,6 +352,12 @@ void Channel::startDown(void)
 void Channel::stop(void)
 {
     direction = STOP;
+    relayArbiter.release(number * 2 + 0);
+    relayArbiter.release(number * 2 + 1);
+    if (state == WAIT_RELAY)
+    {   // the relay has not been switched on yet
+        state = IDLE;
+    }
     if (state & MOVE)
     {
         switchOutputPin(outputPins[number * 2 + 0], OUTPUT_LOW);
@@ -311,13 +373,13 @@ void Channel::stop(void)
         timeout.start(pauseChangeDir);
         _sendPosition();
         if (features & FEATURE_STATUS_MOVING)
-            bcu.comObjects->objectWrite(firstObjNo + COM_OBJ_VISU_STATUS, (unsigned int) 0);
+            _writeStatus(COM_OBJ_VISU_STATUS, 0);
     }
 }
 
 void Channel::_sendPosition()
 {
-    bcu.comObjects->objectWrite(firstObjNo + COM_OBJ_POSITION, position);
+    _writeStatus(COM_OBJ_POSITION, position);
 }
 
 /*
@@ -346,36 +408,22 @@ bool Channel::delaySwitchingForMs(int ms)
 }
 
 /*
- * use switchOutputPin which will call digitalWrite, so we can track then the output was set to high
+ * switching a relay off is done at once, switching it on has to be requested from the relayArbiter
  */
 void Channel::switchOutputPin(int OutputPin, OutputState state)
 {
-    if (state == OUTPUT_HIGH)
-    {
-        //TODO save requested Outputpin and state, so we can later in UpdateRelayState() set it with digitalWrite
-        digitalWrite(OutputPin,state);
-        Blocking.start(BLOCKING_MS);
-    }
-    else
-    {
-        digitalWrite(OutputPin,state);
-        Blocking.stop();
-    }
+    digitalWrite(OutputPin,state);
 }
 
 /*
- * returns true, while the "cooldown" of an recently high switched OutputPin is blocking other channels from doing the same
+ * returns true, as soon as the relayArbiter has switched on the relay requested for the current direction
  */
-bool Channel::isBlocking()
-{
-    return Blocking.started();
-}
-
 bool Channel::UpdateRelayState()
 {
-    //TODO switch relay according to the requested state from switchOutputPin
-    //digitalWrite(OutputPin,state);
-    return false;
+    unsigned int outNo = number * 2;
+    if (direction == DOWN) outNo++;
+    switchRequestedOutputs();
+    return relayArbiter.isGranted(outNo);
 }
 
 
@@ -407,7 +455,7 @@ void Channel::_handleState(void)
             if (!positionValid)
             {
                 positionValid = true;
-                bcu.comObjects->objectWrite(firstObjNo + COM_OBJ_POS_VALID, 1);
+                _writeStatus(COM_OBJ_POS_VALID, 1);
             }
             targetPosition = -1;
             if (! _restorePosition()) // check if we need to restore a saved position
@@ -423,18 +471,20 @@ void Channel::_handleState(void)
         break;
     default:
     case IDLE:
-        if (direction != STOP)
+        if (direction == STOP)
+            break;
+        relayArbiter.request(number * 2 + (direction == DOWN));
+        state = WAIT_RELAY;
+        // no break, if the supply budget allows it, the relay is switched on at once
+    case WAIT_RELAY:
+        if (UpdateRelayState())
         {
             unsigned int outNo = number * 2;
             if (direction == DOWN) outNo++;
-            switchOutputPin(outputPins[outNo], OUTPUT_HIGH);
             if (features & FEATURE_STATUS_MOVING)
-                bcu.comObjects->objectWrite(firstObjNo + COM_OBJ_VISU_STATUS, 1);
+                _writeStatus(COM_OBJ_VISU_STATUS, 1);
             else
-                bcu.comObjects->objectWrite(firstObjNo + COM_OBJ_VISU_STATUS, (int) (direction == UP ? 0 : 1));
-
-            Channel::setPWMtoMaxDuty();     // set PWM to maximum pulse width so relays can switch
-            PWMDisabled.start(PWM_TIMEOUT); // start timer to reset PWM back to normal pulse width
+                _writeStatus(COM_OBJ_VISU_STATUS, direction == UP ? 0 : 1);
 
 #ifdef HAND_ACTUATION
             if (handAct_ != nullptr)
@@ -453,23 +503,28 @@ bool Channel::_trackPosition(void)
     // position when we stop the motor
     int moveBy;
     if (direction == UP)
-         moveBy = -1 * timeToPercentage(startTime - motorOffDelay, openTime);
-    else moveBy =      timeToPercentage(startTime - motorOffDelay, closeTime);
-    position    = startPosition + moveBy;
+         moveBy = -1 * (int) timeToTravel(startTime - motorOffDelay, openFactor, openTime);
+    else moveBy =      (int) timeToTravel(startTime - motorOffDelay, closeFactor, closeTime);
+    positionFine = startPosition + moveBy;
 
-    if ((position <= 0) && (direction == UP))
+    if ((positionFine <= 0) && (direction == UP))
     {
-        position = 0;
+        positionFine = 0;
         state = EXTEND;
         timeout.start(openTimeExt);
     }
-    if ((position >= 255) && (direction == DOWN))
+    if ((positionFine >= POS_FIXED(255)) && (direction == DOWN))
     {
-        position = 255;
+        positionFine = POS_FIXED(255);
         state = EXTEND;
         timeout.start(openTimeExt);
     }
-    bcu.comObjects->objectSetValue(firstObjNo + COM_OBJ_POSITION, position);
+    short newPosition = POS_ROUND(positionFine);
+    if (newPosition != position)
+    {   // update the status object only if the reported position changes
+        position = newPosition;
+        bcu.comObjects->objectSetValue(firstObjNo + COM_OBJ_POSITION, position);
+    }
     // check if we moved for a requested time
     if (  (   moveForTime
           && (elapsed(startTime) >= moveForTime)
@@ -504,36 +559,70 @@ bool Channel::_trackSlatPosition(void)
 
 void Channel::periodic(void)
 {
-    AlarmConfig * alarm = alarms;
     _handleState();
-    for (unsigned int i = 0; i < NO_OF_ALARMS; i++, alarm++)
+}
+
+/*
+ * called by the application when the alarmSupervisor reports that the
+ * monitoring time of the alarm has expired
+ */
+void Channel::alarmExpired(unsigned int alarmNo)
+{
+    if (alarms[alarmNo].priority & activeAlarms)
+    {   // this alarm is active and has not been sent again within the monitoring time
+        // we tread this alarm as inactive
+        _checkAlarms(alarmNo, 0);
+    }
+}
+
+/*
+ * returns the ms until periodic() has to be called again, NO_DEADLINE if the channel
+ * waits for a command
+ */
+unsigned int Channel::timeToDeadline(void)
+{
+    switch (state)
     {
-        if (  (alarm->priority & activeAlarms)
-           && alarm->monitorTime
-           && alarm->monitor.expired()
-           )
-        {   // this alarm is active, should be monitored and the timeout as expired
-            // we tread this alarm as inactive
-            _checkAlarms(i, 0);
-        }
+    case IDLE:
+        if (direction != STOP)
+            return 0;
+        break;
+    case PROTECT:
+    case DELAY:
+    case EXTEND:
+        return timeout.remaining();
+    default:
+        // the relay request and the position tracking are handled in every loop
+        return 0;
     }
+    // the alarm monitors are handled by the alarmSupervisor
+    return NO_DEADLINE;
 }
 
 void Channel::_updatePosState(unsigned int current, unsigned int mask, unsigned int objno)
 {
-    objno += firstObjNo;
     if ((limits & mask) && !current)
     {
         limits &= ~mask;
-        bcu.comObjects->objectWrite(objno, (unsigned int) 0);
+        _writeStatus(objno, 0);
     }
     if (!(limits & mask) && current)
     {
         limits |= mask;
-        bcu.comObjects->objectWrite(objno, (unsigned int) 1);
+        _writeStatus(objno, 1);
     }
 }
 
+/*
+ * set the value of a status object of this channel, the statusCoalescer sends it later
+ */
+void Channel::_writeStatus(unsigned int objno, unsigned int value)
+{
+    objno += firstObjNo;
+    bcu.comObjects->objectSetValue(objno, value);
+    statusCoalescer.changed(objno, millis());
+}
+
 void Channel::moveTo(short position)
 {
     targetPosition = position;
@@ -689,7 +778,7 @@ void Channel::_savePosition(bool currentPosition)
 
 void Channel::_startTracking(void)
 {
-     startPosition = position;
+     startPosition = positionFine;
      startTime = millis();
 }
 
@@ -737,7 +826,11 @@ void Channel::_checkAlarms(unsigned int alarmNo, unsigned int value)
     if (value && alarm->monitorTime)
     {   // this is sent as active and we have to monitor the timeout ->
         // re-trigger the timeout
-        alarm->monitor.start(alarm->monitorTime * 1000 * 60);
+        alarmSupervisor.start(number * NO_OF_ALARMS + alarmNo, alarm->monitorTime * 1000 * 60, millis());
+    }
+    else if (!value)
+    {   // an inactive alarm needs no monitoring
+        alarmSupervisor.stop(number * NO_OF_ALARMS + alarmNo);
     }
     if (!value && active)
     {   // the alarm was active and should now be disabled
@@ -9,11 +9,15 @@
 #ifndef ROL_JAL_BIM112_SRC_CHANNEL_H_
 #define ROL_JAL_BIM112_SRC_CHANNEL_H_
 
+#include <stdint.h>
 #include <sblib/types.h>
 #include <sblib/timeout.h>
 #include <sblib/timer.h>
 #include <sblib/eibMASK0701.h>
 #include "hand_actuation.h"
+#include "alarm_supervisor.h"
+#include "relay_arbiter.h"
+#include "status_coalescer.h"
 
 #define NO_OF_CHANNELS 4
 #define NO_OF_OUTPUTS  (NO_OF_CHANNELS * 2)
@@ -21,9 +25,35 @@
 #define NO_OF_SCENES    8
 #define NO_OF_ALARMS    4
 
+#define NO_DEADLINE 0xFFFFFFFF // nothing to do until a command is received
+
+/**
+ * A Timeout which can tell how long it will still run, needed to
+ * calculate the next deadline of the channels.
+ */
+class DeadlineTimeout : public Timeout
+{
+public:
+    /**
+     * @return the ms until the timeout expires, 0 if it is not running
+     */
+    unsigned int remaining(void) const;
+};
+
+inline unsigned int DeadlineTimeout::remaining(void) const
+{
+    int diff = timeout - millis();
+    if (stopped() || (diff <= 0))
+        return 0;
+    return diff;
+}
+
 extern MASK0701 bcu;
 extern const int outputPins[NO_OF_OUTPUTS];
-extern Timeout PWMDisabled;
+extern DeadlineTimeout PWMDisabled;
+extern RelayArbiter relayArbiter;
+extern StatusCoalescer statusCoalescer;
+extern AlarmSupervisor alarmSupervisor;
 
 /* old PWM values from rol-jal-bim112
 #define PWM_TIMEOUT 50
@@ -49,7 +79,21 @@ extern Timeout PWMDisabled;
 #define PWM_DUTY 22          // 25% duty
 #define PWM_DUTY_MAX 99      // 99% duty
 
-#define BLOCKING_MS 1000 // ms a channel should block other channels from switching on a relay
+// the relays of all channels are switched on through the relayArbiter
+#define RELAY_SPACING PWM_TIMEOUT // ms between two groups of relays, the PWM is at max duty for this time
+#define RELAY_BUDGET  2           // relays which may be switched on at the same time
+
+// the status objects of all channels are sent through the statusCoalescer:
+// a status telegram leaves up to STATUS_WINDOW ms after the change, more than
+// STATUS_BUDGET pending objects wait one more window for each further group
+#define STATUS_WINDOW 200 // ms the status changes are collected
+#define STATUS_BUDGET 4   // telegrams which may be sent per window
+
+// positions are tracked as fixed point numbers, the full travel (256 steps) needs 30 bits
+#define POS_FRACTION_BITS 22
+#define POS_FULL_TRAVEL   (1U << (8 + POS_FRACTION_BITS))
+#define POS_FIXED(pos)    ((int) (pos) << POS_FRACTION_BITS)
+#define POS_ROUND(fixed)  ((short) (((fixed) + (1 << (POS_FRACTION_BITS - 1))) >> POS_FRACTION_BITS))
 
 
 #define EE_CHANNEL_CFG_SIZE    72
@@ -112,7 +156,6 @@ typedef struct
     unsigned char monitorTime;
     unsigned char engageAction;
     unsigned char releaseAction;
-    Timeout       monitor;
 } AlarmConfig;
 
 class Channel
@@ -122,6 +165,7 @@ class Channel
     {
         IDLE       = 0x00
       , PROTECT    = 0x01
+      , WAIT_RELAY = 0x02 //!< waiting for the relayArbiter to switch on the relay
       // in the following states,the motor is already running
       , MOVE       = 0x80
       , SLAT_MOVE  = 0x81
@@ -145,9 +189,13 @@ class Channel
         OUTPUT_LOW = 0x00, OUTPUT_HIGH = 0x01
     } OutputState;
 
+    static uint64_t travelFactor(unsigned int maxTime);
+    static unsigned int travel(unsigned int diff, uint64_t factor, unsigned int maxTime);
+
     static void initPWM(int PWMPin);
     static void startPWM();
     static void setPWMtoMaxDuty();
+    static void switchRequestedOutputs();
     Channel() = delete;
     Channel(unsigned int number, unsigned int address);
     virtual unsigned int channelType(void);
@@ -156,7 +204,6 @@ class Channel
     bool centralEnabled();
     bool automaticAEnabled();
     bool automaticBEnabled();
-    bool isBlocking();
     unsigned short currentPosition(void);
     virtual void objectUpdateCh(unsigned int objno);
             void startUp(void);
@@ -167,6 +214,8 @@ class Channel
     virtual void switchOutputPin(int OutputPin, OutputState state);
 
     virtual void periodic(void);
+            unsigned int timeToDeadline(void);
+            void alarmExpired(unsigned int alarm);
     virtual void moveTo(short position);
             void moveFor(unsigned int time, unsigned int direction);
             void handleAutomaticFunction(unsigned int pos, unsigned int block, unsigned int value);
@@ -194,8 +243,9 @@ class Channel
     virtual bool _stillInAutoPosition(void);
     virtual void _moveToOneBitPostion();
 
-    unsigned int timeToPercentage(unsigned int startTime, unsigned int maxTime);
+    unsigned int timeToTravel(unsigned int startTime, uint64_t factor, unsigned int maxTime);
     void _updatePosState(unsigned int current, unsigned int mask, unsigned int objno);
+    void _writeStatus(unsigned int objno, unsigned int value);
     void _enableFeature(unsigned int address, unsigned int feature, unsigned int mask = 0xFFFF);
     void handleScene(unsigned int value);
 
@@ -208,6 +258,8 @@ class Channel
     unsigned int   closeTime;                     //!< time the channel needs from fully open   to fully closed
     unsigned int   openTimeExt;                   //!< extension time for the opening direction
     unsigned int   closeTimeExt;                  //!< extension time for the closing direction
+    uint64_t       openFactor;                    //!< reciprocal of the opening time, see travelFactor()
+    uint64_t       closeFactor;                   //!< reciprocal of the closing time, see travelFactor()
     unsigned char  automaticPos[NO_OF_AUTOMATIC]; //!< the 4 automatic positions
     unsigned char  automaticConfig;               //!< configuration of the automatic behavior
     unsigned char  sceneNumber[NO_OF_SCENES];     //!< the 4 automatic positions
@@ -239,11 +291,11 @@ class Channel
     unsigned int   startTime;        //!< start time of a movement (needed for position calculation)
     // track position of shutter/blind
              short position;         //!< current channel position
-             short startPosition;    //!< position when the movement started
+             int   positionFine;     //!< current channel position (fixed point, see POS_FRACTION_BITS)
+             int   startPosition;    //!< position when the movement started (fixed point)
              short targetPosition;   //!< requested target position
              short savedPosition;    //!< position before an automatic commands was triggered
-    Timeout        timeout;
-    Timeout        Blocking;         //!< active while the "cooldown" of an recently high switched OutputPin is blocking other channels from doing the same
+    DeadlineTimeout timeout;
     HandActuation* handAct_;
 };
 
@@ -0,0 +1,82 @@
+/*
+ *  relay_arbiter.cpp - Device wide arbitration of the relays which should be
+ *                      switched on.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "relay_arbiter.h"
+
+RelayArbiter::RelayArbiter(unsigned int spacing, unsigned int budget)
+  : groupStart(0)
+  , groupSize(0)
+  , active(0)
+  , pending(0)
+  , queued(0)
+{
+    setup(spacing, budget);
+}
+
+void RelayArbiter::setup(unsigned int spacing, unsigned int budget)
+{
+    this->spacing = spacing;
+    this->budget  = budget ? budget : 1;
+}
+
+void RelayArbiter::request(unsigned int output)
+{
+    unsigned int mask = 1 << output;
+    if ((output >= MAX_RELAY_OUTPUTS) || ((active | pending) & mask))
+        return;
+    pending        |= mask;
+    queue[queued++] = output;
+}
+
+void RelayArbiter::release(unsigned int output)
+{
+    unsigned int mask = 1 << output;
+    active &= ~mask;
+    if (pending & mask)
+    {
+        unsigned int i, j;
+        for (i = 0, j = 0; i < queued; i++)
+        {
+            if (queue[i] != output)
+                queue[j++] = queue[i];
+        }
+        queued   = j;
+        pending &= ~mask;
+    }
+}
+
+unsigned int RelayArbiter::process(unsigned int now)
+{
+    unsigned int granted = 0;
+    unsigned int i, j;
+
+    if (!queued)
+        return 0;
+    if (groupSize && ((now - groupStart) >= spacing))
+        groupSize = 0; // the relays of the last group have pulled in
+    for (i = 0, j = 0; i < queued; i++)
+    {
+        unsigned int output = queue[i];
+        if (  (groupSize < budget)
+           && !(active & (1 << (output ^ 1)))
+           )
+        {   // switch this relay on, the other relay of the channel is off
+            if (!groupSize)
+                groupStart = now;
+            groupSize++;
+            granted |= 1 << output;
+        }
+        else
+            queue[j++] = output;
+    }
+    queued   = j;
+    pending &= ~granted;
+    active  |=  granted;
+    return granted;
+}
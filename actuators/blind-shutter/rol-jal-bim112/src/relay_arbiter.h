@@ -0,0 +1,90 @@
+/*
+ *  relay_arbiter.h - Device wide arbitration of the relays which should be
+ *                    switched on.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef ROL_JAL_BIM112_SRC_RELAY_ARBITER_H_
+#define ROL_JAL_BIM112_SRC_RELAY_ARBITER_H_
+
+#define MAX_RELAY_OUTPUTS 16 //!< enough for the 8-fold version of the actuator
+
+/**
+ * All channels share the relay supply. Pulling in a relay needs the PWM at
+ * maximum duty and each motor start adds its inrush current, so switching on
+ * the relays of all channels at the same moment (e.g. for a central command)
+ * overloads the supply.
+ *
+ * The channels therefore only request a relay. The arbiter grants the queued
+ * requests in the order they arrived: at most "budget" relays are switched on
+ * within "spacing" ms, the next group follows after the spacing has elapsed.
+ * Switching a relay off never needs the arbiter.
+ *
+ * The outputs are numbered like outputPins[]: output channel * 2 is the up
+ * relay, channel * 2 + 1 the down relay of the channel. The arbiter never
+ * grants an output while the other relay of the same channel is on.
+ */
+class RelayArbiter
+{
+public:
+    RelayArbiter(unsigned int spacing, unsigned int budget);
+
+    /**
+     * Change the minimum time in ms between two groups of relays and the
+     * number of relays which may be switched on within one group.
+     */
+    void setup(unsigned int spacing, unsigned int budget);
+
+    /**
+     * Queue a request to switch on the output. Requesting an output which is
+     * already pending or on has no effect.
+     */
+    void request(unsigned int output);
+
+    /**
+     * The output has been switched off or the request is no longer needed.
+     */
+    void release(unsigned int output);
+
+    /**
+     * Grant as many pending requests as the budget allows.
+     *
+     * @param now the current time in ms (millis())
+     * @return bitmask of the outputs which have to be switched on now
+     */
+    unsigned int process(unsigned int now);
+
+    bool isGranted(unsigned int output) const;
+    bool isPending(unsigned int output) const;
+    unsigned int pendingRequests(void) const;
+
+protected:
+    unsigned int  spacing;      //!< min. time between two groups of relays
+    unsigned int  budget;       //!< relays which may be switched on within one group
+    unsigned int  groupStart;   //!< time the current group was started
+    unsigned int  groupSize;    //!< relays already switched on in the current group
+    unsigned int  active;       //!< bitmask of the granted outputs
+    unsigned int  pending;      //!< bitmask of the queued outputs
+    unsigned char queue[MAX_RELAY_OUTPUTS]; //!< queued outputs in request order
+    unsigned int  queued;       //!< number of entries in the queue
+};
+
+inline bool RelayArbiter::isGranted(unsigned int output) const
+{
+    return active & (1 << output);
+}
+
+inline bool RelayArbiter::isPending(unsigned int output) const
+{
+    return pending & (1 << output);
+}
+
+inline unsigned int RelayArbiter::pendingRequests(void) const
+{
+    return queued;
+}
+
+#endif /* ROL_JAL_BIM112_SRC_RELAY_ARBITER_H_ */
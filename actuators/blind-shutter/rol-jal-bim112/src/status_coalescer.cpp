@@ -0,0 +1,73 @@
+/*
+ *  status_coalescer.cpp - Device wide coalescing of the status telegrams of
+ *                         the channels.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "status_coalescer.h"
+
+StatusCoalescer::StatusCoalescer(unsigned int window, unsigned int budget)
+  : windowStart(0)
+  , sentInWindow(0)
+  , queued(0)
+  , changeCount(0)
+  , sentCount(0)
+{
+    setup(window, budget);
+}
+
+void StatusCoalescer::setup(unsigned int window, unsigned int budget)
+{
+    this->window = window;
+    this->budget = budget ? budget : 1;
+}
+
+void StatusCoalescer::changed(unsigned int objno, unsigned int now)
+{
+    changeCount++;
+    for (unsigned int i = 0; i < queued; i++)
+    {
+        if (queue[i] == objno)
+            return; // already pending, the newest value will be sent
+    }
+    if (queued >= MAX_STATUS_PENDING)
+        return;
+    if (!queued)
+    {   // the first change opens a new window
+        windowStart  = now;
+        sentInWindow = 0;
+    }
+    queue[queued++] = objno;
+}
+
+int StatusCoalescer::nextDue(unsigned int now)
+{
+    if (!queued || ((now - windowStart) < window))
+        return -1;
+    if (sentInWindow >= budget)
+    {   // the budget of this window is used up, send the rest in the next one
+        windowStart  = now;
+        sentInWindow = 0;
+        return -1;
+    }
+    int objno = queue[0];
+    queued--;
+    for (unsigned int i = 0; i < queued; i++)
+        queue[i] = queue[i + 1];
+    sentInWindow++;
+    sentCount++;
+    return objno;
+}
+
+unsigned int StatusCoalescer::timeToDeadline(unsigned int now) const
+{
+    unsigned int passed = now - windowStart;
+    if (!queued)
+        return 0xFFFFFFFF;
+    if (passed >= window)
+        return 0;
+    return window - passed;
+}
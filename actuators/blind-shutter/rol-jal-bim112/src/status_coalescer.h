@@ -0,0 +1,94 @@
+/*
+ *  status_coalescer.h - Device wide coalescing of the status telegrams of
+ *                       the channels.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef ROL_JAL_BIM112_SRC_STATUS_COALESCER_H_
+#define ROL_JAL_BIM112_SRC_STATUS_COALESCER_H_
+
+#define MAX_STATUS_PENDING 48 //!< 8 channels with 6 status objects each
+
+/**
+ * A central, scene or alarm command moves all channels at once and each
+ * channel sends its moving status, position, slat position and limit
+ * objects, some of them several times during one movement.
+ *
+ * The channels therefore only set the new value of a status object and
+ * report the change here. The coalescer collects the changed objects for
+ * "window" ms and then sends them in the order of their first change. An
+ * object which changes again while it is pending is sent only once, with
+ * its newest value. At most "budget" telegrams are sent per window, the
+ * rest waits for the next window.
+ *
+ * This adds latency to every status telegram: the first change after a
+ * quiet period is sent "window" ms later, not at once. With n pending
+ * objects the last one waits up to window * ((n + budget - 1) / budget) ms,
+ * for all 48 status objects of the device 12 windows.
+ */
+class StatusCoalescer
+{
+public:
+    StatusCoalescer(unsigned int window, unsigned int budget);
+
+    /**
+     * Change the collection window in ms and the number of telegrams which
+     * may be sent per window.
+     */
+    void setup(unsigned int window, unsigned int budget);
+
+    /**
+     * The value of the object has been changed and has to be sent.
+     *
+     * @param objno the number of the com object
+     * @param now the current time in ms (millis())
+     */
+    void changed(unsigned int objno, unsigned int now);
+
+    /**
+     * @param now the current time in ms (millis())
+     * @return the next object which has to be sent now, -1 if none
+     */
+    int nextDue(unsigned int now);
+
+    /**
+     * @param now the current time in ms (millis())
+     * @return the ms until nextDue() will return an object, 0xFFFFFFFF if
+     *         nothing is pending
+     */
+    unsigned int timeToDeadline(unsigned int now) const;
+
+    unsigned int pendingObjects(void) const;
+    unsigned int changes(void) const;
+    unsigned int telegrams(void) const;
+
+protected:
+    unsigned int  window;       //!< time the changes are collected
+    unsigned int  budget;       //!< telegrams which may be sent per window
+    unsigned int  windowStart;  //!< start of the current window
+    unsigned int  sentInWindow; //!< telegrams sent at the end of the current window
+    unsigned char queue[MAX_STATUS_PENDING]; //!< pending objects in the order of their first change
+    unsigned int  queued;       //!< number of entries in the queue
+    unsigned int  changeCount;  //!< statistics: reported changes
+    unsigned int  sentCount;    //!< statistics: sent telegrams
+};
+
+inline unsigned int StatusCoalescer::pendingObjects(void) const
+{
+    return queued;
+}
+
+inline unsigned int StatusCoalescer::changes(void) const
+{
+    return changeCount;
+}
+
+inline unsigned int StatusCoalescer::telegrams(void) const
+{
+    return sentCount;
+}
+
+#endif /* ROL_JAL_BIM112_SRC_STATUS_COALESCER_H_ */
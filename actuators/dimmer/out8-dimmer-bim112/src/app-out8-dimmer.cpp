@@ -15,6 +15,8 @@
 #include <sblib/eibMASK0701.h>
 #include <sblib/digital_pin.h>
 #include <sblib/io_pin_names.h>
+#include <sblib/interrupt.h>
+#include <sblib/timer.h>
 #include "hand_actuation.h"
 
 HandActuation* handAct = new HandActuation(&handPins[0], NO_OF_HAND_PINS, READBACK_PIN, BLINK_TIME);
@@ -22,52 +24,49 @@ Channel * channels[NO_OF_CHANNELS];
 
 void objectUpdated(int objno)
 {
-    const uint8_t firstChannelObjectNumber = 10;
-    const uint8_t channelObjectCount = 24;
-
-    ///\todo fill with life, below is mostly c&p from somewhere
-    if (objno >= firstChannelObjectNumber)
+    if (objno >= FIRST_CHANNEL_OBJ_NO)
     {   // handle the com objects specific to one channel
-        unsigned int channel = (objno - firstChannelObjectNumber) / channelObjectCount;
+        unsigned int channel = (objno - FIRST_CHANNEL_OBJ_NO) / OBJS_PER_CHANNEL;
+        if (channel >= NO_OF_CHANNELS)
+            return;
         Channel * chn = channels [channel];
         if (chn)
             chn->objectUpdateCh(objno);
     }
-    else
-    {   // handle global objects
-        unsigned char value = bcu.comObjects->objectRead(objno);
-        for (unsigned int i = 0; i < NO_OF_CHANNELS; i++)
-        {   Channel * chn = channels [i];
-            if (chn && (objno <= 4) && chn->centralEnabled())
-            {
-                switch (objno)
-                {
-                }
-            }
-            else if (chn && (objno >= 5) && (objno <= 12))
-            {
-                if (objno < 9)
-                    chn->handleAutomaticFunction(objno - 5, 0, value);
-                else
-                    chn->handleAutomaticFunction(objno - 9, 1, value);
-            }
-        }
-    }
 }
 
-void checkPeriodicFuntions(void)
+/*
+ * write the state of the channels to the outputs, called from the frame interrupt
+ * for the channels whose brightness has changed. The outputs of this board are
+ * the relays, they switch the load on as long as the brightness is not 0. The
+ * brightness itself is only reported with the status objects, the board has no
+ * control outputs (1-10 V) like the emulated SD/S 8.16.1.
+ */
+static void updateOutputs(unsigned int changed)
 {
     for (unsigned int i = 0; i < NO_OF_CHANNELS; i++)
     {
-        Channel * chn = channels[i];
-        if (chn)
-            chn->periodic();
+        if (changed & (1 << i))
+            digitalWrite(outputPins[i], dimmingEngine.brightness(i) != 0);
     }
+}
 
-    if (PWMDisabled.started () && PWMDisabled.expired())
+extern "C" void TIMER32_0_IRQHandler(void)
+{
+    unsigned int changed = dimmingEngine.frame();
+    if (changed)
+        updateOutputs(changed);
+    timer32_0.resetFlags();
+}
+
+void checkPeriodicFuntions(void)
+{
+    unsigned int finished = dimmingEngine.finishedRamps();
+    for (unsigned int i = 0; finished; i++, finished >>= 1)
     {
-        // re-enable the PWM
-        timer16_0.match(MAT2, PWM_DUTY_33);
+        Channel * chn = channels[i];
+        if (chn && (finished & 0x01))
+            chn->rampFinished();
     }
 }
 
@@ -88,14 +87,17 @@ void initApplication(void)
         digitalWrite(outputPins[i], 0);
         pinMode(outputPins[i], OUTPUT);
     }
+    address += EE_GLOBAL_CFG_SIZE;
     for (unsigned int i = 0; i < NO_OF_CHANNELS; i++, address += EE_CHANNEL_CFG_SIZE)
     {
-        switch (bcu.userEeprom->getUInt8(address))
-        {
-//        case 0: channels [i] = new Blind(i, address); break;
-//        case 1: channels [i] = new Shutter(i, address); break;
-        default :
-            channels [i] = 0;
-        }
+        channels [i] = new Channel(i, address);
     }
+
+    // advance the dimming ramps with DIM_FRAME_RATE
+    enableInterrupt(TIMER_32_0_IRQn);
+    timer32_0.begin();
+    timer32_0.prescaler((SystemCoreClock / 100000) - 1);
+    timer32_0.matchMode(MAT0, RESET | INTERRUPT);
+    timer32_0.match(MAT0, 100000 / DIM_FRAME_RATE - 1);
+    timer32_0.start();
 }
@@ -21,6 +21,13 @@ typedef struct
 
 extern const HardwareVersion * currentVersion;
 
+/*
+ * unit of the 16 bit ramp and dimming times P_EinschaltDimmrampe, P_AusschaltDimmrampe,
+ * P_relDimmenDimmzeit and P_WertDimmZeit in ms. The unit is given by the parameter types
+ * of these parameters in the product database of the SD/S 8.16.1 (see README.md).
+ */
+#define EE_TIME_BASE 100
+
 
 /*
  *  hand actuation pin configuration
@@ -80,13 +87,13 @@ const unsigned int handPins[NO_OF_HAND_PINS] = { PIN_LT1, PIN_LT2, PIN_LT3, PIN_
  ...
  27200/0x0040: P_Zusatzfunktion
  ...
- 27203/0x0043: P_EinschaltDimmrampe (16bit)
+ 27203/0x0043: P_EinschaltDimmrampe (16bit, EE_TIME_BASE)
  ...
- 27205/0x0045: P_AusschaltDimmrampe (16bit)
+ 27205/0x0045: P_AusschaltDimmrampe (16bit, EE_TIME_BASE)
  ...
- 27207/0x0047: P_relDimmenDimmzeit (16bit)
+ 27207/0x0047: P_relDimmenDimmzeit (16bit, EE_TIME_BASE)
  ...
- 27209/0x0049: P_WertDimmZeit (16bit)
+ 27209/0x0049: P_WertDimmZeit (16bit, EE_TIME_BASE)
  ...
  27217/0x0051: P_Rueckmeldung
  27218/0x0052: P_RueckmInv
@@ -0,0 +1,118 @@
+/*
+ *  dimming_engine.cpp - Brightness ramps of the dimmer channels, advanced from
+ *                       a timer interrupt.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "dimming_engine.h"
+#include <sblib/interrupt.h>
+
+DimmingEngine::DimmingEngine()
+  : ramping(0)
+  , finished(0)
+{
+    for (unsigned int i = 0; i < MAX_DIM_CHANNELS; i++)
+    {
+        level[i]       = 0;
+        targetLevel[i] = 0;
+        step[i]        = 0;
+    }
+}
+
+void DimmingEngine::_start(unsigned int channel, unsigned int target, unsigned int step)
+{
+    unsigned int mask = 1 << channel;
+    if (!step)
+        step = 1; // the ramp has to end even if the level has changed in the meantime
+    // the interrupt must not see the new target with the old step
+    noInterrupts();
+    targetLevel[channel] = DIM_FIXED(target);
+    this->step[channel]  = step;
+    finished &= ~mask;
+    ramping  |=  mask;
+    interrupts();
+}
+
+void DimmingEngine::rampTo(unsigned int channel, unsigned int target, unsigned int time)
+{
+    if (channel >= MAX_DIM_CHANNELS)
+        return;
+
+    unsigned int frames = (time + DIM_FRAME_MS / 2) / DIM_FRAME_MS;
+    unsigned int from   = level[channel];
+    unsigned int to     = DIM_FIXED(target);
+    unsigned int diff   = from > to ? from - to : to - from;
+    // round the step up, the ramp must not take longer than requested
+    _start(channel, target, frames ? (diff + frames - 1) / frames : diff);
+}
+
+void DimmingEngine::dimTo(unsigned int channel, unsigned int target, unsigned int fullTime)
+{
+    if (channel >= MAX_DIM_CHANNELS)
+        return;
+
+    unsigned int frames = fullTime / DIM_FRAME_MS;
+    _start(channel, target, frames ? (DIM_FIXED(255) + frames - 1) / frames : DIM_FIXED(255));
+}
+
+void DimmingEngine::stop(unsigned int channel)
+{
+    unsigned int mask = 1 << channel;
+    noInterrupts();
+    if (ramping & mask)
+    {   // stay at the whole brightness value which is reported in the status
+        level[channel]       = DIM_FIXED(DIM_ROUND(level[channel]));
+        targetLevel[channel] = level[channel];
+        ramping  &= ~mask;
+        finished |=  mask;
+    }
+    interrupts();
+}
+
+unsigned int DimmingEngine::frame(void)
+{
+    unsigned int active  = ramping;
+    unsigned int changed = 0;
+    unsigned int mask    = 1;
+
+    for (unsigned int ch = 0; active >= mask; ch++, mask <<= 1)
+    {
+        if (!(active & mask))
+            continue;
+        unsigned int current = level[ch];
+        unsigned int to      = targetLevel[ch];
+        unsigned int before  = DIM_ROUND(current);
+        if (current < to)
+        {   // level and target are below 2^24, the addition cannot overflow
+            current += step[ch];
+            if (current > to)
+                current = to;
+        }
+        else if ((current - to) > step[ch])
+            current -= step[ch];
+        else
+            current  = to;
+        level[ch] = current;
+        if (current == to)
+        {
+            ramping  &= ~mask;
+            finished |=  mask;
+        }
+        if (DIM_ROUND(current) != before)
+            changed |= mask;
+    }
+    return changed;
+}
+
+unsigned int DimmingEngine::finishedRamps(void)
+{
+    unsigned int result;
+    noInterrupts();
+    result   = finished;
+    finished = 0;
+    interrupts();
+    return result;
+}
@@ -0,0 +1,116 @@
+/*
+ *  dimming_engine.h - Brightness ramps of the dimmer channels, advanced from
+ *                     a timer interrupt.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef OUT8_DIMMER_BIM112_SRC_DIMMING_ENGINE_H_
+#define OUT8_DIMMER_BIM112_SRC_DIMMING_ENGINE_H_
+
+#define MAX_DIM_CHANNELS 8
+#define DIM_FRAME_RATE   100 //!< frames per second, frame() is called at this rate
+#define DIM_FRAME_MS     (1000 / DIM_FRAME_RATE)
+
+// the brightness is tracked as fixed point number, 0..255 with 16 fraction bits
+#define DIM_FRACTION_BITS 16
+#define DIM_FIXED(value)  ((unsigned int) (value) << DIM_FRACTION_BITS)
+#define DIM_ROUND(fixed)  (((fixed) + (1 << (DIM_FRACTION_BITS - 1))) >> DIM_FRACTION_BITS)
+
+/**
+ * Each channel has a brightness, a target brightness and a step which is
+ * added (or subtracted) once per frame until the target is reached. The
+ * main loop only starts and stops the ramps, frame() is called from the
+ * timer interrupt and does nothing but the additions. The end of a ramp is
+ * reported back to the main loop through finishedRamps(), which is the
+ * moment the status objects of the channel are sent.
+ *
+ * Only the ramps of the channels which are dimming are advanced, a frame
+ * with all 8 channels ramping costs 8 additions and comparisons.
+ */
+class DimmingEngine
+{
+public:
+    DimmingEngine();
+
+    /**
+     * Ramp the brightness of the channel to the target within the given
+     * time (soft on/off, scenes). The time is rounded to whole frames,
+     * 0 sets the brightness at the next frame.
+     *
+     * @param channel the channel
+     * @param target the target brightness 0..255
+     * @param time the duration of the ramp in ms
+     */
+    void rampTo(unsigned int channel, unsigned int target, unsigned int time);
+
+    /**
+     * Dim the channel towards the target with the speed of a ramp which
+     * takes fullTime ms from 0 to 255 (relative dimming, brightness value).
+     *
+     * @param channel the channel
+     * @param target the target brightness 0..255
+     * @param fullTime the time for the full range in ms
+     */
+    void dimTo(unsigned int channel, unsigned int target, unsigned int fullTime);
+
+    /**
+     * Stop the ramp of the channel at the current brightness, the end of
+     * the ramp is reported like a reached target.
+     */
+    void stop(unsigned int channel);
+
+    /**
+     * Advance the ramps of all channels by one frame, called from the
+     * timer interrupt.
+     *
+     * @return bitmask of the channels whose brightness has changed
+     */
+    unsigned int frame(void);
+
+    /**
+     * @return bitmask of the channels whose ramp has ended since the last
+     *         call, the bits are cleared
+     */
+    unsigned int finishedRamps(void);
+
+    /**
+     * @return the current brightness of the channel, 0..255
+     */
+    unsigned int brightness(unsigned int channel) const;
+
+    /**
+     * @return the brightness the channel is ramping to, 0..255
+     */
+    unsigned int target(unsigned int channel) const;
+
+    bool isRamping(unsigned int channel) const;
+
+protected:
+    void _start(unsigned int channel, unsigned int target, unsigned int step);
+
+    volatile unsigned int level[MAX_DIM_CHANNELS]; //!< current brightness (fixed point)
+    unsigned int  targetLevel[MAX_DIM_CHANNELS];   //!< target brightness (fixed point)
+    unsigned int  step[MAX_DIM_CHANNELS];          //!< change of the brightness per frame (fixed point)
+    volatile unsigned int ramping;                 //!< bitmask of the channels which are dimming
+    volatile unsigned int finished;                //!< bitmask of the channels whose ramp has ended
+};
+
+inline unsigned int DimmingEngine::brightness(unsigned int channel) const
+{
+    return DIM_ROUND(level[channel]);
+}
+
+inline unsigned int DimmingEngine::target(unsigned int channel) const
+{
+    return DIM_ROUND(targetLevel[channel]);
+}
+
+inline bool DimmingEngine::isRamping(unsigned int channel) const
+{
+    return ramping & (1 << channel);
+}
+
+#endif /* OUT8_DIMMER_BIM112_SRC_DIMMING_ENGINE_H_ */
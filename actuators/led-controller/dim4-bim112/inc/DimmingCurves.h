@@ -8,6 +8,26 @@
 #ifndef DIMMINGCURVES_H_
 #define DIMMINGCURVES_H_
 
+/* Die Dimmkurven werden nicht mehr bei jedem Dimmschritt berechnet, sondern nach dem Start
+ * (bzw. nach dem Parameter-Download) einmal pro Kanal als Tabelle abgelegt.
+ * Die Tabelle überdeckt nur den Bereich Minimal- bis Maximalhelligkeit des Kanals in
+ * DIMMING_CURVE_STEPS gleich großen Schritten, zwischen zwei Stützstellen wird linear interpoliert.
+ * Ein Dimmschritt braucht so weder float noch Division noch EEPROM-Zugriffe.
+ */
+#define DIMMING_CURVE_BITS	8
+#define DIMMING_CURVE_STEPS	(1 << DIMMING_CURVE_BITS)	// 256 Schritte, 257 Stützstellen = 514 Byte RAM pro Kanal
+#define DIMMING_CURVE_FRACTION_BITS	(31 - DIMMING_CURVE_BITS)	// Nachkommastellen der Tabellenposition
+
+/* -Berechnet die Tabellen der 4 Kanäle aus den Parametern Dimmkurve, Minimal- und Maximalhelligkeit
+ * -muss vor dem ersten setOutput() aufgerufen werden
+ */
+void initDimmingCurves(void);
+
+/* -Erhält den aktuellen Dimmwert im Format 0-MAXOUTPUTVALUE und den Kanal 0-3
+ * -liefert das Tastverhältnis 0-PWM_DUTY_MAX nach der param. Dimmkurve (Tabelle), die Auflösung
+ *  ist feiner als die des Dimmwerts, damit die unteren Stufen der Kurven nicht zusammenfallen
+ */
+int dimmingCurveValue(int ch, int value);
 
 /* -Erhält den aktuellen Dimmwert im Format 0-MAXOUTPUTVALUE und den Kanal 0-3
  * -rechnet den Wert anhand der param. Dimmkurve um
@@ -15,12 +15,6 @@ class Timefunctions {
 public:
 	void init(int ch);
 
-	/* -wird periodisch aufgerufen
-	 * -prüft ob Zeit abgelaufen ist
-	 * -setzt TimeFctState und führt Dimmbefehl aus
-	 */
-	void checkTimeout();
-
 	void objSwitch(int objVal);
 	void objStairs(int objVal);
 
@@ -29,7 +23,16 @@ class Timefunctions {
 	int TimeFctState = Idle;
 	int channel;
 	int dimmValue;				// Wert auf den nach Ablauf des Timers gedimmt wird
-	Timeout timeout;
+
+	/* -startet den Eintrag des Kanals in der gemeinsamen TimerQueue, Zeit in Sekunden
+	 */
+	void startTimer(unsigned int seconds);
+
+	/* -Callback der TimerQueue, wird nur bei Ablauf der Zeit aufgerufen
+	 * -setzt TimeFctState und führt Dimmbefehl aus
+	 */
+	static void timeout(void * context);
+	void expired();
 
 	/* -dimmt mit ausschaltgeschw. auf 0
 	 * -setzt TimeFctState = Idle
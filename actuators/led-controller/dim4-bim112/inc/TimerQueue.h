@@ -0,0 +1,52 @@
+/*
+ * TimerQueue.h
+ *
+ *      -gemeinsame Zeitsteuerung für die Zeitfunktionen (Treppenlicht, Ein- und Ausschaltverzögerung) aller Kanäle
+ *      -die Einträge sind nach ihrem Ablaufzeitpunkt sortiert verkettet, run() vergleicht solange nichts abläuft
+ *      nur den ersten Eintrag mit der aktuellen Zeit. Abgelaufene Einträge werden entfernt, danach wird ihr
+ *      Callback aufgerufen, der den Eintrag wieder starten darf.
+ *      -Zeitpunkte werden über die Differenz (int)(a - b) verglichen und sind damit auch über den Überlauf von
+ *      millis() nach 49 Tagen richtig, solange eine Verzögerung kleiner als 2^31 ms (24 Tage) ist
+ */
+
+#ifndef TIMERQUEUE_H_
+#define TIMERQUEUE_H_
+
+#define TIMER_QUEUE_SIZE 4		// ein Eintrag je Kanal
+
+typedef void (*TimerCallback)(void * context);
+
+class TimerQueue {
+public:
+	TimerQueue();
+
+	/* -startet den Eintrag id neu, ein laufender Eintrag wird vorher entfernt
+	 * -der Callback wird von run() aufgerufen, sobald delay ms seit now vergangen sind
+	 */
+	void start(int id, unsigned int delay, unsigned int now, TimerCallback callback, void * context);
+
+	void stop(int id);
+	bool isRunning(int id) const;
+
+	/* -wird periodisch mit millis() aufgerufen
+	 * -ruft die Callbacks aller abgelaufenen Einträge in der Reihenfolge ihrer Ablaufzeitpunkte auf
+	 */
+	void run(unsigned int now);
+
+private:
+	struct Entry {
+		unsigned int deadline;		// Ablaufzeitpunkt in millis()
+		TimerCallback callback;
+		void * context;
+		signed char next;			// nächster Eintrag der Warteschlange, -1 am Ende
+		bool running;
+	};
+	Entry entries[TIMER_QUEUE_SIZE];
+	signed char first;				// Eintrag mit dem frühesten Ablaufzeitpunkt, -1 wenn nichts läuft
+};
+
+inline bool TimerQueue::isRunning(int id) const {
+	return entries[id].running;
+}
+
+#endif /* TIMERQUEUE_H_ */
@@ -9,6 +9,11 @@
  *      über die Umrechnungsfunktion HSV zu RGB
  *      -Dimmgeschwindigkeit=0 --> Wert wird direkt eingestellt
  *      -Eingang Helligkeit 0-255; Ausgang 0-MAXOUTPUTVALUE
+ *      -der Dimmwert wird pro ms Systemzeit um einen festen Schritt weitergezählt (DDA wie bei Bresenham),
+ *      die Division zur Berechnung des Schritts erfolgt nur einmal bei Dimmbeginn. Nach genau
+ *      dimTicks Schritten ist der Zielwert exakt erreicht.
+ *      -mehrere Kanäle mit gleicher Dauer und gleicher Startzeit (fadeTo) beginnen und enden im
+ *      selben Schritt, z.B. bei Farbwechseln
  */
 
 #ifndef DIMMING_H_
@@ -22,6 +27,9 @@ class dimming {
 	void init(int ch);
 	void checkperiodic();
 	void start(int destination, int speed);		// Zielhelligkeit byte 0-255 = 0-100%, Dimmgeschwindigkeit in s
+	void fadeTo(int destination, unsigned int duration, unsigned int startTime);	// Zielhelligkeit 0-255 in duration ms ab startTime (Systemzeit in ms)
+	unsigned int dimTime(int destination, int speed);	// Dauer in ms von der momentanen zur Zielhelligkeit 0-255 bei Dimmgeschwindigkeit in s
+	void follow(int value);		// Zwischenwert 0-255 eines extern berechneten Verlaufs (Farbverlauf im HSV-Raum), Ende und Ziel bestimmt weiter die Rampe
 	void stop();				// Auf- Abdimmen wird angehalten
 	int getactualdimvalue();
 	int getlastdimvalue();		// letzter Ziel-Dimmwert >0 zur Verwendung beim nächsten Einschalten wenn parametriert
@@ -35,11 +43,17 @@ class dimming {
 	bool isDimming = false;		// true wenn gerade auf oder abgedimmt wird, false wenn zielhelligkeit erreicht
 	bool isOnOneCycle = true;	// genau 1 mal true wenn der Kanal seit dem letzten Aufruf eingeschaltet wurde
 	bool isOffOneCycle = true;	// genau 1 mal true wenn der Kanal seit dem letzten Aufruf ausgeschaltet wurde
-	unsigned int dimStartTime;	// Systemzeit in ms zu Dimmbeginn
-	float dimStartValue;		// Helligkeit zu Dimmbeginn 0-MAXOUTPUTVALUE
-	float dimDestinationValue;	// Zielhelligkeit 0-MAXOUTPUTVALUE
-	unsigned int dimSpeed;		// Dimmgeschwindigkeit 0-100% in ms
-	float actualDimValue = 0;	// momentaner Dimmwert 0-MAXOUTPUTVALUE
+	unsigned int lastTick;		// Systemzeit in ms des letzten Dimmschritts
+	int dimDestinationValue;	// Zielhelligkeit 0-MAXOUTPUTVALUE
+	int dimStep;				// ganzzahliger Anteil der Änderung pro Schritt (mit Vorzeichen)
+	int dimDirection;			// +1 aufdimmen, -1 abdimmen
+	unsigned int dimRemainder;	// Rest der Änderung pro Schritt in 1/dimTicks
+	unsigned int dimError;		// aufsummierter Rest, bei >= dimTicks wird 1 zusätzlich geändert
+	unsigned int dimTicks;		// Anzahl der Schritte der Dimmrampe
+	unsigned int ticksLeft;		// verbleibende Schritte bis zum Ziel
+	int actualDimValue = 0;		// momentaner Dimmwert 0-MAXOUTPUTVALUE
+	void step();				// ein Dimmschritt
+	static int toOutputValue(int value);	// Helligkeit 0-255 in 0-MAXOUTPUTVALUE
 	unsigned int lastDimValue = 255; // lezter Ziel-Dimmwert 1-255 (nach Reset 255)
 };
 
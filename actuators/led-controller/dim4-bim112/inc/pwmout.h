@@ -8,20 +8,56 @@
 #ifndef PWMOUT_H_
 #define PWMOUT_H_
 
+#include <sblib/timer.h>
+
 #define PWM_MAX_1000  16000	//  Timer Überlauf für 1kHz PWM Frequenz
 #define PWM_MAX_600   26665	//  Timer Überlauf für 600Hz PWM Frequenz
 #define PRESCALER 2			//  für PWM Timer
 
+#define PWM_DUTY_BITS 16
+#define PWM_DUTY_MAX  ((1 << PWM_DUTY_BITS) - 1)	// setpwm() 0-PWM_DUTY_MAX = 0% - 100%
 
-
+/* Zeitliches Dithering (Sigma-Delta):
+ * Das Tastverhältnis wird mit 16 Nachkommabits in Timer-Takten gespeichert. In jeder PWM-Periode (MAT3 Interrupt)
+ * wird der Nachkommaanteil aufaddiert, beim Überlauf ist die Periode einen Takt länger. Im Mittel über mehrere
+ * Perioden ergibt sich so auch bei kleinen Helligkeiten eine Auflösung von 16 Bit statt pwmmax Stufen.
+ *
+ * Synchrone Übernahme (Schattenregister):
+ * setpwm() bereitet den Wert nur im inaktiven Satz dutyFixed[activeBank ^ 1] vor. update() schaltet nach dem
+ * Rampenschritt aller Kanäle mit einem einzigen Schreibzugriff auf activeBank um, beide Timer übernehmen den
+ * neuen Satz damit am selben Periodenende. Ein Farbwechsel erscheint so nie halb übernommen an den Ausgängen.
+ */
 class pwmout{
 public:
 	void begin(int ch);
-	void setpwm(int value);  // 0-10000 = 0% - 100%
+	void setpwm(unsigned int value);  // 0-PWM_DUTY_MAX = 0% - 100%
+	void period();					// neue PWM-Periode, nur aus dem MAT3 Interrupt des Timers aufrufen
+	static void update();			// alle mit setpwm() vorbereiteten Werte gemeinsam übernehmen
+	static void synchronize();		// Perioden der beiden Timer gleichzeitig starten, nach begin() aller Kanäle
 protected:
 	int channel;
 	int pwmmax;
 	bool isactive = false;
+	Timer * timer = 0;				// Timer des Ausgangs, 0 wenn der Ausgang nicht verwendet wird
+	TimerMatch matchChannel;		// Match-Register des Ausgangs
+	unsigned int dutyFixed[2] = {0, 0};	// Einschaltdauer in Timer-Takten mit 16 Nachkommabits, aktiver und vorbereiteter Satz
+	unsigned int accumulator = 0;	// aufsummierte Nachkommaanteile, < 0x10000
+	static volatile unsigned int activeBank;	// Satz von dutyFixed, den die Interrupts ausgeben
+	static bool staged;				// seit dem letzten update() wurde ein Wert vorbereitet
 };
 
+inline void pwmout::period() {
+	if (!timer) {
+		return;
+	}
+	unsigned int fixed = dutyFixed[activeBank];
+	unsigned int count = fixed >> 16;
+	accumulator += fixed & 0xFFFF;
+	if (accumulator & 0x10000) {
+		accumulator &= 0xFFFF;
+		count++;
+	}
+	timer->match(matchChannel, pwmmax - count);
+}
+
 #endif /* PWMOUT_H_ */
@@ -7,15 +7,17 @@
  *  published by the Free Software Foundation.
  */
 
-#include "convert_hsv_rgb.h" // includes <math.h> so it needs to be included before sblib's math.h
 #include <Appl.h>
 #include <sblib/timeout.h>
 #include <com_objs.h>
 #include <config.h>
 #include "pwmout.h"
 #include "dimming.h"
+#include "DimmingCurves.h"
 #include "Timefunctions.h"
+#include "TimerQueue.h"
 #include "Relay.h"
+#include "color.h"
 #ifdef DEBUG
 #   include <sblib/serial.h>  //debugging only
 #endif
@@ -28,8 +30,17 @@ pwmout pwmout[4];
 
 dimming dimming[4];
 Timefunctions timefunctions[4];
+TimerQueue timerQueue;			// Zeitpunkte der Zeitfunktionen aller Kanäle
 Relay relay;
 
+// Die aktuellen RGB/HSV Werte werden normalerweise aus den aktuellen Ausgangswerten berechnet. Dies ist für den Farbwert nicht immer möglich.
+// In diesem Fall wird der letzte gespeicherte Farbwert aus dieser Variable genutzt
+static unsigned char storedHueValue = 0;
+
+// Farbverlauf im HSV-Raum für die Kanäle 0-2, ein Schritt pro ms wie bei den Dimmrampen
+static HsvFade hsvFade;
+static unsigned int hsvFadeTick;
+
 void initApplication(void) {
 	Timeout startupDelay;
 	// delay in config is in seconds
@@ -41,10 +52,12 @@ void initApplication(void) {
 		}
 	}
 
+	initDimmingCurves();
 #ifdef PWM
 	for (unsigned int i=0; i<currentVersion->noOfChannels; i++) {
 		pwmout[i].begin(i);
 	}
+	pwmout::synchronize();
 #endif
 	for (int i = 0; i < 4; i++) {
 		dimming[i].init(i);
@@ -57,6 +70,9 @@ void objectUpdated(int objno) {
 	if (objno < OBJ_CENTRAL_BASE) {    		// Kanalabhängige Funktionen
 		int objchannel = objno / OFSCHANNELOBJECTS;
 		int objfunction = objno % OFSCHANNELOBJECTS;
+		if (objchannel < 3) {
+			hsvFade.stop();			// der Kanal dimmt ab jetzt unabhängig vom Farbverlauf
+		}
 		switch (objfunction) {
 		case OBJ_SWITCH:
 			timefunctions[objchannel].objSwitch(bcu.comObjects->objectRead(objno));
@@ -81,6 +97,9 @@ void objectUpdated(int objno) {
 			break;
 		}
 	} else {					    		// Zentralfunktionen
+		if (objno != OBJ_HSV_COLOR && objno != OBJ_C_RELAY) {
+			hsvFade.stop();
+		}
 		switch (objno) {
 		case OBJ_C_SWITCH:
 			for (int ch = 0; ch < 4; ch++) {
@@ -120,12 +139,26 @@ void objectUpdated(int objno) {
 }
 
 void checkPeriodic(void) {
+	if (hsvFade.isRunning()) {
+		// Zwischenfarbe des Verlaufs, die Rampen der Kanäle enden im selben Schritt genau auf der Zielfarbe
+		unsigned int now = millis();
+		while (hsvFade.isRunning() && hsvFadeTick != now) {
+			hsvFadeTick++;
+			hsvFade.step();
+		}
+		ColorRgbw rgb;
+		hsvToRgb(hsvFade.color(), rgb);
+		dimming[0].follow(rgb.r);
+		dimming[1].follow(rgb.g);
+		dimming[2].follow(rgb.b);
+	}
+	timerQueue.run(millis());		// ruft die Zeitfunktionen nur bei Ablauf ihrer Zeit auf
 	for (int ch = 0; ch < 4; ch++) {
-		timefunctions[ch].checkTimeout();
 		dimming[ch].checkperiodic();
 		handleBusReturn(ch);
 
 	}
+	pwmout::update();		// neue Werte aller Kanäle am selben Periodenende ausgeben
 	relay.handle();
 }
 
@@ -178,26 +211,71 @@ void handleAbsDimmingObject(int objectValue, int channel) {
 			bcu.userEeprom->getUInt8(APP_ABS_SPEED + channel * APP_CH_OFFS));
 }
 
-void handleRGBAbsDimmingObject(int objectValue) {
-	for (int ch = 2; ch >= 0; ch--) {
-		dimming[ch].start(objectValue & 0xFF,
-				bcu.userEeprom->getUInt16(APP_RGB_ABS_SPEED));
-		objectValue >>= 8;
+/* Farbwechsel: die 3 Kanäle beginnen und enden im selben Dimmschritt.
+ * Der Kanal mit der größten Änderung dimmt mit der parametrierten Geschwindigkeit,
+ * die anderen entsprechend langsamer.
+ */
+static void startColourFade(int red, int green, int blue) {
+	int values[3] = { red, green, blue };
+	int speed = bcu.userEeprom->getUInt16(APP_RGB_ABS_SPEED);
+	unsigned int duration = 0;
+	for (int ch = 0; ch < 3; ch++) {
+		unsigned int time = dimming[ch].dimTime(values[ch], speed);
+		if (time > duration) {
+			duration = time;
+		}
+	}
+	unsigned int now = millis();
+	for (int ch = 0; ch < 3; ch++) {
+		dimming[ch].fadeTo(values[ch], duration, now);
 	}
 }
 
+void handleRGBAbsDimmingObject(int objectValue) {
+	startColourFade((objectValue >> 16) & 0xFF, (objectValue >> 8) & 0xFF, objectValue & 0xFF);
+}
+
 void handleHSVAbsDimmingObject(int objectValue) {
-	unsigned char vVal = objectValue & 0xFF;
-	objectValue >>= 8;
-	unsigned char sVal = objectValue & 0xFF;
-	objectValue >>= 8;
-	unsigned char hVal = objectValue & 0xFF;
-	storedHueValue = hVal;		// Farbwert speichern
-	unsigned char rVal, gVal, bVal;
-	hsv2rgb(hVal, sVal, vVal, rVal, gVal, bVal);
-	dimming[0].start(rVal, bcu.userEeprom->getUInt16(APP_RGB_ABS_SPEED));
-	dimming[1].start(gVal, bcu.userEeprom->getUInt16(APP_RGB_ABS_SPEED));
-	dimming[2].start(bVal, bcu.userEeprom->getUInt16(APP_RGB_ABS_SPEED));
+	ColorHsv to, from;
+	ColorRgbw rgb;
+	to.v = objectValue & 0xFF;
+	to.s = (objectValue >> 8) & 0xFF;
+	to.h = (objectValue >> 16) & 0xFF;
+
+	// momentane Farbe aus den Ausgangswerten
+	rgb.r = dimming[0].getactualdimvalue();
+	rgb.g = dimming[1].getactualdimvalue();
+	rgb.b = dimming[2].getactualdimvalue();
+	rgbToHsv(rgb, from);
+	if (!from.s) {		// grau oder aus, kein Farbwert
+		from.h = storedHueValue;
+		if (!from.v) {	// aus: nur die Helligkeit ändern
+			from.h = to.h;
+			from.s = to.s;
+		}
+	}
+	storedHueValue = to.h;		// Farbwert speichern
+
+	// die Komponente mit der größten Änderung dimmt mit der parametrierten Geschwindigkeit
+	int hueDistance = (signed char) (to.h - from.h);
+	int distance = hueDistance < 0 ? -hueDistance : hueDistance;
+	int sDistance = to.s > from.s ? to.s - from.s : from.s - to.s;
+	int vDistance = to.v > from.v ? to.v - from.v : from.v - to.v;
+	if (sDistance > distance) {
+		distance = sDistance;
+	}
+	if (vDistance > distance) {
+		distance = vDistance;
+	}
+	unsigned int duration = bcu.userEeprom->getUInt16(APP_RGB_ABS_SPEED) * 1000.0f * distance / 255;
+
+	hsvToRgb(to, rgb);
+	unsigned int now = millis();
+	dimming[0].fadeTo(rgb.r, duration, now);
+	dimming[1].fadeTo(rgb.g, duration, now);
+	dimming[2].fadeTo(rgb.b, duration, now);
+	hsvFade.start(from, to, duration);
+	hsvFadeTick = now;
 }
 
 void handleBlocking1Object(int objectValue, int channel) {
@@ -18,36 +18,71 @@
 extern pwmout pwmout[];
 #endif
 
+struct DimmingCurve {
+	int min;			// Minimalhelligkeit in 0-MAXOUTPUTVALUE
+	int max;			// Maximalhelligkeit in 0-MAXOUTPUTVALUE
+	unsigned int scale;	// (value-min)*scale = Tabellenposition mit DIMMING_CURVE_FRACTION_BITS Nachkommastellen
+	unsigned short table[DIMMING_CURVE_STEPS + 1];	// Tastverhältnis 0-PWM_DUTY_MAX von min bis max
+};
 
-void setOutput(int ch, int value) {
-	int outputValue;
-	if (value < 1) {
-		outputValue = 0;
-	} else {
+static DimmingCurve curves[4];
+
+/* Die Dimmkurven, wie sie bisher bei jedem Dimmschritt berechnet wurden.
+ * Wird nur noch zum Füllen der Tabellen verwendet.
+ */
+static float curveValue(int curve, float value) {
+	switch (curve) {
+	case 0:		//quadratisch
+		return value*value*0.0001f;		//TODO anpassen bei MAXOUTPUTVALUE<>10000
+	case 2:		//halb-logarithmisch
+		return 0.0000000000009f*(value * value * value * value) + 0.1f*value;		//TODO anpassen bei MAXOUTPUTVALUE<>10000
+	default:	//case 7:    linear
+		return value;
+	}
+}
+
+void initDimmingCurves(void) {
+	int curve = bcu.userEeprom->getUInt8(APP_DIMM_CURVE);
+	for (int ch = 0; ch < 4; ch++) {
+		DimmingCurve& c = curves[ch];
 		/* Hier wird Minimal- und Maximalhelligkeit begrenzt. Das Dimmen und die Rückmeldung laufen jedoch weiter.
 		 * Wie sich das Original genau verhält ist aus dem Handbuch nicht genauer ersichtlich
 		 */
-		int max = (2*MAXOUTPUTVALUE*bcu.userEeprom->getUInt8(APP_MAX_LIGHT + ch * APP_CH_OFFS)/255+1)/2;  // Maximalhelligkeit in 0-MAXOUTPUTVALUE
-		int min = (2*MAXOUTPUTVALUE*bcu.userEeprom->getUInt8(APP_MIN_LIGHT + ch * APP_CH_OFFS)/255+1)/2;  // Minimalhelligkeit in 0-MAXOUTPUTVALUE
-		if (value > max) {
-			value = max;
-		} else if (value < min) {
-			value = min;
+		c.max = (2*MAXOUTPUTVALUE*bcu.userEeprom->getUInt8(APP_MAX_LIGHT + ch * APP_CH_OFFS)/255+1)/2;  // Maximalhelligkeit in 0-MAXOUTPUTVALUE
+		c.min = (2*MAXOUTPUTVALUE*bcu.userEeprom->getUInt8(APP_MIN_LIGHT + ch * APP_CH_OFFS)/255+1)/2;  // Minimalhelligkeit in 0-MAXOUTPUTVALUE
+		if (c.max < c.min) {
+			c.max = c.min;
 		}
-		switch (bcu.userEeprom->getUInt8(APP_DIMM_CURVE)) {
-		case 0:		//quadratisch
-			outputValue = value*value*0.0001;		//TODO anpassen bei MAXOUTPUTVALUE<>10000
-			break;
-		case 2:		//halb-logarithmisch
-			outputValue = 0.0000000000009f*(value * value * value * value) + 0.1f*value;		//TODO anpassen bei MAXOUTPUTVALUE<>10000
-			break;
-		default:	//case 7:    linear
-			outputValue = value;
-			break;
+		float span = c.max - c.min;
+		c.scale = c.max > c.min ? (DIMMING_CURVE_STEPS << DIMMING_CURVE_FRACTION_BITS) / (unsigned int) span : 0;
+		for (int i = 0; i <= DIMMING_CURVE_STEPS; i++) {
+			c.table[i] = curveValue(curve, c.min + span * i / DIMMING_CURVE_STEPS) * (PWM_DUTY_MAX / MAXOUTPUTVALUE) + 0.5f;
 		}
 	}
+}
+
+int dimmingCurveValue(int ch, int value) {
+	const DimmingCurve& c = curves[ch];
+	if (value < 1) {
+		return 0;
+	}
+	if (value >= c.max) {
+		return c.table[DIMMING_CURVE_STEPS];
+	}
+	if (value <= c.min) {
+		return c.table[0];
+	}
+	unsigned int pos = (value - c.min) * c.scale;
+	unsigned int index = pos >> DIMMING_CURVE_FRACTION_BITS;
+	// 12 Bit der Nachkommastellen reichen für die Interpolation, das Produkt mit der Differenz (< 0x10000) passt sicher in 32 Bit
+	unsigned int fraction = (pos >> (DIMMING_CURVE_FRACTION_BITS - 12)) & 0xFFF;
+	int low = c.table[index];
+	return low + (((c.table[index + 1] - low) * (int) fraction + 0x800) >> 12);
+}
+
+void setOutput(int ch, int value) {
 #ifdef PWM
-	pwmout[ch].setpwm(outputValue);
+	pwmout[ch].setpwm(dimmingCurveValue(ch, value));
 #endif
 }
 
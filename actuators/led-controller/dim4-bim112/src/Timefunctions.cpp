@@ -4,10 +4,11 @@
  *  Created on: 25.02.2020
  *      Author: x
  */
-#include <sblib/timeout.h>
+#include <sblib/timer.h>
 #include <com_objs.h>
 #include <dimming.h>
 #include <Timefunctions.h>
+#include <TimerQueue.h>
 #include "Appl.h"
 
 #ifdef DEBUG
@@ -15,37 +16,44 @@
 #endif
 
 extern dimming dimming[];
+extern TimerQueue timerQueue;
 
 void Timefunctions::init(int ch) {
 	channel = ch;
 }
 
-void Timefunctions::checkTimeout() {
-	if (timeout.started() && timeout.expired()) {
-		switch (TimeFctState) {
-		case DelayOn:
-			this->switchOn();
-			TimeFctState = Idle;
-			break;
-		case DelayOff:
-			this->switchOff();
-			break;
-		case StairDelayOn:
-			TimeFctState = StairOn;
-			this->switchOn();
-			timeout.start(bcu.userEeprom->getUInt16(APP_STAIR_DUR + channel * APP_CH_OFFS) * 1000 + 1);
-			break;
-		case StairOn:
-			TimeFctState = StairWarn;
-			this->switchOn();
-			timeout.start(bcu.userEeprom->getUInt16(APP_STAIR_PREWARN + channel * APP_CH_OFFS) * 1000 + 1);
-			break;
-		case StairWarn:
-			this->switchOff();
-			break;
-		default:			//case Idle :
-			break;
-		}
+void Timefunctions::startTimer(unsigned int seconds) {
+	timerQueue.start(channel, seconds * 1000, millis(), timeout, this);
+}
+
+void Timefunctions::timeout(void * context) {
+	((Timefunctions *) context)->expired();
+}
+
+void Timefunctions::expired() {
+	switch (TimeFctState) {
+	case DelayOn:
+		this->switchOn();
+		TimeFctState = Idle;
+		break;
+	case DelayOff:
+		this->switchOff();
+		break;
+	case StairDelayOn:
+		TimeFctState = StairOn;
+		this->switchOn();
+		startTimer(bcu.userEeprom->getUInt16(APP_STAIR_DUR + channel * APP_CH_OFFS));
+		break;
+	case StairOn:
+		TimeFctState = StairWarn;
+		this->switchOn();
+		startTimer(bcu.userEeprom->getUInt16(APP_STAIR_PREWARN + channel * APP_CH_OFFS));
+		break;
+	case StairWarn:
+		this->switchOff();
+		break;
+	default:			//case Idle :
+		break;
 	}
 }
 
@@ -54,11 +62,11 @@ void Timefunctions::objSwitch(int objVal) {
 		return;
 	}
 	if (objVal && (TimeFctState != DelayOn)) {
-		timeout.start(bcu.userEeprom->getUInt16(APP_ON_DELAY + channel * APP_CH_OFFS) * 1000 + 1);//Einschaltverzögerung in sek.; +1 weil timeout mit 0 nicht startet
+		startTimer(bcu.userEeprom->getUInt16(APP_ON_DELAY + channel * APP_CH_OFFS));//Einschaltverzögerung in sek.; 0 läuft beim nächsten run() ab
 		TimeFctState = DelayOn;
 	}
 	if (!objVal && (TimeFctState != DelayOff)) {
-		timeout.start(bcu.userEeprom->getUInt16(APP_OFF_DELAY + channel * APP_CH_OFFS) * 1000 + 1);//Ausschaltverzögerung in sek.; +1 weil timeout mit 0 nicht startet
+		startTimer(bcu.userEeprom->getUInt16(APP_OFF_DELAY + channel * APP_CH_OFFS));//Ausschaltverzögerung in sek.
 		TimeFctState = DelayOff;
 	}
 }
@@ -70,14 +78,14 @@ void Timefunctions::objStairs(int objVal) {
 #endif
 		switch (TimeFctState) {
 		case Idle:
-			timeout.start(bcu.userEeprom->getUInt16(APP_ON_DELAY + channel * APP_CH_OFFS) * 1000 + 1);
+			startTimer(bcu.userEeprom->getUInt16(APP_ON_DELAY + channel * APP_CH_OFFS));
 			TimeFctState = StairDelayOn;
 			break;
 		case StairOn:
 		case StairWarn:
 			if (bcu.userEeprom->getUInt8(APP_STAIR_EXTENSION + channel * APP_CH_OFFS) & APP_STAIR_EXTENSION_M) {
 				//wenn Treppenlicht verlängern ein
-				timeout.start(bcu.userEeprom->getUInt16(APP_STAIR_DUR + channel * APP_CH_OFFS) * 1000 + 1);
+				startTimer(bcu.userEeprom->getUInt16(APP_STAIR_DUR + channel * APP_CH_OFFS));
 				TimeFctState = StairOn;
 				this->switchOn();
 			}
@@ -94,6 +102,7 @@ void Timefunctions::objStairs(int objVal) {
 }
 
 void Timefunctions::switchOff() {
+	timerQueue.stop(channel);		// ein vorzeitig beendetes Treppenlicht läuft nicht mehr ab
 	dimming[channel].start(0,
 			bcu.userEeprom->getUInt8(APP_OFF_SPEED + channel * APP_CH_OFFS));
 	TimeFctState = Idle;
@@ -0,0 +1,51 @@
+/*
+ * TimerQueue.cpp
+ *
+ *      -sortierte Warteschlange der Ablaufzeitpunkte, siehe TimerQueue.h
+ */
+#include <TimerQueue.h>
+
+TimerQueue::TimerQueue() {
+	for (int id = 0; id < TIMER_QUEUE_SIZE; id++) {
+		entries[id].running = false;
+		entries[id].next = -1;
+	}
+	first = -1;
+}
+
+void TimerQueue::start(int id, unsigned int delay, unsigned int now, TimerCallback callback, void * context) {
+	stop(id);
+	Entry & entry = entries[id];
+	entry.deadline = now + delay;
+	entry.callback = callback;
+	entry.context = context;
+	entry.running = true;
+	// hinter allen Einträgen mit gleichem oder früherem Ablaufzeitpunkt einfügen
+	signed char * link = &first;
+	while (*link >= 0 && (int) (entries[(int) *link].deadline - entry.deadline) <= 0) {
+		link = &entries[(int) *link].next;
+	}
+	entry.next = *link;
+	*link = id;
+}
+
+void TimerQueue::stop(int id) {
+	if (!entries[id].running) {
+		return;
+	}
+	signed char * link = &first;
+	while (*link != id) {
+		link = &entries[(int) *link].next;
+	}
+	*link = entries[id].next;
+	entries[id].running = false;
+}
+
+void TimerQueue::run(unsigned int now) {
+	while (first >= 0 && (int) (now - entries[(int) first].deadline) >= 0) {
+		Entry & entry = entries[(int) first];
+		first = entry.next;
+		entry.running = false;
+		entry.callback(entry.context);
+	}
+}
@@ -18,13 +18,26 @@ void dimming::init(int ch)
 }
 
 void dimming::start(int destination, int speed)
+{
+	fadeTo(destination, dimTime(destination, speed), millis());
+}
+
+unsigned int dimming::dimTime(int destination, int speed)
+{
+	int distance = toOutputValue(destination) - actualDimValue;
+	if (distance < 0)
+	{
+		distance = -distance;
+	}
+	// speed in s für 0-100%
+	return speed * 1000.0f * distance / MAXOUTPUTVALUE;
+}
+
+void dimming::fadeTo(int destination, unsigned int duration, unsigned int startTime)
 {
 	if (!blocked1 && !blocked2)
 	{
-		dimStartTime = millis();
-		dimSpeed = speed*1000; 				// speed in s, dimSpeed in ms
-		dimStartValue = actualDimValue;
-		dimDestinationValue = MAXOUTPUTVALUE * destination / 255.0f;  //destination 0-255, dimDestinationValue 0-MAXOUTPUTVALUE
+		dimDestinationValue = toOutputValue(destination);
 		finished = false;
 		isDimming = true;
 		isOn = true;
@@ -32,12 +45,31 @@ void dimming::start(int destination, int speed)
 		{
 			lastDimValue = destination;
 		}
-		if (dimSpeed == 0)
+		if (duration == 0)
 		{  //Wert sofort einstellen
 			actualDimValue = dimDestinationValue;
 			this->stop();
 			setOutput(channel, actualDimValue);
+			return;
 		}
+		// einzige Division der Rampe: Änderung pro Schritt als ganzzahliger Anteil und Rest
+		int distance = dimDestinationValue - actualDimValue;
+		dimDirection = distance < 0 ? -1 : 1;
+		distance *= dimDirection;
+		dimStep = dimDirection * (int)(distance / duration);
+		dimRemainder = distance % duration;
+		dimError = 0;
+		dimTicks = duration;
+		ticksLeft = duration;
+		lastTick = startTime;
+	}
+}
+
+void dimming::follow(int value)
+{
+	if (isDimming)
+	{
+		actualDimValue = toOutputValue(value);
 	}
 }
 
@@ -58,6 +90,23 @@ void dimming::stop()
 	}
 }
 
+void dimming::step()
+{
+	actualDimValue += dimStep;
+	dimError += dimRemainder;
+	if (dimError >= dimTicks)
+	{
+		dimError -= dimTicks;
+		actualDimValue += dimDirection;
+	}
+	if (--ticksLeft == 0)
+	{
+		//Zielhelligkeit erreicht, nach dimTicks Schritten ist die Summe der Schritte genau die Differenz
+		actualDimValue = dimDestinationValue;
+		this->stop();
+	}
+}
+
 void dimming::checkperiodic()
 {
 	if (!isDimming)
@@ -65,53 +114,25 @@ void dimming::checkperiodic()
 	    return;
 	}
 
-	int tRest;
-	uint32_t dimTimeElapsed = millis() - dimStartTime;
-	bool isDimmingUp = dimStartValue <= dimDestinationValue;
-    if (isDimmingUp)
-    {
-        tRest = dimSpeed * (MAXOUTPUTVALUE - dimStartValue) / MAXOUTPUTVALUE;
-        if (tRest == 0) ///\todo implement a better catch devision by zero
-        {
-            actualDimValue = dimDestinationValue;
-        }
-        else
-        {
-            actualDimValue = dimStartValue + (dimTimeElapsed * (MAXOUTPUTVALUE - dimStartValue) / tRest);
-        }
-
-        if (actualDimValue >= dimDestinationValue)
-        {
-            //Zielhelligkeit erreicht
-            actualDimValue = dimDestinationValue;
-            this->stop();
-        }
-    }
-    else
-    {
-        tRest = dimSpeed * dimStartValue / MAXOUTPUTVALUE;
-        if (tRest == 0) ///\todo implement a better catch devision by zero
-        {
-            actualDimValue = dimDestinationValue;
-        }
-        else
-        {
-            actualDimValue = dimStartValue - (dimTimeElapsed * dimStartValue / tRest);
-        }
-        // TODO minimale Helligkeit bearbeiten
-        if (actualDimValue <= dimDestinationValue)
-        {
-            //Zielhelligkeit erreicht
-            actualDimValue = dimDestinationValue;
-            this->stop();
-        }
-    }
-    setOutput(channel, actualDimValue);
+	// ein Schritt pro ms Systemzeit, verpasste Schritte werden nachgeholt
+	unsigned int now = millis();
+	while (isDimming && lastTick != now)
+	{
+		lastTick++;
+		step();
+	}
+	setOutput(channel, actualDimValue);
 }
 
 int dimming::getactualdimvalue()
 {
-	return actualDimValue * 255.0f / MAXOUTPUTVALUE;		// Rückgabe im KNX-Format 0-255
+	return actualDimValue * 255 / (int) MAXOUTPUTVALUE;		// Rückgabe im KNX-Format 0-255
+}
+
+int dimming::toOutputValue(int value)
+{
+	// aufrunden, damit getactualdimvalue() nach dem Dimmen wieder genau value liefert
+	return (value * (int) MAXOUTPUTVALUE + 254) / 255;	// value 0-255, Rückgabe 0-MAXOUTPUTVALUE
 }
 
 int dimming::getlastdimvalue()
@@ -7,12 +7,35 @@
 
 #include "pwmout.h"
 #include <sblib/eibMASK0701.h>
+#include <sblib/interrupt.h>
 #include <com_objs.h>
 #include "config.h"
 #ifdef DEBUG
 #   include <sblib/serial.h>  //debugging only
 #endif
 
+extern pwmout pwmout[];
+
+volatile unsigned int pwmout::activeBank = 0;
+bool pwmout::staged = false;
+
+#ifdef PWM
+
+// Ende der PWM-Periode der Kanäle 0 und 1
+extern "C" void TIMER16_0_IRQHandler(void) {
+	pwmout[0].period();
+	pwmout[1].period();
+	timer16_0.resetFlags();
+}
+
+// Ende der PWM-Periode der Kanäle 2 und 3
+extern "C" void TIMER32_1_IRQHandler(void) {
+	pwmout[2].period();
+	pwmout[3].period();
+	timer32_1.resetFlags();
+}
+#endif
+
 void pwmout::begin(int ch) {
 	channel = ch;
 	if (bcu.userEeprom->getUInt16(APP_PWM_O) == 0x600){	//0x600 = 600Hz ; 0xA00 = 1kHz
@@ -44,6 +67,9 @@ void pwmout::begin(int ch) {
 	    timer16_0.pwmEnable(MAT1);       // enable PWM for match channel MAT1
 	    timer16_0.matchMode(MAT3, RESET | INTERRUPT);	// Reset the timer when the timer matches MAT3 and generate an interrupt
 	    timer16_0.match(MAT3, pwmmax);
+	    timer = &timer16_0;
+	    matchChannel = MAT1;
+	    enableInterrupt(TIMER_16_0_IRQn);
 	    timer16_0.start();
 	    isactive = true;
 	    return;
@@ -57,6 +83,9 @@ void pwmout::begin(int ch) {
 	    timer32_1.pwmEnable(MAT0);       // enable PWM for match channel MAT0
 	    timer32_1.matchMode(MAT3, RESET | INTERRUPT);	// Reset the timer when the timer matches MAT3 and generate an interrupt
 	    timer32_1.match(MAT3, pwmmax);
+	    timer = &timer32_1;
+	    matchChannel = MAT0;
+	    enableInterrupt(TIMER_32_1_IRQn);
 	    timer32_1.start();
 	    isactive = true;
 	    return;
@@ -70,6 +99,9 @@ void pwmout::begin(int ch) {
 	    timer32_1.pwmEnable(MAT1);       // enable PWM for match channel MAT1
 	    timer32_1.matchMode(MAT3, RESET | INTERRUPT);	// Reset the timer when the timer matches MAT3 and generate an interrupt
 	    timer32_1.match(MAT3, pwmmax);
+	    timer = &timer32_1;
+	    matchChannel = MAT1;
+	    enableInterrupt(TIMER_32_1_IRQn);
 	    timer32_1.start();
 	    isactive = true;
 	    return;
@@ -81,34 +113,44 @@ void pwmout::begin(int ch) {
 
 }
 
-void pwmout::setpwm(int value) {
-	if (value < 0)
+void pwmout::setpwm(unsigned int value) {
+	if (value > PWM_DUTY_MAX)
 	{
-		value = 0;
+		value = PWM_DUTY_MAX;
 	}
 
-	if (value > MAXOUTPUTVALUE)
-	{
-		value = MAXOUTPUTVALUE;
+	if (isactive) {
+		// nur vorbereiten, die Interrupts lesen diesen Satz erst nach update()
+		// value * pwmmax * 0x10000 / PWM_DUTY_MAX, 0xFFFF * PWM_MAX_600 passt in 32 Bit
+		unsigned int fixed = value * pwmmax;
+		dutyFixed[activeBank ^ 1] = fixed + ((fixed + 0x8000) >> PWM_DUTY_BITS);
+		staged = true;
 	}
+}
 
-	if (isactive) {
-		switch (channel) {
-			//int val = value*pwmmax/MAXVALUE;
-			case 0:
-				//timer16_0.match(MAT0, pwmmax-(value*pwmmax/MAXOUTPUTVALUE));      // match MAT0 when the timer reaches this value
-				break;
-			case 1:
-				timer16_0.match(MAT1, pwmmax-(value*pwmmax/MAXOUTPUTVALUE));      // match MAT1 when the timer reaches this value
-				break;
-			case 2:
-				timer32_1.match(MAT0, pwmmax-(value*pwmmax/MAXOUTPUTVALUE));      // match MAT0 when the timer reaches this value
-				break;
-			case 3:
-				timer32_1.match(MAT1, pwmmax-(value*pwmmax/MAXOUTPUTVALUE));      // match MAT1 when the timer reaches this value
-				break;
-			default:
-				break;
+void pwmout::update() {
+	if (!staged) {
+		return;
+	}
+	staged = false;
+	// Umschalten mit einem Schreibzugriff, period() läuft im Interrupt und sieht so immer einen vollständigen Satz
+	unsigned int bank = activeBank ^ 1;
+	activeBank = bank;
+	// nicht geänderte Kanäle behalten im nächsten vorbereiteten Satz ihren Wert
+	for (int ch = 0; ch < 4; ch++) {
+		::pwmout[ch].dutyFixed[bank ^ 1] = ::pwmout[ch].dutyFixed[bank];
+	}
+}
+
+void pwmout::synchronize() {
+	// Kanäle 0/1 laufen auf timer16_0, 2/3 auf timer32_1, jeder verwendete Timer wird einmal neu gestartet
+	Timer * last = 0;
+	noInterrupts();
+	for (int ch = 0; ch < 4; ch++) {
+		if (::pwmout[ch].timer && ::pwmout[ch].timer != last) {
+			last = ::pwmout[ch].timer;
+			last->restart();
 		}
 	}
+	interrupts();
 }
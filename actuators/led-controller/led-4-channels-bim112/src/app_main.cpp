@@ -12,8 +12,11 @@
 #include <sblib/ioports.h>
 #include <sblib/io_pin_names.h>
 #include <sblib/timeout.h>
+#include <sblib/timer.h>
 #include "individual_channel.h"
 #include "led-controller.h"
+#include "color.h"
+#include "scenes.h"
 
 APP_VERSION("SBLED   ", "0", "01")
 
@@ -25,6 +28,8 @@ const unsigned char hardwareVersion[] =
 void initApplication(void);
 /* initialize a channel as standalone dimming channel */
 void initChannel(unsigned int channel);
+/* initialize a channel as part of the RGB(W) color */
+void initColorChannel(unsigned int channel);
 
 /* called when a com object has been changed from outside */
 void objectUpdated(unsigned int objno);
@@ -34,6 +39,11 @@ void checkPeriodicFuntions(void);
 
 static Channel * channels[4];
 
+static SceneStore scenes;
+static RgbwFade   sceneFade;     //!< fade of all channels to a recalled scene, one step per ms
+static unsigned int sceneFadeTick;
+static ColorRgbw  output;        //!< the values of the RGB(W) channels
+
 MASK0701 bcu = MASK0701();
 
 /**
@@ -77,6 +87,7 @@ void initApplication(void)
     // XXX setup the PWM frequency
     unsigned int pwmFreq = bcu.userEeprom->getUInt8 (0x476C) * 1000;
     timer16_0.prescaler(pwmFreq);
+    scenes.init();
 
     switch (bcu.userEeprom->getUInt8 (0x470E))
     {
@@ -87,23 +98,123 @@ void initApplication(void)
         initChannel(3);
         break;
     case 0x01 : // RGB dimming
+        initColorChannel(0);
+        initColorChannel(1);
+        initColorChannel(2);
         if (bcu.userEeprom->getUInt8(0x476B) == 0x1)
         {   // channel D is used as standalone channel but configured as channel A !
-            initChannel(0);
+            initChannel(3);
         }
         break;
     case 0x02 : // RGBW dimming
+        initColorChannel(0);
+        initColorChannel(1);
+        initColorChannel(2);
+        initColorChannel(3);
         break;
 
     }
 }
 
+/* write the values of the RGB(W) channels */
+static void writeChannels(const ColorRgbw & color)
+{
+    if (bcu.userEeprom->getUInt8 (0x470E) == 0x02)
+    {   // RGBW dimming, channel D is the white channel
+        if (channels[3] != NULL)
+            channels[3]->setValue(color.w);
+        output.w = color.w;
+    }
+    if (channels[0] != NULL)
+        channels[0]->setValue(color.r);
+    if (channels[1] != NULL)
+        channels[1]->setValue(color.g);
+    if (channels[2] != NULL)
+        channels[2]->setValue(color.b);
+    output.r = color.r;
+    output.g = color.g;
+    output.b = color.b;
+}
+
+/* set the color of the RGB(W) channels */
+static void setColor(ColorRgbw & color)
+{
+    if (bcu.userEeprom->getUInt8 (0x470E) == 0x02)
+    {   // RGBW dimming, the white part of the color is done by channel D
+        extractWhite(color);
+    }
+    sceneFade.stop();
+    writeChannels(color);
+}
+
+/*
+ * scene telegram (DPT 18.001): bits 0..5 are the scene, bit 7 set learns
+ * the current color, otherwise all channels fade to the scene together
+ */
+static void handleScene(unsigned int value)
+{
+    unsigned int number = value & SCENE_NUMBER_MASK;
+    Scene scene;
+
+    if (value & SCENE_LEARN)
+    {   // keep the fade time of the scene
+        if (!scenes.get(number, scene))
+            scene.fadeTime = SCENE_DEFAULT_FADE;
+        scene.color = output;
+        scenes.learn(number, scene); // written in the main loop, lost if the queue is full
+    }
+    else if (scenes.get(number, scene))
+    {
+        sceneFade.start(output, scene.color, scene.fadeTime * SCENE_FADE_UNIT);
+        sceneFadeTick = millis();
+        if (!sceneFade.isRunning())
+            writeChannels(scene.color);
+    }
+}
+
 void objectUpdated(unsigned int objno)
 {
+    unsigned int value = bcu.comObjects->objectRead(objno);
+    ColorRgbw rgb;
+    ColorHsv  hsv;
+
+    switch (objno)
+    {
+    case COM_OBJ_RGB_COLOR :
+        rgb.r = value >> 16;
+        rgb.g = value >> 8;
+        rgb.b = value;
+        setColor(rgb);
+        break;
+    case COM_OBJ_HSV_COLOR :
+        hsv.h = value >> 16;
+        hsv.s = value >> 8;
+        hsv.v = value;
+        hsvToRgb(hsv, rgb);
+        setColor(rgb);
+        break;
+    case COM_OBJ_RGBW_SCENE :
+        handleScene(value);
+        break;
+    }
 }
 
 void checkPeriodicFuntions(void)
 {
+    if (sceneFade.isRunning())
+    {   // one step per ms, missed steps are caught up
+        unsigned int now = millis();
+        while (sceneFade.isRunning() && sceneFadeTick != now)
+        {
+            sceneFadeTick++;
+            sceneFade.step();
+        }
+        writeChannels(sceneFade.color());
+    }
+    else if (bcu.bus->idle())
+    {   // the flash is not written during a fade, an erase would stop it for 100 ms
+        scenes.process();
+    }
     if (bcu.userEeprom->getUInt8 (0x4764) == 1)
     {   // relay output is controlled by the 4 channels
         unsigned int value = 0;
@@ -117,7 +228,12 @@ void checkPeriodicFuntions(void)
 
 void initChannel(unsigned int channel)
 {
+    channels[channel] = new IndividualChannel(channel);
+}
 
+void initColorChannel(unsigned int channel)
+{
+    channels[channel] = new Channel(channel);
 }
 
 /**
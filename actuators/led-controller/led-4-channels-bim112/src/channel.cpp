@@ -12,8 +12,9 @@
 
 extern MASK0701 bcu;
 
-Channel::Channel()
-: pwm(0)
+Channel::Channel(unsigned int number)
+: number(number)
+, pwm(0)
 {
 }
 
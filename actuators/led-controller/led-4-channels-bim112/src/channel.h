@@ -13,7 +13,7 @@
 class Channel
 {
 public:
-    Channel();
+    Channel(unsigned int number);
 
     bool isOn();
 
@@ -7,8 +7,8 @@
 
 #include "individual_channel.h"
 
-IndividualChannel::IndividualChannel()
- : Channel()
+IndividualChannel::IndividualChannel(unsigned int number)
+ : Channel(number)
 {
 }
 
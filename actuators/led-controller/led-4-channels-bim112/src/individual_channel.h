@@ -16,7 +16,7 @@
 class IndividualChannel: public Channel
 {
 public:
-    IndividualChannel();
+    IndividualChannel(unsigned int number);
 };
 
 #endif /* INDIVIDUAL_CHANNEL_H_ */
@@ -0,0 +1,203 @@
+/*
+ *  scenes.cpp - Storage of the RGBW scenes of the LED controller in flash
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include <string.h>
+#include <sblib/internal/iap.h>
+#include "scenes.h"
+
+SceneStore::SceneStore()
+  : current(-1)
+  , sequence(0)
+  , nextErased(false)
+  , queued(0)
+{
+}
+
+bool SceneStore::eraseSector(unsigned int sector)
+{
+    const byte * start = (const byte *) (SCENE_FLASH_START + sector * SCENE_SECTOR_SIZE);
+    return iapEraseSector(iapSectorOfAddress(start)) == IAP_SUCCESS;
+}
+
+bool SceneStore::programPage(unsigned int sector, unsigned int page, const byte * data)
+{
+    return iapProgram((byte *) pagePtr(sector, page), data, SCENE_PAGE_SIZE) == IAP_SUCCESS;
+}
+
+const byte * SceneStore::pagePtr(unsigned int sector, unsigned int page)
+{
+    return (const byte *) (SCENE_FLASH_START + sector * SCENE_SECTOR_SIZE + page * SCENE_PAGE_SIZE);
+}
+
+static unsigned int getUInt32(const byte * ptr)
+{
+    return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (ptr[3] << 24);
+}
+
+bool SceneStore::sectorValid(unsigned int sector, unsigned int & sequence)
+{
+    const byte * header = pagePtr(sector, SCENE_HEADER_PAGE);
+    if (header[0] != SCENE_MAGIC)
+        return false;
+    // a torn program of the header cannot leave both values complementary
+    sequence = getUInt32(header + 1);
+    return getUInt32(header + 5) == ~sequence;
+}
+
+bool SceneStore::sectorErased(unsigned int sector)
+{
+    for (unsigned int page = 0; page < SCENE_SECTOR_SIZE / SCENE_PAGE_SIZE; page++)
+    {
+        const byte * ptr = pagePtr(sector, page);
+        for (unsigned int i = 0; i < SCENE_PAGE_SIZE; i++)
+        {
+            if (ptr[i] != 0xff)
+                return false;
+        }
+    }
+    return true;
+}
+
+unsigned int SceneStore::nextSector(void)
+{
+    return current < 0 ? 0 : current ^ 1;
+}
+
+void SceneStore::init(void)
+{
+    unsigned int seq;
+    current = -1;
+    nextErased = false;
+    queued = 0;
+    for (unsigned int sector = 0; sector < SCENE_SECTOR_COUNT; sector++)
+    {
+        if (sectorValid(sector, seq) && ((current < 0) || ((int) (seq - sequence) > 0)))
+        {
+            current  = sector;
+            sequence = seq;
+        }
+    }
+}
+
+bool SceneStore::get(unsigned int number, Scene & scene)
+{
+    for (unsigned int i = 0; i < queued; i++)
+    {
+        if (queuedNumber[i] == number)
+        {
+            scene = queuedScene[i];
+            return true;
+        }
+    }
+    if ((current < 0) || (number >= SCENE_COUNT))
+        return false;
+    const byte * ptr = pagePtr(current, number / SCENES_PER_PAGE)
+                     + (number % SCENES_PER_PAGE) * SCENE_SIZE;
+    if (ptr[6] == 0xff)
+        return false; // erased, never learned
+    scene.color.r  = ptr[0];
+    scene.color.g  = ptr[1];
+    scene.color.b  = ptr[2];
+    scene.color.w  = ptr[3];
+    scene.fadeTime = ptr[4] | (ptr[5] << 8);
+    return true;
+}
+
+bool SceneStore::store(unsigned int number, const Scene & scene)
+{
+    byte num = number;
+
+    if (number >= SCENE_COUNT)
+        return false;
+    return writeTable(&num, &scene, 1);
+}
+
+/*
+ * Write the table with the given scenes changed into the next sector.
+ */
+bool SceneStore::writeTable(const byte * numbers, const Scene * scenes, unsigned int count)
+{
+    // word aligned for the IAP functions
+    unsigned int buffer[SCENE_PAGE_SIZE / sizeof(unsigned int)];
+    byte * data = (byte *) buffer;
+    unsigned int next = nextSector();
+
+    if (!nextErased && !eraseSector(next))
+        return false;
+    nextErased = false;
+    for (unsigned int page = 0; page < SCENE_TABLE_PAGES; page++)
+    {
+        if (current < 0)
+            memset(data, 0xff, SCENE_PAGE_SIZE);
+        else
+            memcpy(data, pagePtr(current, page), SCENE_PAGE_SIZE);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (numbers[i] / SCENES_PER_PAGE != page)
+                continue;
+            const Scene & scene = scenes[i];
+            byte * ptr = data + (numbers[i] % SCENES_PER_PAGE) * SCENE_SIZE;
+            ptr[0] = scene.color.r;
+            ptr[1] = scene.color.g;
+            ptr[2] = scene.color.b;
+            ptr[3] = scene.color.w;
+            ptr[4] = scene.fadeTime;
+            ptr[5] = scene.fadeTime >> 8;
+            ptr[6] = 0; // learned
+        }
+        if (!programPage(next, page, data))
+            return false;
+    }
+    // the header makes the new table valid
+    unsigned int seq = sequence + 1;
+    memset(data, 0xff, SCENE_PAGE_SIZE);
+    data[0] = SCENE_MAGIC;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        data[1 + i] = seq >> (i * 8);
+        data[5 + i] = ~seq >> (i * 8);
+    }
+    if (!programPage(next, SCENE_HEADER_PAGE, data))
+        return false;
+    current  = next;
+    sequence = seq;
+    return true;
+}
+
+bool SceneStore::learn(unsigned int number, const Scene & scene)
+{
+    unsigned int i;
+
+    if (number >= SCENE_COUNT)
+        return false;
+    for (i = 0; i < queued; i++)
+    {
+        if (queuedNumber[i] == number)
+            break; // learned again before it was written
+    }
+    if (i >= SCENE_QUEUE_LEN)
+        return false;
+    if (i == queued)
+        queued++;
+    queuedNumber[i] = number;
+    queuedScene[i]  = scene;
+    return true;
+}
+
+void SceneStore::process(void)
+{
+    if (queued)
+    {
+        writeTable(queuedNumber, queuedScene, queued);
+        queued = 0;
+    }
+    else if (!nextErased)
+    {   // reading the sector is much faster than erasing it again
+        unsigned int next = nextSector();
+        nextErased = sectorErased(next) || eraseSector(next);
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ *  scenes.h - Storage of the RGBW scenes of the LED controller in flash
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#ifndef SCENES_H_
+#define SCENES_H_
+
+#include <sblib/types.h>
+#include "color.h"
+
+#define SCENE_COUNT         64
+#define SCENE_SIZE          8    //!< r, g, b, w, fade time (2 bytes), 2 bytes reserved
+#define SCENE_PAGE_SIZE     256  //!< a flash page, the unit of one program operation
+#define SCENES_PER_PAGE     (SCENE_PAGE_SIZE / SCENE_SIZE)
+#define SCENE_TABLE_PAGES   (SCENE_COUNT / SCENES_PER_PAGE)
+#define SCENE_HEADER_PAGE   SCENE_TABLE_PAGES // written after the table, marks the sector as valid
+#define SCENE_SECTOR_SIZE   4096
+#define SCENE_SECTOR_COUNT  2
+#define SCENE_FLASH_START   0xD000 //!< the two sectors below the user EEPROM (0xF000), reserved in linkscripts/memory.ldt
+#define SCENE_MAGIC         0x5C
+#define SCENE_QUEUE_LEN     8    //!< scenes learned before process() writes them
+
+#define SCENE_FADE_UNIT     100  //!< ms, unit of the stored fade time
+#define SCENE_DEFAULT_FADE  10   //!< fade time of a scene which has not been learned yet, 1 s
+
+// scene telegram, DPT 18.001
+#define SCENE_LEARN         0x80
+#define SCENE_NUMBER_MASK   0x3F
+
+struct Scene
+{
+    ColorRgbw color;
+    unsigned int fadeTime; //!< in units of SCENE_FADE_UNIT
+};
+
+/**
+ * The 64 scenes are kept in flash, so a learned scene survives a power
+ * failure. A scene is recalled without writing the flash.
+ *
+ * The scene table (2 pages) is stored in one of two flash sectors. A learn
+ * erases the other sector, copies the table with the changed scene into it
+ * and writes a header page with a sequence number last. On startup the
+ * valid sector with the higher sequence number is used, a learn that was
+ * interrupted by a power failure leaves the previous table in place.
+ *
+ * Header page: SCENE_MAGIC, sequence number and its complement (little
+ * endian, 4 bytes each).
+ *
+ * A sector erase takes about 100 ms in which the CPU cannot run from
+ * flash. A scene learned by telegram is therefore only queued, process()
+ * writes all queued scenes with one table in the main loop, and erases the
+ * sector for the next learn in advance while the bus is idle.
+ */
+class SceneStore
+{
+public:
+    SceneStore();
+    virtual ~SceneStore() {}
+
+    /**
+     * Find the sector with the newest valid scene table, call once at
+     * startup before any other method.
+     */
+    void init(void);
+
+    /**
+     * Get a scene.
+     *
+     * @param number the scene 0..63
+     * @param scene the stored color and fade time
+     * @return false if the scene has never been learned
+     */
+    bool get(unsigned int number, Scene & scene);
+
+    /**
+     * Queue a scene to be stored by the next call of process(), get()
+     * returns the queued scene until then. Learning a queued scene again
+     * replaces it in the queue. Never writes the flash.
+     *
+     * @param number the scene 0..63
+     * @param scene the color and fade time to store
+     * @return false if SCENE_QUEUE_LEN other scenes are queued already,
+     *         the scene is not learned then
+     */
+    bool learn(unsigned int number, const Scene & scene);
+
+    /**
+     * Call in the main loop while the bus is idle. Stores the queued scenes
+     * in one table, otherwise erases the sector for the next learn if this
+     * has not been done yet.
+     */
+    void process(void);
+
+    /**
+     * Store a scene in flash, takes three page programs and one sector
+     * erase if process() has not erased the sector in advance.
+     *
+     * @param number the scene 0..63
+     * @param scene the color and fade time to store
+     * @return true if the flash has been written successfully
+     */
+    bool store(unsigned int number, const Scene & scene);
+
+protected:
+    virtual bool eraseSector(unsigned int sector);
+    virtual bool programPage(unsigned int sector, unsigned int page, const byte * data);
+    virtual const byte * pagePtr(unsigned int sector, unsigned int page);
+
+    bool writeTable(const byte * numbers, const Scene * scenes, unsigned int count);
+    bool sectorValid(unsigned int sector, unsigned int & sequence);
+    bool sectorErased(unsigned int sector);
+    unsigned int nextSector(void);
+
+    int          current;  //!< sector with the newest table, -1 if no scene has been learned
+    unsigned int sequence; //!< sequence number of the newest table
+    bool         nextErased; //!< the sector for the next learn has been erased
+    unsigned int queued;     //!< number of queued scenes
+    byte         queuedNumber[SCENE_QUEUE_LEN];
+    Scene        queuedScene[SCENE_QUEUE_LEN];
+};
+
+#endif /* SCENES_H_ */
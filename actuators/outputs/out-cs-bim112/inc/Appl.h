@@ -14,6 +14,7 @@
 #define APPL_H_
 
 #include <sblib/eibMASK0701.h>
+#include <com_objs.h>
 
 extern MASK0701 bcu;
 
@@ -114,6 +115,37 @@ typedef struct
 #define CFINIDONE2_M 0x80 // Ini2: Beim Übergang zu "Running"
 #define CFINIDONE2_O 7
 
+/*
+ * Verteiltabelle für empfangene Objekte
+ * Nach dem Laden der Konfiguration wird für jede Objektnummer einmalig festgelegt, welche
+ * Bearbeitung ein empfangenes Objekt auslöst und zu welchem Kanal/Objektoffset es gehört.
+ * Die Freischaltungen der Kanalfunktionen (Schaltaktor, Preset, Szene, Schwellwert) stecken
+ * bereits im Handler. objectUpdated() kommt dadurch ohne Division und ohne wiederholte
+ * Konfigurationszugriffe aus.
+ */
+enum class ObjHandler : byte
+{
+ None,         // Objekt wird ignoriert (Sendeobjekt, Kanal nicht als Schaltaktor konfiguriert etc.)
+ GlobalSafety, // Sicherheitsobjekte Prio 1..3
+ ChannelObj,   // Kanalobjekt ohne eigenen Schaltauftrag (Logik, Zeitfkt, Dauer-Ein, Zwangsstellung...)
+ Switch,
+ CallPreset,
+ SetPreset,
+ Scene,
+ Threshold,    // Threshold und Change Threshold 1
+ EnergyReset   // Energiezähler zurücksetzen
+};
+
+typedef struct
+{
+ ObjHandler Handler;
+ byte chno;
+ byte objofs;
+} TObjDispatch;
+// 3 Bytes
+
+#define OBJDISPATCHLEN (OFSCHANNELOBJECTS+CHANNELCNT*SPACINGCHANNELOBJECTS)
+
 /*
  * Liest die Wartezeit bei Systemstart für Schaltaktionen und Objektsenden.
  * Das Ergebnis ist in Sekunden.
@@ -183,6 +215,18 @@ class Appl
   */
  bool GetSwitchStatus(int chno);
 
+ /*
+  * Baut die Verteiltabelle für empfangene Objekte aus der aktuellen Konfiguration auf.
+  * Muss nach jedem Laden der Konfiguration (Start, Download) aufgerufen werden, bevor
+  * Objekte verarbeitet werden.
+  */
+ void BuildObjDispatchTable(void);
+
+ /*
+  * Löscht die Verteiltabelle, empfangene Objekte werden dann ignoriert (keine Applikation geladen).
+  */
+ void ClearObjDispatchTable(void);
+
  /*
   * Diese Funktion muss bei Empfang eines Objektes aufgerufen werden.
   * referenceTime ist die aktuelle Zeit bei Aufruf, sie dient dazu, dass
@@ -250,12 +294,24 @@ class Appl
  // Dies sind Kanäle, die durch den Download nicht verändert worden sind.
  unsigned int ActuatorSafetyTripTime[3];
  unsigned int AliveTargetTime;
+ TObjDispatch ObjDispatch[OBJDISPATCHLEN];
 
  /*
   * Realisiert eine Stromschwellwertfunktion
   */
  void OneCurrThresholdFct(int chno, float IMeas, int fctno);
 
+ /*
+  * Aktualisiert die Objekte Energie, Scheinleistung und Betriebsstunden eines Kanals,
+  * bei Send==true werden sie auch gesendet.
+  */
+ void UpdateEnergyObjects(int chno, bool Send);
+
+ /*
+  * Setzt die Energiezähler des im Objekt angegebenen Kanals (0: alle Kanäle) zurück.
+  */
+ void EnergyResetObjRelated(int objno);
+
  /*
   * Aktualisiert den Zustand eines StatusObjekts anhand des Triggers.
   * Dabei wird die Konfiguration für Status-Objekte der Applikation berücksichtigt
@@ -280,7 +336,7 @@ class Appl
  void PostProcessSingleSwitchObject(int chno, TStateAndTrigger &trigger, int objno, unsigned referenceTime);
 
  /*
-  * Verarbeitet die Schaltobjekte, wird indirekt über objectUpdated() aufgerufen.
+  * Verarbeitet die Schaltobjekte, wird über die Verteiltabelle von objectUpdated() aufgerufen.
   * Zu den Schaltobjekten gehören:
   * - Switch
   * - Preset
@@ -290,8 +346,9 @@ class Appl
   *   sind aber keine "Objekte"
   * In dieser Routine werden auch die Änderungen durch Objekte an den Schaltfunktionen bearbeitet
   * (Szenen speichern, Presets ändern etc.), obwohl diese Objekte keine Schaltaufträge generieren können.
+  * Ob die jeweilige Funktion freigeschaltet ist, ist bereits im Handler enthalten.
   */
- TStateAndTrigger ProcessSwitchObj(int objno, int chno);
+ TStateAndTrigger ProcessSwitchObj(ObjHandler handler, int objno, int chno);
 
  /*
   * Bearbeitet eine Logikfunktion innerhalb eines Kanals
@@ -342,7 +399,7 @@ class Appl
   * sie selber aktiviert oder deaktiviert, erzeugt sie die entsprechenden Schaltaufträge.
   * Bei Deaktivierung kann es sogar notwendig sein, die Treppenlichtfunktion neu zu starten.
   * In diesem Fall liefert diese Funktion dann "true" zurück, ansonsten false.
-  * Die aufrufende Funktion ProcessChannelObj reagiert dann entsprechend.
+  * Die aufrufende Funktion PostProcessSingleSwitchObject reagiert dann entsprechend.
   */
  bool PermanentOnFunction(TStateAndTrigger &trigger, int objno, int chno);
 
@@ -364,7 +421,7 @@ class Appl
 
  /*
   * Interne Funktion, die von GlobalSafetyTimeRelated oder -ObjRelated aufgerufen wird.
-  * Das Zwangsführungsobjekt wird ganz normal im ProcessChannelObj Kontext bearbeitet, also nicht hier
+  * Das Zwangsführungsobjekt wird ganz normal als Kanalobjekt bearbeitet, also nicht hier
   */
  void ProcessSafetyChanges(unsigned SafetyChanges);
 
@@ -386,11 +443,6 @@ class Appl
   * Die Funktionalität der globalen Sicherheit, abhängig von empfangenen Objekten
   */
  void GlobalSafetyObjRelated(int obj, unsigned referenceTime);
-
- /*
-  * Interne Funktion, wird zur Verarbeitung von Kanalobjekten aufgerufen
-  */
- void ProcessChannelObj(int chno, int objno, unsigned referenceTime);
 };
 
 // Besonderheit: Die Adresse darf beliebig sein, daher auch ungerade
@@ -0,0 +1,106 @@
+/*
+ *  EnergyMeter.h - Energy, apparent power and operating hours per channel
+ *
+ *  For any further information see: inc/config.h
+ *
+ *  Copyright (C) 2018 Florian Voelzke <fvoelzke@gmx.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef ENERGYMETER_H_
+#define ENERGYMETER_H_
+
+#include <stdint.h>
+#include <config.h>
+#include <AdcIsr.h>
+
+/*
+ * Die Energiemessung benutzt ausschließlich die Quadratsummen, die die ADC-ISR ohnehin
+ * je Messperiode (BUFSIZE Zyklen, also 1/RMSCURRENTVALUESPERSECOND Sekunde) ablegt.
+ * Es gibt keine zusätzlichen Wandlungen. Da die Netzspannung nicht gemessen wird, ist die
+ * Leistung eine Scheinleistung, gerechnet mit der Nennspannung ENERGYMAINSVOLTAGE.
+ * Gerechnet wird durchgehend in Festkomma, die Zähler sind 64bit breit.
+ */
+#define ENERGYMAINSVOLTAGE 230 // Netzspannung in Volt
+#define ENERGYMINCURRENT 7     // Strom in mA, unterhalb dessen Rauschen und Offset ausgeblendet werden (wie beim Stromobjekt)
+
+// Stromwert eines ADC-Digits in µA bei GainCorr = 1.0 (32768)
+#define ENERGYCURRSCALELOW  ((uint64_t)(MAXCURRLOWRANGE*1000000/512+0.5))
+#define ENERGYCURRSCALEHIGH ((uint64_t)(MAXCURRHIGHRANGE*1000000/512+0.5))
+
+// Teiler von "mVA je Messperiode" auf Wh bzw. von Messperioden auf Stunden
+#define ENERGYTICKSPERHOUR (3600*RMSCURRENTVALUESPERSECOND)
+#define ENERGYACCUPERWH ((uint64_t)1000*ENERGYTICKSPERHOUR)
+
+#define ENERGYSIGNATURE 0xE5
+#define ENERGYDATALEN (1+12*CHANNELCNT)
+
+typedef struct
+{
+ uint64_t EnergyAccu; // Summe der Scheinleistung in mVA, je Messperiode aufaddiert
+ unsigned OpTicks;    // Anzahl Messperioden mit Laststrom (Betriebsstunden)
+ unsigned PowermVA;   // Scheinleistung der letzten Messperiode in mVA
+} TEnergyChannel;
+
+class EnergyMeter;
+
+extern EnergyMeter energyMeter;
+
+class EnergyMeter
+{
+public:
+ EnergyMeter(void);
+
+ /*
+  * Wird einmal je Messperiode und Kanal mit den Daten der ISR aufgerufen.
+  * SumSqr: Quadratsumme (RegSqr) des gewählten Messbereichs
+  * GainCorr: Gain-Korrektur des Messbereichs in 1.15 Festkomma
+  * LowRange: true, wenn der empfindliche Messbereich ausgewertet wird
+  */
+ void ProcessMeasPeriod(unsigned ChIdx, unsigned SumSqr, unsigned GainCorr, bool LowRange);
+
+ /*
+  * Zählerstand der Energie in Wh
+  */
+ unsigned GetEnergyWh(int chno);
+
+ /*
+  * Scheinleistung der letzten Messperiode in VA
+  */
+ unsigned GetApparentPower(int chno);
+
+ /*
+  * Betriebsstunden (Zeit mit Laststrom) in ganzen Stunden
+  */
+ unsigned GetOperatingHours(int chno);
+
+ /*
+  * Setzt die Zähler eines Kanals zurück.
+  */
+ void ResetChannel(int chno);
+
+ /*
+  * Schreibt die Zählerstände in den Speicherbereich "data", Länge ENERGYDATALEN.
+  * Die Länge der geschriebenen Daten wird zurückgegeben.
+  */
+ unsigned int GetData(void *data);
+
+ /*
+  * Liest die Zählerstände aus dem Speicherbereich "data". Fehlt die Signatur
+  * (z.B. leere Seite), starten alle Zähler bei 0.
+  */
+ unsigned int SetData(void *data);
+
+protected:
+ TEnergyChannel Channels[CHANNELCNT];
+};
+
+/*
+ * Ganzzahlige Quadratwurzel einer 64bit Zahl
+ */
+uint32_t isqrt64(uint64_t val);
+
+#endif /* ENERGYMETER_H_ */
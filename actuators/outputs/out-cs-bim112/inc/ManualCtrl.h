@@ -13,7 +13,29 @@
 #ifndef MANUALCTRL_H_
 #define MANUALCTRL_H_
 
+#include <sblib/platform.h>
 #include <config.h>
+#include <AdcIsr.h>
+
+/*
+ * Die Tasten teilen sich die Pins mit den LEDs. Abgetastet wird aus der ADC-ISR heraus
+ * (ScanIsr), im festen Raster von BUTTONSCANPERIOD ms und unabhängig davon, wie beschäftigt
+ * die Hauptschleife gerade ist. Eine Abtastung ist auf mehrere aufeinanderfolgende ISR-Aufrufe
+ * verteilt, statt wie früher mit delayMicroseconds() zu warten.
+ * Die Pins gehören während des Betriebs allein der ISR: Das Hauptprogramm hinterlegt mit
+ * UpdateLeds() nur den neuen LED-Zustand, ausgegeben wird er von der ISR zwischen zwei Abtastungen.
+ * Die entprellten Tastendrücke landen in einer kleinen Warteschlange.
+ * In der ISR bleiben bei 100kHz nur rund 480 Takte je Wandlung, daher greift ScanIsr direkt
+ * über MASKED_ACCESS und DIR auf die GPIO-Ports zu. Ports und Bitmasken der Pins werden einmal
+ * im Konstruktor bestimmt, die Pinkonfiguration (IOCON) setzt pinMode() einmalig beim Start.
+ * Auswertung und Entprellung sind ebenfalls auf mehrere ISR-Aufrufe verteilt, so dass kein
+ * Aufruf mehr als BUTTONDEBOUNCESLICE Tasten bearbeitet.
+ */
+#define BUTTONSCANPERIOD 10 // ms
+#define BUTTONSCANTICKS (ADCSAMPLEFREQ/1000*BUTTONSCANPERIOD) // in ADC-ISR Aufrufen
+#define BUTTONEVENTQUEUELEN 8 // Muss eine Zweierpotenz sein
+#define BUTTONSCANPORTS 4 // PIO0..PIO3
+#define BUTTONDEBOUNCESLICE 4 // Tasten je ISR-Aufruf beim Entprellen
 
 class ManualCtrl;
 
@@ -22,19 +44,38 @@ extern ManualCtrl manuCtrl;
 class ManualCtrl {
 public:
  ManualCtrl();
- void StartManualCtrl(void); // Liest den Tastenzustand ein und setzt diesen als aktuellen Zustand
+ void StartManualCtrl(void); // Liest den Tastenzustand ein, setzt diesen als aktuellen Zustand und startet die Abtastung in der ISR
+
+ unsigned GetButtonEvent(void); // Holt das nächste Ereignis aus der Warteschlange, 0 wenn keines vorliegt.
+ // Das Ereignis ist eine Bitmaske mit je einem gesetzten Bit für eine neu als gedrückt erkannte Taste.
 
- unsigned DoManualCtrl(void); // Muss in einem festen Zeitraster aufgerufen werden. z.B. alle 10ms
- // Liefert als Rückgabewert eine Bitmaske mit je einem gesetzten Bit für eine neu als gedrückt erkannte Taste.
+ void UpdateLeds(int newstates); // Weist den LEDs einen neuen Zustand zu, die ISR gibt ihn aus
 
- void UpdateLeds(int newstates); // Weist den LEDs einen neuen Zustand zu und gibt sie aus bei Änderung
- void SetLeds(void); // Setzt die LED-Ausgänge
+ void ScanIsr(void); // Wird von der ADC-ISR bei jeder Wandlung aufgerufen
 private:
  unsigned ReadButtons(void);
+ void SetLeds(void);
+ unsigned Debounce(unsigned first);
  int pins_def[BUTTONLEDCNT];
- int led_states;
+ byte pin_port[BUTTONLEDCNT]; // GPIO-Port des Pins
+ unsigned short pin_mask[BUTTONLEDCNT]; // Bitmaske des Pins in seinem Port
+ unsigned short port_mask[BUTTONSCANPORTS]; // Alle Tasten-/LED-Pins eines Ports
+ LPC_GPIO_TypeDef* com_port;
+ unsigned short com_mask;
+ volatile int led_states;
+ volatile unsigned short led_port_val[BUTTONSCANPORTS]; // LED-Zustand als Portwerte, von UpdateLeds() berechnet
+ volatile bool led_update;
+ unsigned short port_data[BUTTONSCANPORTS]; // Eingelesene Portwerte der letzten Abtastung
+ unsigned act_buttons;
+ unsigned btndnevent;
  unsigned button_states;
  byte button_debounce[BUTTONLEDCNT];
+ volatile bool scan_active;
+ unsigned scan_cnt;
+ byte scan_phase;
+ volatile byte event_queue[BUTTONEVENTQUEUELEN];
+ volatile byte event_wr;
+ volatile byte event_rd;
 };
 
 #endif /* MANUALCTRL_H_ */
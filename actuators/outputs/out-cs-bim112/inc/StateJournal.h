@@ -0,0 +1,111 @@
+/*
+ *  StateJournal.h - Wear levelled journal for the system state
+ *
+ *  For any further information see: inc/config.h
+ *
+ *  Copyright (C) 2018 Florian Voelzke <fvoelzke@gmx.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef STATEJOURNAL_H_
+#define STATEJOURNAL_H_
+
+#include <config.h>
+#include <Relay.h>
+#include <EnergyMeter.h>
+
+/*
+ * Der Systemzustand wird bei Busspannungsausfall, Reset und Download abgespeichert. Bisher
+ * wurde dafür immer dieselbe MemMapper-Seite neu geschrieben. Das Journal hängt stattdessen
+ * jeden Datensatz an, reihum über mehrere Flash-Sektoren verteilt:
+ * - Ein Datensatz belegt genau einen Slot (Vielfaches der Flash-Page von 256 Byte), das Schreiben
+ *   ist also ein einziger IAP-Programmiervorgang ohne Löschen.
+ * - Jeder Datensatz hat eine fortlaufende Sequenznummer und eine CRC (crc8.h). Beim Start wird der
+ *   gültige Datensatz mit der höchsten Sequenznummer verwendet. Ein beim Spannungsausfall nur
+ *   teilweise geschriebener Slot fällt durch die CRC und wird übersprungen.
+ * - Das Löschen des nächsten Sektors erfolgt vorab, wenn genug Energie vorhanden ist
+ *   (PrepareNextSlot), nicht im Zeitfenster des Spannungsausfalls.
+ *
+ * Aufbau eines Slots:
+ * Byte 0: JOURNALMAGIC, Bit 0 gelöscht wenn die CRC sonst 0xFF ergäbe
+ * Byte 1..4: Sequenznummer, little endian
+ * Byte 5..6: Länge der Nutzdaten, little endian
+ * Byte 7..: Nutzdaten
+ * Danach 1 Byte CRC über Byte 0 bis Ende der Nutzdaten
+ */
+
+#ifndef OMITCURRFCT
+#define JOURNALENERGYLEN ENERGYDATALEN
+#else
+#define JOURNALENERGYLEN 0
+#endif
+
+// Nutzdaten aus Appl::StoreApplData(): Speichergrund, je Kanal 18 Byte, Relaisdaten, Energiezähler
+#define JOURNALPAYLOADLEN (1+18*CHANNELCNT+4*RELAYBUFLEN+JOURNALENERGYLEN)
+#define JOURNALHEADERLEN 7
+#define JOURNALPAGESIZE 256
+#define JOURNALSLOTSIZE (((JOURNALHEADERLEN+JOURNALPAYLOADLEN+1)+JOURNALPAGESIZE-1)/JOURNALPAGESIZE*JOURNALPAGESIZE)
+
+#define JOURNALFLASHSTART 0xC000 // Die zwei Sektoren unterhalb des MemMapper-Sektors (0xE000-0xEFFF), im Linkerskript (linkscripts/memory.ldt) für das Programm gesperrt
+#define JOURNALSECTORSIZE 4096
+#define JOURNALSECTORCNT 2
+#define JOURNALSLOTSPERSECTOR (JOURNALSECTORSIZE/JOURNALSLOTSIZE)
+#define JOURNALSLOTCNT (JOURNALSLOTSPERSECTOR*JOURNALSECTORCNT)
+
+#define JOURNALMAGIC 0xA5 // Bit 0 muss gesetzt sein
+
+class StateJournal;
+
+extern StateJournal journal;
+
+class StateJournal
+{
+public:
+ StateJournal(void);
+ virtual ~StateJournal() {};
+
+ /*
+  * Durchsucht den Flash-Bereich nach dem neuesten gültigen Datensatz und kopiert dessen
+  * Nutzdaten in den Puffer. Gibt es keinen, wird der Puffer mit 0xFF gefüllt
+  * (wie eine leere Flash-Seite).
+  */
+ void Init(void);
+
+ /*
+  * Puffer für die Nutzdaten (JOURNALPAYLOADLEN Byte). Enthält nach Init() die zuletzt
+  * gespeicherten Daten und nach Commit() die zuletzt geschriebenen.
+  */
+ byte* Buffer(void);
+
+ /*
+  * Hängt die ersten "len" Byte des Puffers als neuen Datensatz an. Ist der nächste Slot
+  * noch nicht vorbereitet, wird zuvor gelöscht (nur ohne vorherigen PrepareNextSlot()).
+  */
+ bool Commit(unsigned len);
+
+ /*
+  * Löscht den nächsten zu beschreibenden Sektor, falls notwendig. Sollte immer dann
+  * aufgerufen werden, wenn ausreichend Energie zur Verfügung steht.
+  */
+ void PrepareNextSlot(void);
+
+protected:
+ // Zugriff auf den Flash, für den Test auf dem Host überschreibbar
+ virtual bool EraseSector(unsigned SectorIdx);
+ virtual bool ProgramSlot(unsigned SlotIdx, const byte *data);
+ virtual const byte* SlotPtr(unsigned SlotIdx);
+
+ bool SlotValid(unsigned SlotIdx, unsigned &Seq);
+ bool SlotErased(unsigned SlotIdx);
+ bool SectorErased(unsigned SectorIdx);
+ void SkipUsedSlots(void);
+
+ unsigned NextSlot; // Der nächste zu beschreibende Slot
+ unsigned NextSeq;  // Sequenznummer des nächsten Datensatzes
+ byte SlotBuf[JOURNALSLOTSIZE] __attribute__ ((aligned (4))); // IAP programmiert aus einem wortausgerichteten RAM-Puffer
+};
+
+#endif /* STATEJOURNAL_H_ */
@@ -1,9 +1,13 @@
+#ifndef COM_OBJS_H_
+#define COM_OBJS_H_
+
 #define OFSGENERALOBJECTS 0
 
 #define OBJ_OPERATIONAL 0  // 1 bit   - Tx - Trigger - In Operation, sendet "1"
 #define OBJ_SAFETYPRIO1 1  // 1 bit   - Rx - Trigger - Safety Priority 1 Objekt, erwarteter Wert abh. von Konfig
 #define OBJ_SAFETYPRIO2 2  // 1 bit   - Rx - Trigger - Safety Priority 2 Objekt, erwarteter Wert abh. von Konfig
 #define OBJ_SAFETYPRIO3 3  // 1 bit   - Rx - Trigger - Safety Priority 3 Objekt, erwarteter Wert abh. von Konfig
+#define OBJ_ENERGYRESET 4  // 1 Byte  - Rx - Trigger - Energiezähler und Betriebsstunden zurücksetzen: 0 alle Kanäle, 1..CHANNELCNT nur dieser Kanal
 
 #define OFSCHANNELOBJECTS 10
 #define SPACINGCHANNELOBJECTS 20
@@ -21,12 +25,22 @@
 #define OBJ_FORCEDOP   10  // 1 o. 2 bit  - Rx - Zustand - Zwangsposition aktivieren/deaktivieren
 #define OBJ_THRESHOLD  11  // 1 o. 2 Byte - Rx - Zustand - Der überwachte Wert der Schwellwertfunktionalität
 #define OBJ_CHGTHRESH1 12  // 1 o. 2 Byte - Rx - Zustand - Schwellwert 1 der Schwellwertfunktionalität ändern
+#define OBJ_ENERGY     13  // 4 Byte  -TxRd- Zustand - Scheinenergie in Wh (VAh, DPT13.011), wird mit dem zyklischen Stromwert gesendet
+#define OBJ_OPHOURS    14  // 2 Byte  -TxRd- Zustand - Betriebsstunden (Zeit mit Laststrom) in h (DPT7.007), wird mit dem zyklischen Stromwert gesendet
+// Die Objekte 4, 13 und 14 sind in der ABB-Produktdatenbank unbenutzt, sie müssen in der verwendeten Datenbank angelegt sein.
 #define OBJ_CONTACTMON 15  // 1 bit   -TxRd- Zustand - Kontaktüberwachung, "1" bei Strommesswert > 30mA bei geöffnetem Kontakt
 #define OBJ_CURRENT    16  // 2 o. 4 Byte -TxRd- Zustand - Strommesswert in gewählter Datendarstellung, kann auch gelesen werden
 #define OBJ_STATECTH1  17  // 1 bit   -TxRd- Zustand - Ergebnis des Vergleichs gemessener Strom - Stromschwelle 1, kann auch gelesen werden
 #define OBJ_STATECTH2  18  // 1 bit   -TxRd- Zustand - Ergebnis des Vergleichs gemessener Strom - Stromschwelle 2, kann auch gelesen werden
 #define OBJ_STATESW    19  // 1 bit   - Tx - Zustand - Rückmeldung Schaltzustand
 
+// Für die Scheinleistung ist kein Kanalobjekt frei. Ihre Objekte folgen auf die Kanalobjekte des nachgebildeten Geräts,
+// Objektnummer = OFSPOWEROBJECTS + (Kanal-1). Wie die Objekte 4, 13 und 14 müssen sie in der verwendeten Datenbank
+// angelegt sein. Beim 12-Kanal-Gerät ist hinter den Kanalobjekten kein Platz mehr (höchstens 255 Objekte).
+#define OFSPOWEROBJECTS (OFSCHANNELOBJECTS+DEVICECHANNELCNT*SPACINGCHANNELOBJECTS)
+// 2 Byte  -TxRd- Zustand - Scheinleistung in VA (DPT7.001), Nennspannung mal Strom, wird mit dem zyklischen Stromwert gesendet
+#define POWEROBJECTSFIT ((OFSPOWEROBJECTS+CHANNELCNT) <= 255)
+
 /*
 ab Zeile 4174
 OBJEKTE
@@ -446,3 +460,5 @@ Schaltaktor
 #define APP_TELRATELIMIT_O   786 // Telegrammratenbegrenzung, max Telegramme je Sekunde
 #define APP_TELRATELIMIT_B     0 //  1: 1, 2: 2, 3: 3, 5: 5, 10: 10, 20: 20, 255: ohne Begrenzung
 #define APP_TELRATELIMIT_M  0xff
+
+#endif /* COM_OBJS_H_ */
@@ -41,12 +41,20 @@
  * Es sollte die Applikation in der Version 3.2 verwendet werden.
  * Bitte beachten: Der Kanalmodus "Heizungsaktor" wird nicht unterstützt.
  *
- * Important: The compiled firmware (Sblib + Application) must not exceed the size 0xEA00!
+ * Important: The compiled firmware (Sblib + Application) must not exceed the size 0xC000!
+ * The state journal starts there, the linker script (linkscripts/memory.ldt) enforces the limit.
+ * Compared to the former limit of 0xEA00 this leaves 10.5 kB less for the program: 48 kB from 0x0000,
+ * 36 kB with the bootloader (build configurations "Flashstart 0x3000"). Check the usage of the
+ * region "Flash" printed by the linker when the firmware grows.
  * =========
  * As a result one or both of the Sblib or Application must be compiled with significant optimization.
  * (Tested with -O3)
  *
- * Wichtig: Die übersetzte Firmware (Sblib + Applikation) darf nicht größer als 0xEA00 werden!
+ * Wichtig: Die übersetzte Firmware (Sblib + Applikation) darf nicht größer als 0xC000 werden!
+ * Dort beginnt das Journal der Systemzustände, das Linkerskript (linkscripts/memory.ldt) prüft die Grenze.
+ * Gegenüber der früheren Grenze 0xEA00 bleiben dem Programm 10,5 kB weniger: 48 kB ab 0x0000,
+ * 36 kB mit Bootloader (Buildkonfigurationen "Flashstart 0x3000"). Wächst die Firmware, die vom
+ * Linker ausgegebene Belegung der Region "Flash" prüfen.
  * =======
  * Das bedeutet, dass ein oder beide von Sblib und Applikation mit weitgehenden Optimierungen übersetzt werden müssen.
  * (Getestet mit -O3)
@@ -317,11 +325,13 @@
 #ifndef HW_2CH_WO_CS
 // mit Strommessung
 #define DEVICETYPE 0xA05B // SA/S2.16.6.1
+#define DEVICECHANNELCNT 2 // Anzahl Kanäle des nachgebildeten Geräts
 #define SPIRELDRIVERBYTES 1
 #define ADCCHANNELCNT 4
 #else
 //ohne Strommessung
 #define DEVICETYPE 0xA080 // SA/S2.16.2.1
+#define DEVICECHANNELCNT 2 // Anzahl Kanäle des nachgebildeten Geräts
 #define SPIRELDRIVERBYTES 1
 #define ADCCHANNELCNT 4
 #define OMITCURRFCT // Omit current functions to free some flash mem
@@ -330,6 +340,7 @@
 #elif CHANNELCNT <= 4
 
 #define DEVICETYPE 0xA05C // SA/S4.16.6.1
+#define DEVICECHANNELCNT 4 // Anzahl Kanäle des nachgebildeten Geräts
 #define SPIRELDRIVERBYTES 1
 #define ADCCHANNELCNT 4
 // 10 Wandlungen je Loop, 50kHz Samplefreq
@@ -338,12 +349,14 @@
 #ifndef HW_8CH_WO_CS
 //mit Strommessung
 #define DEVICETYPE 0xA05D // SA/S8.16.6.1
+#define DEVICECHANNELCNT 8 // Anzahl Kanäle des nachgebildeten Geräts
 #define SPIRELDRIVERBYTES 2
 #define ADCCHANNELCNT 8
 // 20 Wandlungen je Loop, 100kHz Samplefreq
 #else
 //ohne Strommessung
 #define DEVICETYPE 0xA082 // SA/S8.16.2.1
+#define DEVICECHANNELCNT 8 // Anzahl Kanäle des nachgebildeten Geräts
 #define SPIRELDRIVERBYTES 3
 #define ADCCHANNELCNT 8
 #define OMITCURRFCT // Omit current functions to free some flash mem
@@ -352,6 +365,7 @@
 #elif CHANNELCNT <= 12
 
 #define DEVICETYPE 0xA05E // SA/S12.16.6.1
+#define DEVICECHANNELCNT 12 // Anzahl Kanäle des nachgebildeten Geräts
 #define SPIRELDRIVERBYTES 3
 #define ADCCHANNELCNT 8
 // 30 Wandlungen je Loop, 96kHz Samplefreq
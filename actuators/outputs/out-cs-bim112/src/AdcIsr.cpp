@@ -22,6 +22,8 @@
 #include <sblib/platform.h>
 #include <config.h>
 #include <AdcIsr.h>
+#include <EnergyMeter.h>
+#include <ManualCtrl.h>
 
 #if (BUFSIZE*8) > 32767
 #error BUFSIZE*8 too great for data type of IsrData.OffsIntegral!
@@ -401,6 +403,9 @@ extern "C" __attribute__((optimize("O3"))) void ADC_IRQHandler (void)
   }
  }
  IsrData.ActChIdx = NextIndex;
+#if BUTTONLEDCNT > 0
+ manuCtrl.ScanIsr(); // Tastenabtastung im festen Raster, unabhängig von der Hauptschleife
+#endif
 #ifdef PIODBGISRFLAG
  digitalWrite(PIODBGISRFLAG, false);
 #endif
@@ -452,6 +457,9 @@ void pwmSetup(void)
 */
 void pwmEnable(bool ena)
 {
+ // pinMode() verändert DIR des Ports per Read-Modify-Write, das darf sich nicht mit
+ // der Tastenabtastung in der ADC-ISR (ManualCtrl::ScanIsr) überschneiden.
+ noInterrupts();
  if (ena)
  {
   pinMode(PIORELPWM, OUTPUT_MATCH);
@@ -459,6 +467,7 @@ void pwmEnable(bool ena)
   digitalWrite(PIORELPWM, true); // Treiber inaktiv bei high Pegel
   pinMode(PIORELPWM, OUTPUT);
  }
+ interrupts();
 }
 
 void IsrSetup(void)
@@ -516,11 +525,13 @@ void AdcIsrCurrFilt(void)
      (float)IsrData.RegSqr[(ChIdx << 1)+1] *
      Square((float)IsrData.GainCorr[(ChIdx << 1)+1]) *
      Square((float)MAXCURRLOWRANGE/512/32768);
+   energyMeter.ProcessMeasPeriod(ChIdx, IsrData.RegSqr[(ChIdx << 1)+1], IsrData.GainCorr[(ChIdx << 1)+1], true);
   } else { // High-Range benutzen
    IsrData.CurrSqrVals[ChIdx][0] =
      (float)IsrData.RegSqr[ChIdx << 1] *
      Square((float)IsrData.GainCorr[ChIdx << 1]) *
      Square((float)MAXCURRHIGHRANGE/512/32768);
+   energyMeter.ProcessMeasPeriod(ChIdx, IsrData.RegSqr[ChIdx << 1], IsrData.GainCorr[ChIdx << 1], false);
   }
   ChCurr += IsrData.CurrSqrVals[ChIdx][0];
   IsrData.CurrentVal[ChIdx] = sqrt(ChCurr * (0.25f / (float)BUFSIZE)); // Strom in A
@@ -20,6 +20,8 @@
 #include <app_main.h>
 #include <AdcIsr.h>
 #include <crc8.h>
+#include <EnergyMeter.h>
+#include <StateJournal.h>
 
 // System time in milliseconds (from timer.cpp)
 extern volatile unsigned int systemTime;
@@ -138,6 +140,7 @@ Appl::Appl(void)
 {
  ActuatorSafety = 0;
  RestartSkipBvrMask = 0;
+ ClearObjDispatchTable();
 }
 
 void Appl::StartupSafetyAndForcedPos(void)
@@ -512,7 +515,8 @@ void Appl::RecallAppData(UsrCallbackType callbackType)
 {
  byte* StoragePtr;
  unsigned referenceTime = systemTime;
- StoragePtr = memMapper.memoryPtr(0, false);
+ journal.Init(); // Sucht den neuesten gültigen Datensatz
+ StoragePtr = journal.Buffer();
  byte StorageReason = *StoragePtr++;
  if ((StorageReason != 0) && (StorageReason != 255)) // Ansonsten würde da etwas gar nicht stimmen (Sektor leer zB)
  {
@@ -537,9 +541,15 @@ void Appl::RecallAppData(UsrCallbackType callbackType)
     {
      ModifyChStateAfterBusVoltageRecovery(chno);
     }
+   } else {
+    // Nicht als Schaltausgang konfiguriert, StoreApplData() hat 18 Byte Dummydaten abgelegt
+    StoragePtr += 18;
    }
   }
   StoragePtr += relay.SetData((void *)StoragePtr);
+#ifndef OMITCURRFCT
+  StoragePtr += energyMeter.SetData((void *)StoragePtr);
+#endif
  } else {
   // Es wird keine Konfiguration gelesen, nur Defaultzustände wiederherstellen
   for (int chno = 0; chno < CHANNELCNT; chno++)
@@ -562,9 +572,8 @@ void Appl::StoreApplData(UsrCallbackType callbackType)
 {
  byte* StoragePtr;
  unsigned referenceTime = systemTime;
- // Kann der Mapper überhaupt die Seite 0 mappen? Checken!
- memMapper.writeMem(0, 0); // writeMem() aktiviert die passende Speicherseite, entgegen zu memoryPtr()
- StoragePtr = memMapper.memoryPtr(0, false);
+ // Der Puffer des Journals enthält noch die zuletzt gespeicherten Daten (für die CRC der Kanalkonfiguration)
+ StoragePtr = journal.Buffer();
  *StoragePtr++ = (uint8_t) callbackType; // Der Grund für das Speichern wird auch abgelegt. Vielleicht ganz nützlich.
  for (int chno = 0; chno < CHANNELCNT; chno++)
  {
@@ -598,7 +607,10 @@ void Appl::StoreApplData(UsrCallbackType callbackType)
   }
  }
  StoragePtr += relay.GetData((void *)StoragePtr);
- memMapper.doFlash();
+#ifndef OMITCURRFCT
+ StoragePtr += energyMeter.GetData((void *)StoragePtr);
+#endif
+ journal.Commit(StoragePtr - journal.Buffer()); // Ein einziger Schreibvorgang, der Sektor ist bereits gelöscht
 }
 
 // Zustand des Kanals, noch vor einer evtl. gewählten Ausgangsinvertierung
@@ -827,24 +839,25 @@ void Appl::ProcessThresholds(int chno, TStateAndTrigger &Trigger)
  }
 }
 
-TStateAndTrigger Appl::ProcessSwitchObj(int objno, int chno)
+TStateAndTrigger Appl::ProcessSwitchObj(ObjHandler handler, int objno, int chno)
 {
  TStateAndTrigger Result = {false, false, false, false};
+ if (handler == ObjHandler::ChannelObj)
+  return Result;
  unsigned value = ChObjectRead(chno, objno);
- switch (objno)
+ switch (handler)
  {
   //=================
- case OBJ_SWITCH: // Einfach nur schalten...
+ case ObjHandler::Switch: // Einfach nur schalten...
   //=================
   Result.Sw = true;
   Result.SwOnOff = (value != 0);
   Result.Evaluated = true;
   break;
  //=================
- case OBJ_CALLPRESET: // Einen Preset aufrufen (je nach Konf kann dies auch lediglich einen Preset selber verändern)
+ case ObjHandler::CallPreset: // Einen Preset aufrufen (je nach Konf kann dies auch lediglich einen Preset selber verändern)
   //=================
-  // Preset-Funktion freigeschaltet?
-  if (ReadChConfigByte(chno, APP_ENAFUNCPRESET_O) & APP_ENAFUNCPRESET_M)
+  // Preset-Funktion freigeschaltet (sonst wäre der Handler ChannelObj)
   {
    if (value) // Ist es Preset 2? (Wert 1 -> Preset 2)
    {
@@ -897,11 +910,10 @@ TStateAndTrigger Appl::ProcessSwitchObj(int objno, int chno)
   }
   break;
   //=================
- case OBJ_SETPRESET: // Setzen der Presetwerte mittels Bustelegramm
+ case ObjHandler::SetPreset: // Setzen der Presetwerte mittels Bustelegramm
   //=================
   // Löst also als Reaktion nie einen Schaltvorgang aus
-  // Preset-Funktion freigeschaltet?
-  if (ReadChConfigByte(chno, APP_ENAFUNCPRESET_O) & APP_ENAFUNCPRESET_M)
+  // Preset-Funktion freigeschaltet (sonst wäre der Handler ChannelObj)
   {
    if (value) // Ist es Preset 2? (Wert 1 -> Preset 2)
    {
@@ -917,11 +929,10 @@ TStateAndTrigger Appl::ProcessSwitchObj(int objno, int chno)
   }
   break;
   //=================
- case OBJ_SCENE: // Szene aufrufen oder speichern
+ case ObjHandler::Scene: // Szene aufrufen oder speichern
   //=================
   // value: Bit 7: "0" aufrufen, "1" speichern. Bit 6: don't care. Bit 5..0: Szenenummer-1
-  // Szenen-Funktion freigeschaltet?
-  if (ReadChConfigByte(chno, APP_ENAFUNCSCENE_O) & APP_ENAFUNCSCENE_M)
+  // Szenen-Funktion freigeschaltet (sonst wäre der Handler ChannelObj)
   {
    bool store = (value & 0x80);
    value &= 63;
@@ -952,24 +963,13 @@ TStateAndTrigger Appl::ProcessSwitchObj(int objno, int chno)
   }
   break;
   //=================
- case OBJ_THRESHOLD:
+ case ObjHandler::Threshold: // OBJ_THRESHOLD und OBJ_CHGTHRESH1
   //=================
-  // Threshold-Funktion freigeschaltet?
-  if (ReadChConfigByte(chno, APP_ENAFUNTHRESH_O) & APP_ENAFUNTHRESH_M)
-  {
-   //ChannelStates[chno].OldTreshVal = value; Wert wird direkt aus dem Objekt gelesen
-   ProcessThresholds(chno, Result);
-  }
+  // Threshold-Funktion freigeschaltet (sonst wäre der Handler ChannelObj)
+  // Sowohl der überwachte Wert als auch Threshold1 werden direkt aus den Objekten gelesen
+  ProcessThresholds(chno, Result);
   break;
-  //=================
- case OBJ_CHGTHRESH1:
-  //=================
-  // Threshold-Funktion freigeschaltet?
-  if (ReadChConfigByte(chno, APP_ENAFUNTHRESH_O) & APP_ENAFUNTHRESH_M)
-  {
-   //ChannelStates[chno].Threshold1 = value; Wert wird direkt aus dem Objekt gelesen
-   ProcessThresholds(chno, Result);
-  }
+ default:
   break;
  }
  if (Result.Sw)
@@ -1821,6 +1821,43 @@ void Appl::OneCurrThresholdFct(int chno, float IMeas, int fctno)
 #endif
 }
 
+void Appl::UpdateEnergyObjects(int chno, bool Send)
+{
+#ifndef OMITCURRFCT
+ unsigned Hours = energyMeter.GetOperatingHours(chno);
+ if (Hours > 0xffff) // 2 Byte Objekt, nach 7,5 Jahren Laststrom
+  Hours = 0xffff;
+ if (Send)
+ {
+  ChObjectWrite(chno, OBJ_ENERGY, energyMeter.GetEnergyWh(chno));
+  ChObjectWrite(chno, OBJ_OPHOURS, Hours);
+#if POWEROBJECTSFIT
+  bcu.comObjects->objectWrite(OFSPOWEROBJECTS+chno, energyMeter.GetApparentPower(chno));
+#endif
+ } else {
+  ChObjectUpdate(chno, OBJ_ENERGY, energyMeter.GetEnergyWh(chno));
+  ChObjectUpdate(chno, OBJ_OPHOURS, Hours);
+#if POWEROBJECTSFIT
+  bcu.comObjects->objectUpdate(OFSPOWEROBJECTS+chno, energyMeter.GetApparentPower(chno));
+#endif
+ }
+#endif
+}
+
+void Appl::EnergyResetObjRelated(int objno)
+{
+#ifndef OMITCURRFCT
+ unsigned ChSel = bcu.comObjects->objectRead(objno);
+ for (int chno=0; chno < CHANNELCNT; chno++)
+ {
+  if ((ChSel != 0) && (ChSel != (unsigned)chno+1))
+   continue;
+  energyMeter.ResetChannel(chno);
+  UpdateEnergyObjects(chno, AppObjSendEnabled());
+ }
+#endif
+}
+
 // Aufruf wenn neue Strommesswerte zur Verfügung stehen
 void Appl::CurrentFunctions(unsigned referenceTime)
 {
@@ -1858,6 +1895,8 @@ void Appl::CurrentFunctions(unsigned referenceTime)
      SendStatus = true;
     }
    }
+   // Energie und Betriebsstunden werden nur zyklisch gesendet, nicht bei Stromänderung
+   bool SendEnergy = SendStatus && AppObjSendEnabled();
    unsigned short IConf = ReadChConfigByte(chno, APP_CURRCHGSNDVAL_O);
    // Stromänderung, nach der gesendet wird, in 25mA Inkrementen. 0 bedeutet nicht senden.
    if (IConf)
@@ -1889,6 +1928,7 @@ void Appl::CurrentFunctions(unsigned referenceTime)
      ChObjectUpdate(chno, OBJ_CURRENT, int(IObj*1000));
     }
    }
+   UpdateEnergyObjects(chno, SendEnergy);
    if (SendStatus)
    {
     ChannelStates[chno].CFStatusTime = CnfStatTime*RMSCURRENTVALUESPERSECOND;
@@ -2151,7 +2191,7 @@ void Appl::ManualControl(unsigned ButtonDownEvents)
 }
 
 // Wird nach Update der globalen Sicherheitsfunktionen aufgerufen, sowohl bjekt-, als auch zeitbasiert.
-// Das Zwangsführungsobjekt wird ganz normal im ProcessChannelObj Kontext bearbeitet, also nicht hier
+// Das Zwangsführungsobjekt wird ganz normal als Kanalobjekt bearbeitet, also nicht hier
 void Appl::ProcessSafetyChanges(unsigned SafetyChanges)
 {
  TStateAndTrigger trigger;
@@ -2268,37 +2308,89 @@ void Appl::GlobalSafetyObjRelated(int obj, unsigned referenceTime)
  }
 }
 
-void Appl::ProcessChannelObj(int chno, int objno, unsigned referenceTime)
+void Appl::ClearObjDispatchTable(void)
 {
- if ((ReadChConfigByte(chno, APP_OPMODE_O) & APP_OPMODE_M) == 1) // Schaltaktor
-  {
-  TStateAndTrigger trigger;
-  trigger = ProcessSwitchObj(objno, chno);
-  // Der Rest ist in eine Funktion ausgelagert, damit auch die Strommessung ein Trigger-Objekt generieren kann
-  PostProcessSingleSwitchObject(chno, trigger, objno, referenceTime);
+ for (int objno=0; objno < OBJDISPATCHLEN; objno++)
+ {
+  ObjDispatch[objno].Handler = ObjHandler::None;
+  ObjDispatch[objno].chno = 0;
+  ObjDispatch[objno].objofs = 0;
  }
 }
 
-void Appl::objectUpdated(int objno, unsigned referenceTime)
+void Appl::BuildObjDispatchTable(void)
 {
- if (objno >= OFSGENERALOBJECTS)
+ ClearObjDispatchTable();
+ ObjDispatch[OBJ_SAFETYPRIO1].Handler = ObjHandler::GlobalSafety;
+ ObjDispatch[OBJ_SAFETYPRIO2].Handler = ObjHandler::GlobalSafety;
+ ObjDispatch[OBJ_SAFETYPRIO3].Handler = ObjHandler::GlobalSafety;
+#ifndef OMITCURRFCT
+ ObjDispatch[OBJ_ENERGYRESET].Handler = ObjHandler::EnergyReset;
+#endif
+ for (int chno = 0; chno < CHANNELCNT; chno++)
  {
-  if (objno < OFSCHANNELOBJECTS)
+  if ((ReadChConfigByte(chno, APP_OPMODE_O) & APP_OPMODE_M) != 1) // kein Schaltaktor
+   continue;
+  bool PresetEna = (ReadChConfigByte(chno, APP_ENAFUNCPRESET_O) & APP_ENAFUNCPRESET_M) != 0;
+  bool SceneEna = (ReadChConfigByte(chno, APP_ENAFUNCSCENE_O) & APP_ENAFUNCSCENE_M) != 0;
+  bool ThreshEna = (ReadChConfigByte(chno, APP_ENAFUNTHRESH_O) & APP_ENAFUNTHRESH_M) != 0;
+  TObjDispatch *Entry = &ObjDispatch[OFSCHANNELOBJECTS+chno*SPACINGCHANNELOBJECTS];
+  for (int objofs = 0; objofs < SPACINGCHANNELOBJECTS; objofs++, Entry++)
   {
-   // General objects
-   GlobalSafetyObjRelated(objno, referenceTime);
-  } else {
-   // Channel specific objects
-   objno -= OFSCHANNELOBJECTS;
-   int chno = objno/SPACINGCHANNELOBJECTS;
-   objno -= chno*SPACINGCHANNELOBJECTS;
-   if (chno < CHANNELCNT)
+   Entry->chno = chno;
+   Entry->objofs = objofs;
+   // Alle Kanalobjekte durchlaufen mindestens Logik, Zeitfkt, Dauer-Ein und Sicherheit
+   Entry->Handler = ObjHandler::ChannelObj;
+   switch (objofs)
    {
-    ProcessChannelObj(chno, objno, referenceTime);
+   case OBJ_SWITCH:
+    Entry->Handler = ObjHandler::Switch;
+    break;
+   case OBJ_CALLPRESET:
+    if (PresetEna)
+     Entry->Handler = ObjHandler::CallPreset;
+    break;
+   case OBJ_SETPRESET:
+    if (PresetEna)
+     Entry->Handler = ObjHandler::SetPreset;
+    break;
+   case OBJ_SCENE:
+    if (SceneEna)
+     Entry->Handler = ObjHandler::Scene;
+    break;
+   case OBJ_THRESHOLD:
+   case OBJ_CHGTHRESH1:
+    if (ThreshEna)
+     Entry->Handler = ObjHandler::Threshold;
+    break;
    }
   }
- } else {
-  // Da die OFSGENERALOBJECTS bei 0 anfangen, währen das hier negative Objektnummern -> gar nichts machen
+ }
+}
+
+void Appl::objectUpdated(int objno, unsigned referenceTime)
+{
+ if ((objno < 0) || (objno >= OBJDISPATCHLEN))
+  return;
+ TObjDispatch *Entry = &ObjDispatch[objno];
+ switch (Entry->Handler)
+ {
+ case ObjHandler::None:
+  break;
+ case ObjHandler::GlobalSafety:
+  GlobalSafetyObjRelated(objno, referenceTime);
+  break;
+ case ObjHandler::EnergyReset:
+  EnergyResetObjRelated(objno);
+  break;
+ default:
+  { // Channel specific objects
+   TStateAndTrigger trigger;
+   trigger = ProcessSwitchObj(Entry->Handler, Entry->objofs, Entry->chno);
+   // Der Rest ist in eine Funktion ausgelagert, damit auch die Strommessung ein Trigger-Objekt generieren kann
+   PostProcessSingleSwitchObject(Entry->chno, trigger, Entry->objofs, referenceTime);
+  }
+  break;
  }
 }
 
@@ -0,0 +1,131 @@
+/*
+ *  EnergyMeter.cpp - Energy, apparent power and operating hours per channel
+ *
+ *  For any further information see: inc/config.h
+ *
+ *  Copyright (C) 2018 Florian Voelzke <fvoelzke@gmx.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <EnergyMeter.h>
+
+EnergyMeter energyMeter;
+
+// Bitweise Wurzelberechnung, kommt ohne Division aus (der M0 hat keinen Hardwaredividierer)
+uint32_t isqrt64(uint64_t val)
+{
+ uint64_t res = 0;
+ uint64_t bit = (uint64_t)1 << 62;
+ while (bit > val)
+  bit >>= 2;
+ while (bit != 0)
+ {
+  if (val >= res + bit)
+  {
+   val -= res + bit;
+   res = (res >> 1) + bit;
+  } else {
+   res >>= 1;
+  }
+  bit >>= 2;
+ }
+ return (uint32_t)res;
+}
+
+EnergyMeter::EnergyMeter(void)
+{
+ for (int chno=0; chno < CHANNELCNT; chno++)
+  ResetChannel(chno);
+}
+
+void EnergyMeter::ProcessMeasPeriod(unsigned ChIdx, unsigned SumSqr, unsigned GainCorr, bool LowRange)
+{
+ if (ChIdx >= CHANNELCNT)
+  return;
+ // Quadratmittelwert mit 32 Nachkommabits, daraus der Effektivwert in Digits mit 16 Nachkommabits.
+ // SumSqr ist ein 32bit Wert, die Verschiebung kann also nicht überlaufen.
+ uint64_t RmsQ16 = isqrt64(((uint64_t)SumSqr << 32) / BUFSIZE);
+ // Max. 2^26 * 2^16 * 2^16 = 2^58, passt in 64bit
+ uint64_t CurruA = (RmsQ16 * GainCorr * (LowRange ? ENERGYCURRSCALELOW : ENERGYCURRSCALEHIGH)) >> 31;
+ TEnergyChannel *Ch = &Channels[ChIdx];
+ if (CurruA < ENERGYMINCURRENT*1000)
+ {
+  Ch->PowermVA = 0;
+  return;
+ }
+ // Scheinleistung dieser Messperiode in mVA
+ Ch->PowermVA = (unsigned)((CurruA * ENERGYMAINSVOLTAGE) / 1000);
+ Ch->EnergyAccu += Ch->PowermVA;
+ Ch->OpTicks++;
+}
+
+unsigned EnergyMeter::GetEnergyWh(int chno)
+{
+ return (unsigned)(Channels[chno].EnergyAccu / ENERGYACCUPERWH);
+}
+
+unsigned EnergyMeter::GetApparentPower(int chno)
+{
+ return (Channels[chno].PowermVA + 500) / 1000;
+}
+
+unsigned EnergyMeter::GetOperatingHours(int chno)
+{
+ return Channels[chno].OpTicks / ENERGYTICKSPERHOUR;
+}
+
+void EnergyMeter::ResetChannel(int chno)
+{
+ Channels[chno].EnergyAccu = 0;
+ Channels[chno].OpTicks = 0;
+ Channels[chno].PowermVA = 0;
+}
+
+unsigned int EnergyMeter::GetData(void *data)
+{
+ byte* ptr=(byte *)data;
+ *ptr++ = ENERGYSIGNATURE;
+ for (int chno=0; chno < CHANNELCNT; chno++)
+ {
+  uint64_t Accu = Channels[chno].EnergyAccu;
+  for (unsigned i=0; i<8; i++) // 8 Byte, little endian
+  {
+   *ptr++ = Accu & 0xff;
+   Accu >>= 8;
+  }
+  unsigned Ticks = Channels[chno].OpTicks;
+  for (unsigned i=0; i<4; i++) // 4 Byte
+  {
+   *ptr++ = Ticks & 0xff;
+   Ticks >>= 8;
+  }
+ }
+ return ENERGYDATALEN;
+}
+
+unsigned int EnergyMeter::SetData(void *data)
+{
+ byte* ptr=(byte *)data;
+ if (*ptr++ != ENERGYSIGNATURE)
+ {
+  for (int chno=0; chno < CHANNELCNT; chno++)
+   ResetChannel(chno);
+  return ENERGYDATALEN;
+ }
+ for (int chno=0; chno < CHANNELCNT; chno++)
+ {
+  uint64_t Accu = 0;
+  for (unsigned i=0; i<8; i++)
+   Accu |= (uint64_t)*ptr++ << (8*i);
+  unsigned Ticks = 0;
+  for (unsigned i=0; i<4; i++)
+   Ticks |= (unsigned)*ptr++ << (8*i);
+  Channels[chno].EnergyAccu = Accu;
+  Channels[chno].OpTicks = Ticks;
+  Channels[chno].PowermVA = 0;
+ }
+ return ENERGYDATALEN;
+}
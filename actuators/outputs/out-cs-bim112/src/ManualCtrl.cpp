@@ -40,6 +40,23 @@ ManualCtrl::ManualCtrl() {
 #if BUTTONLEDCNT >= 8
  pins_def[7] = BUTTONLEDCH8;
 #endif
+ // Ports und Bitmasken für den direkten Registerzugriff in der ISR
+ for (int port=0; port < BUTTONSCANPORTS; port++)
+ {
+  port_mask[port] = 0;
+  led_port_val[port] = 0;
+ }
+ for (int cnt=0; cnt < BUTTONLEDCNT; cnt++)
+ {
+  pin_port[cnt] = digitalPinToPort(pins_def[cnt]);
+  pin_mask[cnt] = digitalPinToBitMask(pins_def[cnt]);
+  port_mask[pin_port[cnt]] |= pin_mask[cnt];
+ }
+#if BUTTONLEDCNT > 0
+ com_port = gpioPorts[digitalPinToPort(BUTTONLEDCOM)];
+ com_mask = digitalPinToBitMask(BUTTONLEDCOM);
+#endif
+ scan_active = false;
 }
 
 void ManualCtrl::StartManualCtrl(void)
@@ -49,10 +66,19 @@ void ManualCtrl::StartManualCtrl(void)
  digitalWrite(BUTTONLEDCOM, false);
 #endif
 
+ led_states = 0;
+ for (int port=0; port < BUTTONSCANPORTS; port++)
+  led_port_val[port] = 0;
+ led_update = false;
+ event_wr = 0;
+ event_rd = 0;
+ scan_cnt = 0;
+ scan_phase = 0;
  button_states = ReadButtons();
  for (int cnt=0; cnt < BUTTONLEDCNT; cnt++)
   button_debounce[cnt] = 0;
- led_states = 0;
+ // Ab hier gehören die Pins der ISR
+ scan_active = true;
 }
 
 /*
@@ -61,17 +87,19 @@ void ManualCtrl::StartManualCtrl(void)
  * Bereits am Anfang einmal die Buttons einlesen um Aktionen bei einer klemmenden Taste zu verhindern.
  */
 
-// Gehen wir mal von Aufrufen alle 10ms aus
+// Bei einer Abtastung alle BUTTONSCANPERIOD (10ms)
 #define BUTTONDOWNDELAY 5 // 50ms
 #define BUTTONUPDELAY 15 // 150ms
 
-unsigned ManualCtrl::DoManualCtrl(void)
+// Entprellt die Tasten first..first+BUTTONDEBOUNCESLICE-1 anhand von act_buttons
+unsigned ManualCtrl::Debounce(unsigned first)
 {
- // Nur alle x ms durchführen
- unsigned act_buttons = ReadButtons();
  unsigned btndnevent = 0;
- unsigned int mask=1;
- for (int cnt=0; cnt < BUTTONLEDCNT; cnt++)
+ unsigned int mask=1 << first;
+ unsigned last = first + BUTTONDEBOUNCESLICE;
+ if (last > BUTTONLEDCNT)
+  last = BUTTONLEDCNT;
+ for (unsigned cnt=first; cnt < last; cnt++)
  {
   if (button_states & mask)
   {
@@ -109,6 +137,101 @@ unsigned ManualCtrl::DoManualCtrl(void)
  return btndnevent;
 }
 
+/*
+ * Ablauf einer Abtastung, ein Schritt je ISR-Aufruf:
+ * 0: Warten auf das Abtastraster, zwischendurch neuen LED-Zustand ausgeben
+ * 1: Signale als Input schalten, COM high
+ * 2: Ports einlesen, zurück auf LED-Betrieb
+ * 3: Portwerte den Tasten zuordnen
+ * 4..: Entprellen, je Aufruf BUTTONDEBOUNCESLICE Tasten, danach das Ereignis ablegen
+ * Nur Registerzugriffe mit den im Konstruktor bestimmten Masken, kein pinMode()/digitalRead() o.ä.
+ * DIR wird nur auf Ports mit Tasten verändert. Ein pinMode() der Hauptschleife auf einem dieser
+ * Ports muss mit gesperrten Interrupts erfolgen (siehe pwmEnable()).
+ */
+void ManualCtrl::ScanIsr(void)
+{
+#if BUTTONLEDCNT > 0
+ if (!scan_active)
+  return;
+ switch (scan_phase)
+ {
+ case 0:
+  if (++scan_cnt < BUTTONSCANTICKS)
+  {
+   // Zwischen den Abtastungen: neuen LED-Zustand ausgeben
+   if (led_update)
+   {
+    led_update = false;
+    SetLeds();
+   }
+   return;
+  }
+  scan_cnt = 0;
+  // Erst LEDs aus und damit Signalknoten entladen
+  for (int port=0; port < BUTTONSCANPORTS; port++)
+   gpioPorts[port]->MASKED_ACCESS[port_mask[port]] = 0;
+  break;
+ case 1:
+  // Dann Signale als Input schalten, eingelesen wird beim nächsten Aufruf (mind. 10µs später)
+  for (int port=0; port < BUTTONSCANPORTS; port++)
+   if (port_mask[port] != 0) // Ports ohne Tasten nicht anfassen (DIR ist ein Read-Modify-Write)
+    gpioPorts[port]->DIR &= ~port_mask[port];
+  com_port->MASKED_ACCESS[com_mask] = com_mask;
+  break;
+ case 2:
+  for (int port=0; port < BUTTONSCANPORTS; port++)
+   port_data[port] = gpioPorts[port]->MASKED_ACCESS[port_mask[port]];
+  // Und wieder zurück auf LED-Betrieb
+  com_port->MASKED_ACCESS[com_mask] = 0;
+  for (int port=0; port < BUTTONSCANPORTS; port++)
+   if (port_mask[port] != 0)
+    gpioPorts[port]->DIR |= port_mask[port];
+  led_update = false;
+  SetLeds();
+  break;
+ case 3:
+  act_buttons = 0;
+  for (int cnt=0; cnt < BUTTONLEDCNT; cnt++)
+  {
+   if (port_data[pin_port[cnt]] & pin_mask[cnt])
+    act_buttons |= 1 << cnt;
+  }
+  btndnevent = 0;
+  break;
+ default:
+  unsigned first = (scan_phase - 4) * BUTTONDEBOUNCESLICE;
+  btndnevent |= Debounce(first);
+  if (first + BUTTONDEBOUNCESLICE < BUTTONLEDCNT)
+   break;
+  scan_phase = 0;
+  if (btndnevent != 0)
+  {
+   byte next = (event_wr+1) & (BUTTONEVENTQUEUELEN-1);
+   if (next != event_rd)
+   {
+    event_queue[event_wr] = btndnevent;
+    event_wr = next;
+   } else {
+    // Warteschlange voll: mit dem jüngsten Ereignis zusammenfassen, es geht kein Tastendruck verloren
+    event_queue[(event_wr-1) & (BUTTONEVENTQUEUELEN-1)] |= btndnevent;
+   }
+  }
+  return;
+ }
+ scan_phase++;
+#endif
+}
+
+unsigned ManualCtrl::GetButtonEvent(void)
+{
+ if (event_rd == event_wr)
+  return 0;
+ unsigned btndnevent = event_queue[event_rd];
+ event_rd = (event_rd+1) & (BUTTONEVENTQUEUELEN-1);
+ return btndnevent;
+}
+
+// Blockierendes Einlesen mit Wartezeiten, nur beim Start bevor die ISR die Pins übernimmt
 unsigned ManualCtrl::ReadButtons(void)
 {
 #if BUTTONLEDCNT > 0
@@ -148,19 +271,28 @@ unsigned ManualCtrl::ReadButtons(void)
  return act_buttons;
 }
 
+// Gibt die von UpdateLeds() berechneten Portwerte aus, wird auch aus der ISR aufgerufen
 void ManualCtrl::SetLeds(void)
 {
- for (int cnt=0; cnt < BUTTONLEDCNT; cnt++)
- {
-  digitalWrite(pins_def[cnt], ((led_states >> cnt) & 1) != 0);
- }
+ for (int port=0; port < BUTTONSCANPORTS; port++)
+  gpioPorts[port]->MASKED_ACCESS[port_mask[port]] = led_port_val[port];
 }
 
 void ManualCtrl::UpdateLeds(int newstates)
 {
  if (led_states != newstates)
  {
+  // Die Umrechnung auf Portwerte passiert hier in der Hauptschleife, nicht in der ISR
+  unsigned short val[BUTTONSCANPORTS] = {0};
+  for (int cnt=0; cnt < BUTTONLEDCNT; cnt++)
+  {
+   if ((newstates >> cnt) & 1)
+    val[pin_port[cnt]] |= pin_mask[cnt];
+  }
+  led_update = false;
+  for (int port=0; port < BUTTONSCANPORTS; port++)
+   led_port_val[port] = val[port];
   led_states = newstates;
-  SetLeds();
+  led_update = true;
  }
 }
@@ -0,0 +1,166 @@
+/*
+ *  StateJournal.cpp - Wear levelled journal for the system state
+ *
+ *  For any further information see: inc/config.h
+ *
+ *  Copyright (C) 2018 Florian Voelzke <fvoelzke@gmx.de>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <string.h>
+#include <sblib/internal/iap.h>
+#include <StateJournal.h>
+#include <crc8.h>
+
+StateJournal journal;
+
+StateJournal::StateJournal(void)
+{
+ NextSlot = 0;
+ NextSeq = 1;
+ memset(SlotBuf, 0xff, JOURNALSLOTSIZE);
+}
+
+bool StateJournal::EraseSector(unsigned SectorIdx)
+{
+ const byte* SectorStart = (const byte *)(JOURNALFLASHSTART + SectorIdx*JOURNALSECTORSIZE);
+ return iapEraseSector(iapSectorOfAddress(SectorStart)) == IAP_SUCCESS;
+}
+
+bool StateJournal::ProgramSlot(unsigned SlotIdx, const byte *data)
+{
+ return iapProgram((byte *)SlotPtr(SlotIdx), data, JOURNALSLOTSIZE) == IAP_SUCCESS;
+}
+
+const byte* StateJournal::SlotPtr(unsigned SlotIdx)
+{
+ return (const byte *)(JOURNALFLASHSTART + SlotIdx*JOURNALSLOTSIZE);
+}
+
+bool StateJournal::SlotValid(unsigned SlotIdx, unsigned &Seq)
+{
+ const byte* ptr = SlotPtr(SlotIdx);
+ if ((ptr[0] | 1) != JOURNALMAGIC) // Bit 0 siehe Commit()
+  return false;
+ unsigned Len = ptr[5] | (ptr[6] << 8);
+ if (Len > JOURNALPAYLOADLEN)
+  return false;
+ if (ptr[JOURNALHEADERLEN+Len] == 0xff) // Ungeschriebene CRC
+  return false;
+ if (crc_calc(ptr, JOURNALHEADERLEN+Len) != ptr[JOURNALHEADERLEN+Len])
+  return false;
+ Seq = ptr[1] | (ptr[2] << 8) | (ptr[3] << 16) | (ptr[4] << 24);
+ return true;
+}
+
+bool StateJournal::SlotErased(unsigned SlotIdx)
+{
+ const byte* ptr = SlotPtr(SlotIdx);
+ for (unsigned i=0; i < JOURNALSLOTSIZE; i++)
+ {
+  if (ptr[i] != 0xff)
+   return false;
+ }
+ return true;
+}
+
+bool StateJournal::SectorErased(unsigned SectorIdx)
+{
+ for (unsigned i=0; i < JOURNALSLOTSPERSECTOR; i++)
+ {
+  if (!SlotErased(SectorIdx*JOURNALSLOTSPERSECTOR+i))
+   return false;
+ }
+ return true;
+}
+
+// Innerhalb eines Sektors werden beschriebene Slots übersprungen, das sind
+// beim Spannungsausfall nur teilweise geschriebene Datensätze. Am Sektoranfang
+// wird angehalten, dieser Sektor wird vor dem Schreiben gelöscht.
+void StateJournal::SkipUsedSlots(void)
+{
+ while (((NextSlot % JOURNALSLOTSPERSECTOR) != 0) && !SlotErased(NextSlot))
+ {
+  NextSlot = (NextSlot+1) % JOURNALSLOTCNT;
+ }
+}
+
+void StateJournal::Init(void)
+{
+ bool Found = false;
+ unsigned NewestSlot = 0;
+ unsigned NewestSeq = 0;
+ unsigned Seq;
+ for (unsigned SlotIdx=0; SlotIdx < JOURNALSLOTCNT; SlotIdx++)
+ {
+  if (SlotValid(SlotIdx, Seq))
+  {
+   if ((not Found) || ((signed int)(Seq - NewestSeq) > 0))
+   {
+    Found = true;
+    NewestSeq = Seq;
+    NewestSlot = SlotIdx;
+   }
+  }
+ }
+ memset(SlotBuf, 0xff, JOURNALSLOTSIZE);
+ if (Found)
+ {
+  const byte* ptr = SlotPtr(NewestSlot);
+  unsigned Len = ptr[5] | (ptr[6] << 8);
+  memcpy(SlotBuf+JOURNALHEADERLEN, ptr+JOURNALHEADERLEN, Len);
+  NextSeq = NewestSeq+1;
+  NextSlot = (NewestSlot+1) % JOURNALSLOTCNT;
+ } else {
+  NextSeq = 1;
+  NextSlot = 0;
+ }
+ SkipUsedSlots();
+}
+
+byte* StateJournal::Buffer(void)
+{
+ return SlotBuf+JOURNALHEADERLEN;
+}
+
+void StateJournal::PrepareNextSlot(void)
+{
+ if ((NextSlot % JOURNALSLOTSPERSECTOR) == 0)
+ { // Der nächste Datensatz beginnt einen neuen Sektor. Der neueste gültige Datensatz liegt
+   // immer in einem anderen Sektor, das Löschen ist also unkritisch.
+  unsigned SectorIdx = NextSlot / JOURNALSLOTSPERSECTOR;
+  if (!SectorErased(SectorIdx))
+   EraseSector(SectorIdx);
+ }
+}
+
+bool StateJournal::Commit(unsigned len)
+{
+ if (len > JOURNALPAYLOADLEN)
+  return false;
+ SkipUsedSlots();
+ PrepareNextSlot(); // Normalerweise schon erledigt, dann bleibt es bei einem Lesezugriff
+ SlotBuf[0] = JOURNALMAGIC;
+ SlotBuf[1] = NextSeq & 0xff;
+ SlotBuf[2] = (NextSeq >> 8) & 0xff;
+ SlotBuf[3] = (NextSeq >> 16) & 0xff;
+ SlotBuf[4] = (NextSeq >> 24) & 0xff;
+ SlotBuf[5] = len & 0xff;
+ SlotBuf[6] = (len >> 8) & 0xff;
+ // Die CRC steht direkt hinter den Nutzdaten, der Puffer behält die Nutzdaten für das nächste Mal
+ byte Crc = crc_calc(SlotBuf, JOURNALHEADERLEN+len);
+ if (Crc == 0xff)
+ { // Eine CRC 0xFF ist nicht von einem abgebrochenen Schreibvorgang zu unterscheiden,
+   // mit Bit 0 der Signatur ergibt sich eine andere CRC.
+  SlotBuf[0] = JOURNALMAGIC & ~1;
+  Crc = crc_calc(SlotBuf, JOURNALHEADERLEN+len);
+ }
+ SlotBuf[JOURNALHEADERLEN+len] = Crc;
+ bool Ok = ProgramSlot(NextSlot, SlotBuf);
+ NextSlot = (NextSlot+1) % JOURNALSLOTCNT;
+ NextSeq++;
+ return Ok;
+}
@@ -19,6 +19,7 @@
 #include <RelSpi.h>
 #include <ManualCtrl.h>
 #include <MemMapperMod.h>
+#include <StateJournal.h>
 #include <sblib/usr_callback.h>
 #include <app_main.h>
 #include <DebugFunc.h>
@@ -28,7 +29,6 @@
 extern volatile unsigned int systemTime;
 
 unsigned LastRelTime;
-unsigned LastManCtrlTime;
 bool ProcessingEnabled;
 unsigned LastTimeFctTime;
 unsigned OpStatesTime;
@@ -68,10 +68,10 @@ bool NoAppWasRunning = false;
 /*
  * Der MemMapper bekommt einen 1kB Bereich ab 0xEA00, knapp unterhalb des UserMemory-Speicherbereichs ab 0xF000.
  * Damit lassen sich 3 Pages (je 256Byte) (und die allocTable die MemMappers) unterbringen.
- * Benötigt werden zwei Pages:
- * - für den Konfigurationsspeicher jenseits von 0x4B00. Für die SbLib endet der Konfigurationspeicher dort,
- *   unser Vorbild legt dort jedoch noch einige allgemeine Optionen ab.
- * - für die Systemzustände. Diese werden bei Busspannungsausfall und Neustart abgespeichert.
+ * Benötigt wird eine Page für den Konfigurationsspeicher jenseits von 0x4B00. Für die SbLib endet der
+ * Konfigurationspeicher dort, unser Vorbild legt dort jedoch noch einige allgemeine Optionen ab.
+ * Die Systemzustände, die bei Busspannungsausfall und Neustart abgespeichert werden, liegen nicht mehr
+ * im MemMapper, sondern im Journal (StateJournal.h).
  */
 MemMapperMod memMapper(0xea00, 0x400);
 
@@ -102,7 +102,7 @@ BcuBase* setup()
 #endif
  pwmSetup();
  IsrSetup();
- LastTimeFctTime = LastRelTime = LastManCtrlTime = systemTime;
+ LastTimeFctTime = LastRelTime = systemTime;
  AppOperatingState = AppOperatingStates::Startup;
  // //RelTestEnqueue();
  bcu.setProgPin(PIOPROGBTN);
@@ -117,7 +117,6 @@ BcuBase* setup()
  // 12 Bytes der Aktorkonfiguration werden ab 0x4B00 geschrieben. Das liegt bloederweise
  // genau jenseits des USER-EEPROM. Also mappen wir virtuellen Speicherbereich dorthin.
  memMapper.addRange(0x4b00, 0x100);
- memMapper.addRange(0x0, 0x100); // Zum Abspeichern/Laden des Systemzustands
  bcu.comObjects->objectEndian(LITTLE_ENDIAN);
  bcu.userRam->setUserRamStart(0x3FC);
  appl.RecallAppData(UsrCallbackType::recallAppStartup);
@@ -148,14 +147,17 @@ void AppOperatingStateMachine(unsigned referenceTime, bool AppValid)
   } else {
    if ((signed int)(referenceTime - OpStatesTime) > 0)
    {
+    journal.PrepareNextSlot(); // Evtl. Sektor löschen, solange genug Energie da ist
     if (AppValid)
     {
+     appl.BuildObjDispatchTable(); // Die Konfiguration kann sich durch einen Download geändert haben
      appl.StartupGlobSafetyStartTime(referenceTime);
      bcu.setGroupTelRateLimit(appl.ReadTelRateLimit());
      appl.InitialChannelSwitch(referenceTime);
      OpStatesTime = referenceTime + ReadStartDelayObjSendAndSwitching()*1000; // Wartezeit nach Konfig
      AppOperatingState = AppOperatingStates::AppStartup;
     } else {
+     appl.ClearObjDispatchTable();
      AppOperatingState = AppOperatingStates::NoAppStartup;
     }
    }
@@ -361,15 +363,12 @@ void MainProcessingRoutine(bool AppValid)
 
  // Handbedienung
  //==============
- if ((referenceTime - LastManCtrlTime) >= 10)
+ // Abgetastet und entprellt wird in der ADC-ISR (ManualCtrl::ScanIsr), hier werden nur die Ereignisse abgeholt.
+ unsigned ButtonDownEvents = manuCtrl.GetButtonEvent();
+ if ((ButtonDownEvents != 0) && (AppManualOpWithObjEnabled() || AppManualOpWOObjEnabled()))
  {
-  LastManCtrlTime = referenceTime;
-  unsigned ButtonDownEvents = manuCtrl.DoManualCtrl();
-  if ((ButtonDownEvents != 0) && (AppManualOpWithObjEnabled() || AppManualOpWOObjEnabled()))
-  {
-   appl.ManualControl(ButtonDownEvents);
-   relay.DoEnqueue();
-  }
+  appl.ManualControl(ButtonDownEvents);
+  relay.DoEnqueue();
  }
 
  // Relais & SPI-Verarbeitung
@@ -41,6 +41,36 @@
 #define APP_RESTORE_AFTER_PL_HI      (0x1F7)
 #define APP_DELAY_BASE               (0x1F9) // Einschalt/Ausschaltverzoegerung Basis
 
+enum specialFunctionType : signed char {sftUnknown = -1, sftLogic = 0, sftBlocking = 1, sftConstrainedLead = 2}; // Verknuepfungsobjekt, Sperrobjekt, Zwangsstellungsobjekt
+enum logicType : byte {ltUnknown = 0, ltOR = 1, ltAND = 2, ltAND_RECIRC = 3}; // logic OR, AND, AND with recirculation (UND mit Rueckfuehrung)
+enum blockType : signed char {blUnknown = -1, blNoAction = 0, blDisable = 1, blEnable = 2};
+
+typedef struct TimerConfig {
+    byte timerMode;
+    byte timerDelayAction;
+    byte timerOnFactor;
+    byte timerOffFactor;
+    unsigned int delayMs;
+} TimerConfig;
+
+typedef struct SpecialFunctionConfig
+{
+    specialFunctionType Mode;  // mode of the special function
+    signed char specialFuncNumber; // number of the special function (0..3)
+    signed char specialFuncOutput; // output a special function is belonging to (0..7)
+    logicType logicFuncTyp;
+    blockType blockTypeStart;
+    blockType blockTypeEnd;
+    byte lockPolarity;         // polarity of the lock object for sftBlocking mode
+} SpecialFunctionConfig;
+
+/**
+ * Decode the special functions and timers of all channels from the EEPROM
+ * into the tables used by objectUpdated() and checkTimeouts(). Called by
+ * initApplication() and after a download.
+ */
+void decodeConfiguration(void);
+
 void objectUpdated(int objno);
 void checkTimeouts(void);
 void initApplication(int lastRelayState = 0x00);
@@ -130,12 +130,16 @@
 
 #ifdef BI_STABLE
 #   define NO_OF_OUTPUTS (NO_OF_CHANNELS * 2)
-#   define BETWEEN_CHANNEL_DELAY_MS 100 // pause in ms between to channels relais switching, to avoid bus drainage
+#   define BETWEEN_CHANNEL_DELAY_MS 100 // not used, the coil pulses are spaced by the pulse sequencer, see PULSE_PAUSE
 #else
 #   define NO_OF_OUTPUTS (NO_OF_CHANNELS)
 #   define BETWEEN_CHANNEL_DELAY_MS 100 // pause in ms between to channels relais switching, to avoid bus drainage
 #endif
 
+#ifndef FEEDBACK_DELAY_MS
+#   define FEEDBACK_DELAY_MS 0 // >0: feedback of channels changed within this time in ms is sent together, 0: at once
+#endif
+
 /*
  *  output pins configuration
  */
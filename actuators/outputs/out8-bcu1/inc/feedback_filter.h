@@ -0,0 +1,63 @@
+/*
+ *  feedback_filter.h - Decides which feedback objects of the channels are written
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef FEEDBACK_FILTER_H_
+#define FEEDBACK_FILTER_H_
+
+#include <sblib/timeout.h>
+
+/**
+ * Keeps the values of the feedback objects as written last, so only the
+ * objects whose value changed are written.
+ *
+ * With a delay the first change starts a timeout, and the changes until it
+ * expires are written together. A channel that switches back within the
+ * delay then writes nothing. Without a delay the changes are written at
+ * once.
+ */
+class FeedbackFilter
+{
+public:
+    /**
+     * @param delayms the time in milliseconds the changes are collected, 0 to write at once
+     */
+    FeedbackFilter(unsigned int delayms);
+
+    /**
+     * A channel may have changed.
+     *
+     * @return true if the feedback is to be written now, false while the
+     *         changes are collected
+     */
+    bool changed(void);
+
+    /**
+     * Call from the main loop.
+     *
+     * @return true once when the delay is over and the collected changes
+     *         are to be written
+     */
+    bool expired(void);
+
+    /**
+     * Take over the values of the feedback objects that are written now,
+     * this also ends a running delay.
+     *
+     * @param feedback the values of the feedback objects, one bit per channel
+     * @param force the objects to write even if their value did not change
+     * @return the objects to write, one bit per channel
+     */
+    unsigned int update(unsigned int feedback, unsigned int force = 0);
+
+protected:
+    unsigned int _delayms;
+    unsigned int _written; //!< values of the feedback objects as written last
+    Timeout      _delay;
+};
+
+#endif /* FEEDBACK_FILTER_H_ */
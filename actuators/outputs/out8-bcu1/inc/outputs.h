@@ -22,6 +22,8 @@
 #   include "hand_actuation.h"
 #endif
 
+#include "zero_cross.h"
+
 #define PWM_TIMEOUT 20 // ms
 #define PWM_PERIOD  85 // 1.2kHz
 #define PWM_DUTY    22 // 0.25 duty
@@ -48,12 +50,15 @@ class Outputs
               , _prevRelayState(0)
               , _inverted(0)
               , _blocked(0)
+              , _queued(0)
+              , _switchDelay(0)
               {};
 
     virtual void setupOutputs(const int* Pins, const unsigned int pinCount);
     void begin(unsigned int initial, unsigned int inverted, unsigned int channelcount);
     unsigned int pendingChanges(void);
     unsigned int channel(unsigned int channel);
+    unsigned int channels(void);
     void updateChannel(unsigned int channel, unsigned int value);
     void setChannel(unsigned int channel);
     void clearChannel(unsigned int channel);
@@ -64,6 +69,7 @@ class Outputs
     virtual void checkPWM(void);
     virtual unsigned int updateOutput(unsigned int channel);      // returns true in case a switching action was started which drained the bus
     virtual void updateOutputs(unsigned int delayms = 0);
+    void checkSwitchQueue(void);
     void setOutputs(void);
     void clrOutputs(void);
     unsigned int channelCount();
@@ -75,9 +81,12 @@ class Outputs
 
 #ifdef ZERO_DETECT
     void zeroDetectHandler(void);
+    void zeroCrossTimerHandler(void);
 #endif
 
 protected:
+    virtual unsigned int switchOutput(unsigned int channel, unsigned int value); // returns true in case the switching drained the bus
+
     unsigned int _channelcount;
     unsigned int _relayState;
     unsigned int _prevRelayState;
@@ -85,6 +94,9 @@ class Outputs
     unsigned int _modified;
     unsigned int _blocked;
     Timeout      _pwm_timeout;
+    unsigned int _queued;       //!< channels with a reported change that still wait for their relay to be switched
+    unsigned int _switchDelay;  //!< pause in ms between two queued channels
+    Timeout      _switch_timeout;
     unsigned int _port_0_set;
     unsigned int _port_2_set;
     unsigned int _port_0_clr;
@@ -96,10 +108,16 @@ class Outputs
 #endif
 
 #ifdef ZERO_DETECT
-    unsigned int _state;
+    void scheduleZeroCross(void);
+
+    ZeroCrossScheduler _zeroCross;
+    volatile unsigned int _zcArmed; //!< ZC_ARMED_SET, ZC_ARMED_CLR: match interrupt will switch the ports
 #endif
 };
 
+#define ZC_ARMED_SET 0x01 // MAT0 of timer32_0
+#define ZC_ARMED_CLR 0x02 // MAT1 of timer32_0
+
 #ifndef BI_STABLE
 extern Outputs relays;
 #endif
@@ -114,6 +132,14 @@ ALWAYS_INLINE unsigned int Outputs::channel(unsigned int channel)
     return _relayState & (1 << channel) ? 1 : 0;
 }
 
+/*
+ * returns the state of all channels, one bit per channel
+ */
+ALWAYS_INLINE unsigned int Outputs::channels(void)
+{
+    return _relayState & ((1 << _channelcount) - 1);
+}
+
 ALWAYS_INLINE void Outputs::updateChannel(unsigned int channel, unsigned int value)
 {
     if (value) setChannel(channel);
@@ -175,12 +201,18 @@ ALWAYS_INLINE void Outputs::checkPWM(void)
 #ifdef ZERO_DETECT
 ALWAYS_INLINE void Outputs::zeroDetectHandler(void)
 {
-	if (_state == 1)
-	{
-	    //digitalWrite(PIN_INFO, ! digitalRead(PIN_INFO));	// Info LED
-		timer32_0.start();
-		_state = 0;
-	}
+    _zeroCross.edge(timer32_0.value());
+}
+
+ALWAYS_INLINE void Outputs::zeroCrossTimerHandler(void)
+{
+    unsigned int flags = timer32_0.flags() & _zcArmed;
+    timer32_0.resetFlags();
+    if (flags & ZC_ARMED_SET)
+        setOutputs();
+    if (flags & ZC_ARMED_CLR)
+        clrOutputs();
+    _zcArmed &= ~flags;
 }
 #endif /* define ZERO_DETECT */
 
@@ -25,6 +25,10 @@
                     //  9ms, 8 of 8 relays work
                     // 10ms, 8 of 8 relays work
                     // 15ms, 8 of 8 relays work
+#define PULSE_PAUSE 85 // ms between the end of a coil pulse and the next one,
+                    // lets the supply recover, one coil each 100ms like BETWEEN_CHANNEL_DELAY_MS
+#define PULSE_TICKS_PER_MS 100 // timer16_0 runs with 10us
+
 /*
  * order code Hongfa HFE20-1 24-1HSD-L2(359)
  *    1:      5mm pin
@@ -38,13 +42,54 @@
  */
 
 
+/**
+ * The coil pulses of the latching relays are sequenced by the interrupt of
+ * timer16_0, which is not used for a PWM with bistable relays. Only one
+ * coil is driven at a time, each pulse takes exactly ON_DELAY and is
+ * followed by a pause of PULSE_PAUSE. Requested pulses wait in a set and a
+ * reset mask, a newer request for a channel replaces an older one.
+ *
+ * The application needs no interface to learn when a pulse is done: the
+ * feedback objects report the requested state as soon as it is taken over,
+ * like with monostable relays, only the LEDs of the hand actuation follow
+ * the completed pulses, in checkPWM(). A pulse which is cut by stopPulses()
+ * is not lost either, begin() pulses every channel again to the stored
+ * state after the bus voltage has returned.
+ */
 class OutputsBiStable : public Outputs
 {
 public:
-    OutputsBiStable() : Outputs() {};
+    OutputsBiStable() : Outputs()
+                      , _pulseSet(0)
+                      , _pulseReset(0)
+                      , _completed(0)
+                      , _pulseChannel(0)
+                      , _pulseState(PULSE_IDLE)
+                      {};
 
-    virtual unsigned int updateOutput(unsigned int channel); // returns true in case a switching action was started which drained the bus
+    void begin(unsigned int initial, unsigned int inverted, unsigned int channelcount);
     virtual void checkPWM(void);
+
+    /**
+     * Drop the waiting pulses and switch the coil of the running pulse
+     * off, e.g. on a bus voltage failure.
+     */
+    void stopPulses(void);
+
+    void pulseTimerHandler(void);
+
+protected:
+    enum PulseState : byte {PULSE_IDLE, PULSE_COIL_ON, PULSE_RECOVER};
+
+    virtual unsigned int switchOutput(unsigned int channel, unsigned int value); // returns true in case a switching action was started which drained the bus
+    void nextPulse(void);
+    void startPulseTimer(unsigned int ms);
+
+    volatile unsigned int _pulseSet;     //!< channels waiting for a set pulse
+    volatile unsigned int _pulseReset;   //!< channels waiting for a reset pulse
+    volatile unsigned int _completed;    //!< channels whose pulse has ended, not yet reported
+    volatile unsigned int _pulseChannel; //!< the channel of the running pulse
+    volatile PulseState   _pulseState;
 };
 
 #ifdef BI_STABLE
@@ -0,0 +1,89 @@
+/*
+ *  timeout_queue.h - Timeouts of the channels, sorted by their deadline
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef TIMEOUT_QUEUE_H_
+#define TIMEOUT_QUEUE_H_
+
+#include <sblib/types.h>
+
+#define TIMEOUT_QUEUE_SIZE  16   //!< an on and an off timeout for each of the 8 channels
+#define TIMEOUT_QUEUE_END   0xFF
+
+/**
+ * A set of timeouts with the semantics of sblib's Timeout, identified by a
+ * number. The running timeouts are kept in a list sorted by their deadline,
+ * so finding the expired timeouts costs one comparison with the earliest
+ * deadline as long as none has expired.
+ *
+ * Deadlines are compared by their difference to millis(), which works
+ * across the wrap around of millis() for timeouts shorter than 24 days.
+ */
+class TimeoutQueue
+{
+public:
+    TimeoutQueue();
+
+    /**
+     * Start or restart a timeout.
+     *
+     * @param id the timeout 0..TIMEOUT_QUEUE_SIZE-1
+     * @param msec the time in milliseconds until the timeout expires
+     */
+    void start(unsigned int id, unsigned int msec);
+
+    /**
+     * Stop a timeout, without marking it expired.
+     */
+    void stop(unsigned int id);
+
+    /**
+     * @return true if the timeout is running
+     */
+    bool started(unsigned int id) const;
+
+    /**
+     * @return true if the timeout is not running
+     */
+    bool stopped(unsigned int id) const;
+
+    /**
+     * Test if a timeout has expired, like Timeout::expired() a timeout is
+     * stopped when its expiry is reported.
+     *
+     * @return true once if the timeout has expired
+     */
+    bool expired(unsigned int id);
+
+    /**
+     * Get the earliest expired timeout, it is stopped. Timeouts with the
+     * same deadline are returned in the order they were started.
+     *
+     * @return the id of the timeout, -1 if no timeout has expired
+     */
+    int nextExpired(void);
+
+protected:
+    void remove(unsigned int id);
+
+    unsigned int _deadline[TIMEOUT_QUEUE_SIZE];
+    byte         _next[TIMEOUT_QUEUE_SIZE];  //!< the following timeout in the sorted list
+    byte         _first;                     //!< the timeout with the earliest deadline
+    unsigned int _running;                   //!< one bit per timeout
+};
+
+inline bool TimeoutQueue::started(unsigned int id) const
+{
+    return _running & (1 << id);
+}
+
+inline bool TimeoutQueue::stopped(unsigned int id) const
+{
+    return !started(id);
+}
+
+#endif /* TIMEOUT_QUEUE_H_ */
@@ -0,0 +1,150 @@
+/*
+ *  zero_cross.h - Predict the zero crossings of the mains voltage from the
+ *                 edges of the zero detector
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef ZERO_CROSS_H_
+#define ZERO_CROSS_H_
+
+/*
+ * All times are counts of a free running timer with 10us per tick
+ * (timer32_0 with the prescaler of Outputs::begin()), all comparisons are
+ * done on differences, so the wrap around of the timer does not matter.
+ */
+#define ZC_TICKS_PER_MS     100
+#define ZC_MIN_PERIOD       (16 * ZC_TICKS_PER_MS) // 62.5Hz
+#define ZC_MAX_PERIOD       (25 * ZC_TICKS_PER_MS) // 40Hz
+#define ZC_LOCK_EDGES       4   //!< consecutive edges with the same period until the scheduler is locked
+#define ZC_MAX_REJECTED     8   //!< consecutive rejected edges until the lock is lost
+#define ZC_MAX_CORRECTION   32  //!< maximal deviation of an edge from the prediction used to correct the PLL
+#define ZC_DETECTOR_OFFSET  0   //!< delay of the zero crossing after the falling edge of the detector
+#define ZC_MIN_LEAD         (1 * ZC_TICKS_PER_MS) //!< minimal time between scheduling and firing a coil
+
+#define ZC_OPERATE_TIME     0x0200 //!< Omron G5Q-1A EU 10A, coil on until the contact closes
+#define ZC_RELEASE_TIME     0x0240 //!< Omron G5Q-1A EU 10A, coil off until the contact opens
+
+/**
+ * The zero detector gives one falling edge per mains period. The
+ * scheduler learns the period from the edges and tracks the phase with a
+ * simple PLL: each edge moves the predicted phase by 1/4 and the period by
+ * 1/16 of the deviation from the prediction. The jitter of single edges
+ * is averaged this way, edges that are far off the prediction (spikes on
+ * the mains) are ignored, missing edges are bridged by the prediction.
+ *
+ * With the learned operate and release times of the relays the coils are
+ * fired so that the contacts close and open in a zero crossing. All
+ * channels switched until the coils are fired share the same zero crossing.
+ */
+class ZeroCrossScheduler
+{
+public:
+    ZeroCrossScheduler();
+
+    /**
+     * Process an edge of the zero detector, called from the pin interrupt.
+     *
+     * @param time the timer count of the edge
+     */
+    void edge(unsigned int time);
+
+    /**
+     * @param now the current timer count
+     * @return true if the period and phase of the mains are known and the
+     *         last edge is not older than ZC_MAX_REJECTED periods
+     */
+    bool locked(unsigned int now) const;
+
+    /**
+     * @return the learned mains period in ticks with 4 fraction bits
+     */
+    unsigned int period16(void) const;
+
+    /**
+     * The first zero crossing (both half-waves) which can still be hit by
+     * the contacts when the coils are fired not earlier than ZC_MIN_LEAD
+     * after now.
+     *
+     * @param now the current timer count
+     * @return the timer count of the zero crossing
+     */
+    unsigned int nextZeroCross(unsigned int now) const;
+
+    /**
+     * Learn the operate or release time from a measured delay between
+     * firing the coil and the contact.
+     *
+     * @param closing true for the operate time, false for the release time
+     * @param delay the measured delay in ticks
+     */
+    void contactMoved(bool closing, unsigned int delay);
+
+    unsigned int operateTime(void) const;
+    unsigned int releaseTime(void) const;
+
+protected:
+    void acquire(unsigned int time);
+
+    unsigned int _period16;    //!< mains period in ticks with 4 fraction bits
+    unsigned int _lastEdge;    //!< filtered time of the last edge
+    unsigned int _nextEdge;    //!< predicted time of the next edge
+    unsigned int _edges;       //!< consecutive edges which fit while not locked
+    unsigned int _rejected;    //!< consecutive edges which did not fit the prediction
+    bool         _locked;
+    unsigned int _operateTime;
+    unsigned int _releaseTime;
+};
+
+/**
+ * Add a pin to the pins of a port which are switched in the next zero
+ * crossing. The coils to switch off are fired before the coils to switch
+ * on (ZC_RELEASE_TIME > ZC_OPERATE_TIME), a pin in both masks would end up
+ * on. The newest request of a pin therefore removes it from the other mask.
+ *
+ * Call with the interrupts disabled, the timer interrupt clears the masks.
+ *
+ * @param set the pins of the port to switch on
+ * @param clr the pins of the port to switch off
+ * @param pinMask the pin to add
+ * @param value the new level of the pin
+ */
+inline void zeroCrossAddPin(unsigned int & set, unsigned int & clr, unsigned int pinMask, unsigned int value)
+{
+    if (value)
+    {
+        set |=  pinMask;
+        clr &= ~pinMask;
+    }
+    else
+    {
+        clr |=  pinMask;
+        set &= ~pinMask;
+    }
+}
+
+inline bool ZeroCrossScheduler::locked(unsigned int now) const
+{
+    // the filtered edge may be a bit later than the edge just processed
+    unsigned int period = _period16 >> 4;
+    return _locked && ((now - _lastEdge + period) < (ZC_MAX_REJECTED + 1) * period);
+}
+
+inline unsigned int ZeroCrossScheduler::period16(void) const
+{
+    return _period16;
+}
+
+inline unsigned int ZeroCrossScheduler::operateTime(void) const
+{
+    return _operateTime;
+}
+
+inline unsigned int ZeroCrossScheduler::releaseTime(void) const
+{
+    return _releaseTime;
+}
+
+#endif /* ZERO_CROSS_H_ */
@@ -41,6 +41,8 @@
 
 APP_VERSION("O08.10  ", "5", "10");
 
+static bool appStopped = false; // the application was not running, e.g. during a download
+
 /**
  * simple IO test
  */
@@ -248,6 +250,11 @@ BcuBase* setup()
 void loop(void)
 {
     int objno;
+    if (appStopped)
+    {   // the parameters may have been changed by a download
+        appStopped = false;
+        decodeConfiguration();
+    }
     // Handle updated communication objects
     while ((objno = bcu.comObjects->nextUpdatedObject()) >= 0)
     {
@@ -270,6 +277,7 @@ void loop(void)
  */
 void loop_noapp(void)
 {
+    appStopped = true;
 #if defined(IO_TEST) && defined(HAND_ACTUATION)
     if (!bcu.programmingMode())
     {
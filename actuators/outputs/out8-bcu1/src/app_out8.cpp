@@ -11,6 +11,8 @@
 #include "app_out8.h"
 #include "com_objs.h"
 #include <sblib/timeout.h>
+#include "timeout_queue.h"
+#include "feedback_filter.h"
 #include <sblib/eib/com_objects.h>
 
 
@@ -25,21 +27,22 @@
 #endif
 
 
-typedef struct ChannelTimeOutTimer {
-    Timeout On;
-    Timeout Off;
-} ChannelTimeOutTimer;
-
-enum specialFunctionType {sftUnknown = -1, sftLogic = 0, sftBlocking = 1, sftConstrainedLead = 2}; // Verknuepfungsobjekt, Sperrobjekt, Zwangsstellungsobjekt
-enum logicType {ltUnknown = 0, ltOR = 1, ltAND = 2, ltAND_RECIRC = 3}; // logic OR, AND, AND with recirculation (UND mit Rueckfuehrung)
 enum logicResult {lrUnchanged = 0, lrSetOn = 1, lrSetOff = 2};
-enum blockType {blUnknown = -1, blNoAction = 0, blDisable = 1, blEnable = 2};
 enum timedFunctionState {tfsUnknown = 0x80, tfsDisabled = 0, tfsOnDelayed = 1, tfsOffDelayed = 2};
 
 BCU1 bcu;
 
 // state of the application
-static ChannelTimeOutTimer channel_timeout[NO_OF_CHANNELS];
+static TimeoutQueue timeouts; // the on and off delays of the channels
+
+#define TIMEOUT_OFF(objno) ((objno) * 2)
+#define TIMEOUT_ON(objno)  ((objno) * 2 + 1)
+
+static FeedbackFilter feedbackFilter(FEEDBACK_DELAY_MS); // the feedback objects to write
+
+// configuration of the channels, decoded from the EEPROM by decodeConfiguration()
+static SpecialFunctionConfig specialFunctionCfg[COMOBJ_SPECIAL4 + 1];
+static TimerConfig           timerCfg[NO_OF_CHANNELS];
 
 #ifdef HAND_ACTUATION
     HandActuation handAct = HandActuation(&handPins[0], NO_OF_HAND_PINS, READBACK_PIN, BLINK_TIME);
@@ -48,6 +51,7 @@ static ChannelTimeOutTimer channel_timeout[NO_OF_CHANNELS];
 // internal functions
 static void          _switchObjects(unsigned int delayms = 0);
 static void          _sendFeedbackObjects(bool forceSendFeedback = false);
+static void          _writeFeedbackObjects(bool forceSendFeedback);
 static void          _handle_logic_function(int objno, unsigned int value);
 static unsigned int  _handle_timed_functions(const int objno, const unsigned int value);
 // static logicResult   _init_logic_function(const int objno, unsigned int value);
@@ -75,26 +79,6 @@ static const unsigned int  _delayBases[] =
 };
 
 
-
-typedef struct TimerConfig {
-    unsigned int timerMode;
-    unsigned int timerDelayAction;
-    unsigned int timerOnFactor;
-    unsigned int timerOffFactor;
-    unsigned int delayMs;
-} TimerConfig;
-
-typedef struct SpecialFunctionConfig
-{
-    specialFunctionType Mode;  // mode of the special function
-    int specialFuncNumber;     // number of the special function (0..3)
-    int specialFuncOutput;     // output a special function is belonging to (0..7)
-    logicType logicFuncTyp;
-    blockType blockTypeStart;
-    blockType blockTypeEnd;
-    unsigned int lockPolarity; // polarity of the lock object for sftBlocking mode
-} SpecialFunctionConfig;
-
 SpecialFunctionConfig getSpecialFunctionConfig(const int objno)
 {
     SpecialFunctionConfig sfcfg;
@@ -188,6 +172,14 @@ static TimerConfig getTimerCfg(const int objno)
     return timercfg;
 }
 
+void decodeConfiguration(void)
+{
+    for (int objno = COMOBJ_INPUT1; objno <= COMOBJ_SPECIAL4; objno++)
+        specialFunctionCfg[objno] = getSpecialFunctionConfig(objno);
+    for (int objno = 0; objno < NO_OF_CHANNELS; objno++)
+        timerCfg[objno] = getTimerCfg(objno);
+}
+
 static void _handle_logic_function(int objno, unsigned int value)
 {
     // FIXME debug the logic handling! untested right now
@@ -196,7 +188,10 @@ static void _handle_logic_function(int objno, unsigned int value)
     blockType blockTyp;         // holds the type of blocking
     unsigned int logicState;    // state of logic function
 
-    SpecialFunctionConfig sfcfg = getSpecialFunctionConfig(objno);
+    if ((objno < COMOBJ_INPUT1) || (objno > COMOBJ_SPECIAL4))
+        return;
+
+    const SpecialFunctionConfig & sfcfg = specialFunctionCfg[objno];
 
     switch (sfcfg.Mode)
     {
@@ -229,8 +224,8 @@ static void _handle_logic_function(int objno, unsigned int value)
                 // cleared -> clear also the real object value
                 bcu.comObjects->objectSetValue(sfcfg.specialFuncOutput, false);
                 value = false;
-                channel_timeout[sfcfg.specialFuncOutput].On.stop();
-                channel_timeout[sfcfg.specialFuncOutput].Off.stop();
+                timeouts.stop(TIMEOUT_ON(sfcfg.specialFuncOutput));
+                timeouts.stop(TIMEOUT_OFF(sfcfg.specialFuncOutput));
             }
             else
                 value &= logicState;
@@ -241,14 +236,14 @@ static void _handle_logic_function(int objno, unsigned int value)
 
 
         // FIXME this doesnt work for a OR
-        if ((value) && (channel_timeout[sfcfg.specialFuncOutput].On.expired()))
+        if ((value) && (timeouts.expired(TIMEOUT_ON(sfcfg.specialFuncOutput))))
         {
-            channel_timeout[sfcfg.specialFuncOutput].Off.stop();
+            timeouts.stop(TIMEOUT_OFF(sfcfg.specialFuncOutput));
             relays.updateChannel(sfcfg.specialFuncOutput, value);
         }
-        else if ((!value) && (channel_timeout[sfcfg.specialFuncOutput].Off.expired()))
+        else if ((!value) && (timeouts.expired(TIMEOUT_OFF(sfcfg.specialFuncOutput))))
         {
-            channel_timeout[sfcfg.specialFuncOutput].On.stop();
+            timeouts.stop(TIMEOUT_ON(sfcfg.specialFuncOutput));
             relays.updateChannel(sfcfg.specialFuncOutput, value);
         }
 
@@ -323,17 +318,17 @@ static unsigned int _handle_timed_functions(const int objno, const unsigned int
     unsigned int state = tfsUnknown;
 
     // check that objno is in a valid range
-    if ((objno < COMOBJ_INPUT1) || (objno >= int(sizeof(channel_timeout)/sizeof(channel_timeout[0]))))
+    if ((objno < COMOBJ_INPUT1) || (objno >= NO_OF_CHANNELS))
         return tfsUnknown;
 
     unsigned int outputState    = relays.channel(objno);
-    TimerConfig timercfg = getTimerCfg(objno);
+    const TimerConfig & timercfg = timerCfg[objno];
 
     // channel with no on/off delay or timed function mode
     if (!timercfg.timerOffFactor && !timercfg.timerOnFactor)
     {
-        channel_timeout[objno].On.stop();
-        channel_timeout[objno].Off.stop();
+        timeouts.stop(TIMEOUT_ON(objno));
+        timeouts.stop(TIMEOUT_OFF(objno));
         return tfsDisabled;
     }
 
@@ -342,20 +337,20 @@ static unsigned int _handle_timed_functions(const int objno, const unsigned int
     {   // this is the on/off delay mode
         if (!value && timercfg.timerOffFactor) // Check if a delay is configured for falling edge / Off
         {
-            channel_timeout[objno].On.stop();
-            channel_timeout[objno].Off.start(timercfg.delayMs * timercfg.timerOffFactor);
+            timeouts.stop(TIMEOUT_ON(objno));
+            timeouts.start(TIMEOUT_OFF(objno), timercfg.delayMs * timercfg.timerOffFactor);
             state |= tfsOffDelayed;
         }
         else if (value && timercfg.timerOnFactor) // Check if a delay is configured for raising edge / On
         {
-            channel_timeout[objno].Off.stop();
-            channel_timeout[objno].On.start(timercfg.delayMs * timercfg.timerOnFactor);
+            timeouts.stop(TIMEOUT_OFF(objno));
+            timeouts.start(TIMEOUT_ON(objno), timercfg.delayMs * timercfg.timerOnFactor);
             state |= tfsOnDelayed;
         }
         else
         {
-            channel_timeout[objno].On.stop();
-            channel_timeout[objno].Off.stop();
+            timeouts.stop(TIMEOUT_ON(objno));
+            timeouts.stop(TIMEOUT_OFF(objno));
             state = tfsDisabled;
         }
     }
@@ -368,7 +363,7 @@ static unsigned int _handle_timed_functions(const int objno, const unsigned int
             {
                 relays.setChannel(objno);
                 bcu.comObjects->objectWrite(objno, (unsigned int) 1);
-                channel_timeout[objno].Off.start (timercfg.delayMs * timercfg.timerOffFactor);
+                timeouts.start(TIMEOUT_OFF(objno), timercfg.delayMs * timercfg.timerOffFactor);
                 state |= tfsOffDelayed;
             }
         }
@@ -377,14 +372,14 @@ static unsigned int _handle_timed_functions(const int objno, const unsigned int
             // Check for a timer function with delay factor for on
             if ( !outputState && value)
             {
-                channel_timeout[objno].On.start (timercfg.delayMs * timercfg.timerOnFactor);
+                timeouts.start(TIMEOUT_ON(objno), timercfg.delayMs * timercfg.timerOnFactor);
                 state |= tfsOnDelayed;
             }
 
             // Check for delay factor for off
             if (outputState && value)
             {   // once the output is ON start the OFF delay
-                channel_timeout[objno].Off.start(timercfg.delayMs * timercfg.timerOffFactor);
+                timeouts.start(TIMEOUT_OFF(objno), timercfg.delayMs * timercfg.timerOffFactor);
                 state |= tfsOffDelayed;
             }
         }
@@ -395,7 +390,7 @@ static unsigned int _handle_timed_functions(const int objno, const unsigned int
             {
                 relays.clearChannel(objno);
                 bcu.comObjects->objectWrite(objno, (unsigned int) 0);
-                channel_timeout[objno].Off.stop();
+                timeouts.stop(TIMEOUT_OFF(objno));
                 state &= ~tfsOffDelayed;
             }
         }
@@ -411,7 +406,7 @@ void objectUpdated(int objno)
     if (objno < COMOBJ_SPECIAL1) // logic objects must be checked here to
     {
         _handle_timed_functions(objno, value);
-        if (channel_timeout[objno].On.stopped() && channel_timeout[objno].Off.stopped())
+        if (timeouts.stopped(TIMEOUT_ON(objno)) && timeouts.stopped(TIMEOUT_OFF(objno)))
         {
             relays.updateChannel(objno, value);
             if (value != bcu.comObjects->objectRead(objno)) // objectWrite with set ETS update-flags leads to a infinite loop of objectUpdated & objectWrite
@@ -436,8 +431,8 @@ void checkTimeouts(void)
     {
         if (btnState == HandActuation::BUTTON_PRESSED)
         {
-            channel_timeout[btnNumber].On.stop();
-            channel_timeout[btnNumber].Off.stop();
+            timeouts.stop(TIMEOUT_ON(btnNumber));
+            timeouts.stop(TIMEOUT_OFF(btnNumber));
 
             if (relays.blocked(btnNumber))
                 relays.clearBlocked(btnNumber);
@@ -449,47 +444,51 @@ void checkTimeouts(void)
 
     // check if we can enable PWM
     relays.checkPWM();
-    for (unsigned int objno = 0; objno < (sizeof(channel_timeout)/sizeof(channel_timeout[0])); ++objno)
+    // switch the next queued channel
+    relays.checkSwitchQueue();
+    // the expired on/off delays, in the order of their deadlines
+    int timeout;
+    while ((timeout = timeouts.nextExpired()) >= 0)
     {
-        unsigned int offTimedout = channel_timeout[objno].Off.expired();
-        unsigned int onTimedout = channel_timeout[objno].On.expired();
-
-        if (offTimedout || onTimedout)
-        {
-            unsigned int newValue = (onTimedout == true);
-            relays.updateChannel(objno, newValue);
-            bcu.comObjects->objectWrite(objno, newValue);
-            _handle_timed_functions(objno, newValue);
-            _handle_logic_function(objno, newValue);
-        }
+        int objno = timeout / 2;
+        unsigned int newValue = (timeout == TIMEOUT_ON(objno));
+        relays.updateChannel(objno, newValue);
+        bcu.comObjects->objectWrite(objno, newValue);
+        _handle_timed_functions(objno, newValue);
+        _handle_logic_function(objno, newValue);
     }
 
     if (relays.pendingChanges())
         _switchObjects(BETWEEN_CHANNEL_DELAY_MS);
+
+    // the feedback of the channels changed within FEEDBACK_DELAY_MS
+    if (feedbackFilter.expired())
+        _writeFeedbackObjects(false);
 }
 
-static void _sendFeedbackObjects(bool forcesendFeedbackObjects)
+/*
+ * Write the feedback objects which differ from the values written last,
+ * all of them in one pass.
+ */
+static void _writeFeedbackObjects(bool forceSendFeedback)
 {
-    unsigned int changed = relays.pendingChanges ();
-
-    if (changed || forcesendFeedbackObjects)
-    {   // at least one output has changed,
-        // -> update the corresponding feedback objects
-        unsigned int i;
-        unsigned int mask = 0x01;
-        unsigned int invert = (*(bcu.userEeprom))[APP_REPORT_BACK_INVERT];
-        for (i = 0; i < 8; i++)
-        {
-            if ((changed & mask) || forcesendFeedbackObjects)
-            {   // update feedback object
-            	unsigned int value = relays.channel(i);
-            	if (invert & mask)
-            		value ^= 0x01;
-            	bcu.comObjects->objectWrite(COMOBJ_FEEDBACK1 + i, value);
-            }
-            mask <<= 1;
-        }
-   }
+    unsigned int channels = (1 << NO_OF_CHANNELS) - 1;
+    unsigned int feedback = (relays.channels() ^ (*(bcu.userEeprom))[APP_REPORT_BACK_INVERT]) & channels;
+    unsigned int changed  = feedbackFilter.update(feedback, forceSendFeedback ? channels : 0);
+
+    for (unsigned int objno = COMOBJ_FEEDBACK1; changed; objno++)
+    {
+        if (changed & 0x01)
+            bcu.comObjects->objectWrite(objno, feedback & 0x01);
+        changed  >>= 1;
+        feedback >>= 1;
+    }
+}
+
+static void _sendFeedbackObjects(bool forceSendFeedback)
+{
+    if (forceSendFeedback || feedbackFilter.changed())
+        _writeFeedbackObjects(forceSendFeedback);
 }
 
 static void _switchObjects(unsigned int delayms)
@@ -607,6 +606,8 @@ void initApplication(int lastRelayState)
         }
     }
     */
+    decodeConfiguration();
+
     // check logic functions, maybe channels need to be blocked
     for (i=COMOBJ_INPUT1; i < (sizeof(initialOutputState)/sizeof(initialOutputState[0])); i++)
         _handle_logic_function(i, bcu.comObjects->objectRead(i)); // handle the logic functions for the channel
@@ -620,23 +621,25 @@ void initApplication(int lastRelayState)
     relays.setHandActuation(&handAct);
 #endif
 
-    // switch the relays according to newRelaystate and send feedback objects
-
-    _switchObjects();
+    // switch the relays according to newRelaystate and send all feedback objects
+    _sendFeedbackObjects(true);
+    relays.updateOutputs();
 }
 
 void stopApplication()
 {
     // stop all running timers
-    for (unsigned int i = 0; i < (sizeof(channel_timeout)/sizeof(channel_timeout[0])); i++)
+    for (unsigned int i = 0; i < NO_OF_CHANNELS; i++)
     {
-      channel_timeout[i].Off.stop();
-      channel_timeout[i].On.stop();
+      timeouts.stop(TIMEOUT_OFF(i));
+      timeouts.stop(TIMEOUT_ON(i));
     }
 
 #ifndef BI_STABLE
     pinMode(PIN_PWM, OUTPUT); //switch off PWM for mono-stable relays
     digitalWrite(PIN_PWM, 1);
+#else
+    relays.stopPulses(); // no coil must be left driven
 #endif
 
     //switch off all possible active relay coils, to save some power
@@ -671,7 +674,7 @@ static unsigned int _init_timed_functions(const int objno, const unsigned int va
     unsigned int state = tfsUnknown;
 
     // check that objno is in a valid range
-    if ((objno < COMOBJ_INPUT1) || (objno >= int(sizeof(channel_timeout)/sizeof(channel_timeout[0]))))
+    if ((objno < COMOBJ_INPUT1) || (objno >= NO_OF_CHANNELS))
         return tfsUnknown;
 
     TimerConfig timercfg = getTimerCfg(objno);
@@ -679,8 +682,8 @@ static unsigned int _init_timed_functions(const int objno, const unsigned int va
     // channel with no on/off delay or timed function mode
     if (!timercfg.timerOffFactor && !timercfg.timerOnFactor)
     {
-        channel_timeout[objno].On.stop();
-        channel_timeout[objno].Off.stop();
+        timeouts.stop(TIMEOUT_ON(objno));
+        timeouts.stop(TIMEOUT_OFF(objno));
         return tfsDisabled;
     }
 
@@ -689,20 +692,20 @@ static unsigned int _init_timed_functions(const int objno, const unsigned int va
     {   // this is the on/off delay mode
         if (!value && timercfg.timerOffFactor) // Check if a delay is configured for falling edge / Off
         {
-            channel_timeout[objno].On.stop();
-            channel_timeout[objno].Off.start(timercfg.delayMs * timercfg.timerOffFactor);
+            timeouts.stop(TIMEOUT_ON(objno));
+            timeouts.start(TIMEOUT_OFF(objno), timercfg.delayMs * timercfg.timerOffFactor);
             state |= tfsOffDelayed;
         }
         else if (value && timercfg.timerOnFactor)  // Check if a delay is configured for raising edge / On
         {
-            channel_timeout[objno].Off.stop();
-            channel_timeout[objno].On.start(timercfg.delayMs * timercfg.timerOnFactor);
+            timeouts.stop(TIMEOUT_OFF(objno));
+            timeouts.start(TIMEOUT_ON(objno), timercfg.delayMs * timercfg.timerOnFactor);
             state |= tfsOnDelayed;
         }
         else
         {
-            channel_timeout[objno].On.stop();
-            channel_timeout[objno].Off.stop();
+            timeouts.stop(TIMEOUT_ON(objno));
+            timeouts.stop(TIMEOUT_OFF(objno));
             state = tfsDisabled;
         }
     }
@@ -712,13 +715,13 @@ static unsigned int _init_timed_functions(const int objno, const unsigned int va
         {
             if (timercfg.timerOffFactor ) // channel with off delay
             {
-                channel_timeout[objno].Off.start(timercfg.delayMs * timercfg.timerOffFactor);
+                timeouts.start(TIMEOUT_OFF(objno), timercfg.delayMs * timercfg.timerOffFactor);
                 state |= tfsOffDelayed;
             }
 
             if (timercfg.timerOnFactor) // channel with on delay
             {
-                channel_timeout[objno].On.start(timercfg.delayMs * timercfg.timerOnFactor);
+                timeouts.start(TIMEOUT_ON(objno), timercfg.delayMs * timercfg.timerOnFactor);
                 state |= tfsOnDelayed;
             }
         }
@@ -0,0 +1,38 @@
+/*
+ *  feedback_filter.cpp - Decides which feedback objects of the channels are written
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "feedback_filter.h"
+
+FeedbackFilter::FeedbackFilter(unsigned int delayms)
+  : _delayms(delayms)
+  , _written(0)
+{
+}
+
+bool FeedbackFilter::changed(void)
+{
+    if (!_delayms)
+        return true;
+    if (_delay.stopped())
+        _delay.start(_delayms);
+    return false;
+}
+
+bool FeedbackFilter::expired(void)
+{
+    return _delay.expired();
+}
+
+unsigned int FeedbackFilter::update(unsigned int feedback, unsigned int force)
+{
+    unsigned int changes = (feedback ^ _written) | force;
+
+    _delay.stop();
+    _written = feedback;
+    return changes;
+}
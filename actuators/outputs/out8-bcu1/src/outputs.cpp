@@ -17,11 +17,6 @@
     Outputs relays;
 #endif
 
-const unsigned int zeroDetectSetDelay = 0x0200; //0x0200 Omron G5Q-1A EU 10A set
-const unsigned int zeroDetectClrDelay = 0x0240; //0x0220 Omron G5Q-1A EU 10A clear
-
-#define ZD_RESET ((zeroDetectSetDelay > zeroDetectClrDelay ? zeroDetectSetDelay : zeroDetectClrDelay) + 1)
-
 
 void Outputs::begin(unsigned int initial, unsigned int inverted, unsigned int channelcount)
 {
@@ -47,23 +42,23 @@ void Outputs::begin(unsigned int initial, unsigned int inverted, unsigned int ch
     _relayState     = initial;
     _prevRelayState = (~_relayState) & ((1 << _channelcount) -1);
     _inverted       = inverted;
+    _queued         = 0;
+    _switch_timeout.stop();
 
 #ifdef HAND_ACTUATION
     _handAct = nullptr;
 #endif
 
 #ifdef ZERO_DETECT
-    _state           = 0; // wait for next required switch
+    _zcArmed    = 0;
     _port_0_set = _port_0_clr = _port_2_set = _port_2_clr = 0;
+    // free running with 10us, the time base of the zero cross scheduler
     timer32_0.begin();
     timer32_0.prescaler((SystemCoreClock / 100000) - 1);
-    timer32_0.matchMode(MAT3, RESET | STOP);
-    timer32_0.matchMode(MAT0, INTERRUPT);
-    timer32_0.matchMode(MAT1, INTERRUPT);
-    timer32_0.match(MAT0, zeroDetectSetDelay);
-    timer32_0.match(MAT1, zeroDetectClrDelay);
-    timer32_0.match(MAT3, ZD_RESET);
+    timer32_0.matchMode(MAT0, INTERRUPT); // coils of the channels to switch on
+    timer32_0.matchMode(MAT1, INTERRUPT); // coils of the channels to switch off
     timer32_0.interrupts();
+    timer32_0.start();
 #endif
 }
 
@@ -93,12 +88,23 @@ unsigned int Outputs::updateOutput(unsigned int channel)
     unsigned int mask      = 1 << channel;
     unsigned int state     = (mask & (_relayState ^ _inverted)) >> channel;
     unsigned int prevState = (mask & (_prevRelayState ^  _inverted)) >> channel;
-    unsigned int value     = (state ^ prevState) & state;
-    unsigned int result    = false;
 
     if (!(state ^ prevState))
         return false; // nothing to do
 
+    _prevRelayState ^= mask; // toggle the bit of the channel we changed
+    _queued         &= ~mask; // switched now, not again by checkSwitchQueue()
+    return switchOutput(channel, state);
+}
+
+/*
+ * Drive the output pin of a channel, value is the level of the pin.
+ * returns true in case a switching action was started which drained the bus
+ */
+unsigned int Outputs::switchOutput(unsigned int channel, unsigned int value)
+{
+    unsigned int result = false;
+
 #ifndef ZERO_DETECT
     if (value)
     {
@@ -110,26 +116,20 @@ unsigned int Outputs::updateOutput(unsigned int channel)
 #endif
 
     unsigned int pinMask = digitalPinToBitMask(_outputPins[channel]);
+    noInterrupts(); // the timer interrupt of the zero crossing clears the masks
     if (digitalPinToPort(_outputPins[channel]) != 0)
-    {
-        if (value) _port_2_set |= pinMask;
-        else       _port_2_clr |= pinMask;
-    }
+        zeroCrossAddPin(_port_2_set, _port_2_clr, pinMask, value);
     else
-    {
-        if (value) _port_0_set |= pinMask;
-        else       _port_0_clr |= pinMask;
-    }
+        zeroCrossAddPin(_port_0_set, _port_0_clr, pinMask, value);
+    interrupts();
 
 #ifdef HAND_ACTUATION
     if (_handAct != nullptr)
         _handAct->setLedState(channel, value, false);
 #endif
 
-    _prevRelayState ^= mask; // toggle the bit of the channel we changed
-
 #ifdef ZERO_DETECT
-    _state = 1;
+    scheduleZeroCross();
 #else
     setOutputs();
     clrOutputs();
@@ -138,19 +138,89 @@ unsigned int Outputs::updateOutput(unsigned int channel)
     return result;
 }
 
+/*
+ * With a delay the changed channels are only queued, checkSwitchQueue()
+ * switches them one after the other from the main loop. The new state is
+ * taken over at once, so the feedback can be sent and the main loop keeps
+ * processing telegrams while the relays follow.
+ */
 void Outputs::updateOutputs(unsigned int delayms)
 {
-    for(unsigned int i = 0; i < _channelcount; i++)
+    if (delayms <= PWM_TIMEOUT)
     {
-        if (updateOutput(i) && pendingChanges() && (delayms > PWM_TIMEOUT))
+        for(unsigned int i = 0; i < _channelcount; i++)
+            updateOutput(i);
+        return;
+    }
+
+    unsigned int changes = pendingChanges();
+    _prevRelayState ^= changes;
+    _queued         |= changes;
+    _switchDelay     = delayms;
+    checkSwitchQueue();
+}
+
+/*
+ * Switch the queued channels, after a switching action which drained the
+ * bus the next channel waits for the delay given to updateOutputs().
+ * Has to be called from the main loop, like checkPWM().
+ */
+void Outputs::checkSwitchQueue(void)
+{
+    if (!_queued)
+        return;
+    if (_switch_timeout.started() && !_switch_timeout.expired())
+        return;
+
+    for (unsigned int channel = 0; channel < _channelcount; channel++)
+    {
+        unsigned int mask = 1 << channel;
+        if (!(_queued & mask))
+            continue;
+        _queued &= ~mask;
+        // the newest state, the channel may have changed again while queued
+        unsigned int value = (mask & (_prevRelayState ^ _inverted)) >> channel;
+        if (switchOutput(channel, value) && _queued)
         {
-            delay(PWM_TIMEOUT);
-            checkPWM();
-            delay(delayms-PWM_TIMEOUT);
+            _switch_timeout.start(_switchDelay);
+            return;
         }
     }
 }
 
+#ifdef ZERO_DETECT
+/*
+ * Fire the coils so that the contacts move in the next zero crossing which
+ * can still be reached. Channels changed until the coils are fired are
+ * switched in the same zero crossing.
+ */
+void Outputs::scheduleZeroCross(void)
+{
+    unsigned int now = timer32_0.value();
+
+    if (!_zeroCross.locked(now))
+    {   // no mains or not synchronized yet, do not wait for a zero crossing
+        setOutputs();
+        clrOutputs();
+        return;
+    }
+
+    unsigned int zero = _zeroCross.nextZeroCross(now);
+    noInterrupts();
+    if ((_port_0_set || _port_2_set) && !(_zcArmed & ZC_ARMED_SET))
+    {
+        timer32_0.match(MAT0, zero - _zeroCross.operateTime());
+        _zcArmed |= ZC_ARMED_SET;
+    }
+    if ((_port_0_clr || _port_2_clr) && !(_zcArmed & ZC_ARMED_CLR))
+    {
+        timer32_0.match(MAT1, zero - _zeroCross.releaseTime());
+        _zcArmed |= ZC_ARMED_CLR;
+    }
+    interrupts();
+}
+#endif
+
 unsigned int Outputs::channelCount()
 {
     return _channelcount;
@@ -183,15 +253,7 @@ extern "C" void PIOINT0_IRQHandler (void)
 
 extern "C" void TIMER32_0_IRQHandler(void)
 {
-    if (timer32_0.flags () & 0x01)
-    {   // handle SET ports
-        relays.setOutputs();
-    }
-    if (timer32_0.flags () & 0x02)
-    {   // handle CLR ports
-        relays.clrOutputs();
-    }
-    timer32_0.resetFlags();
+    relays.zeroCrossTimerHandler();
     digitalWrite(PIN_INFO, ! digitalRead(PIN_INFO));
 }
 #endif
@@ -14,17 +14,69 @@
 #define pinOff(ch) (ch*2+1)
 #define pinOn(ch)  (ch*2)
 
-unsigned int OutputsBiStable::updateOutput(unsigned int channel)
+void OutputsBiStable::begin(unsigned int initial, unsigned int inverted, unsigned int channelcount)
 {
-    unsigned int mask      = 1 << channel;
-    unsigned int state     = (mask & (_relayState ^ _inverted)) >> channel;
-    unsigned int prevState = (mask & (_prevRelayState ^  _inverted)) >> channel;
-    unsigned int value     = (state ^ prevState) & state;
+    _pulseSet = _pulseReset = _completed = 0;
+    _pulseState = PULSE_IDLE;
 
-    if (!(state ^ prevState))
-        return false; // nothing to do
+    timer16_0.begin();
+    timer16_0.prescaler((SystemCoreClock / 100000) - 1);
+    timer16_0.matchMode(MAT0, INTERRUPT | RESET | STOP); // one shot, end of the pulse or the pause
+    timer16_0.interrupts();
 
+    Outputs::begin(initial, inverted, channelcount);
+}
+
+/*
+ * The pulse is only requested here, the sequencer keeps the supply load
+ * at one coil, so no delay between the channels is needed.
+ */
+unsigned int OutputsBiStable::switchOutput(unsigned int channel, unsigned int value)
+{
+    unsigned int mask = 1 << channel;
+
+    noInterrupts();
     if (value)
+    {
+        _pulseSet   |=  mask;
+        _pulseReset &= ~mask;
+    }
+    else
+    {
+        _pulseReset |=  mask;
+        _pulseSet   &= ~mask;
+    }
+    if (_pulseState == PULSE_IDLE)
+        nextPulse();
+    interrupts();
+    return false;
+}
+
+void OutputsBiStable::startPulseTimer(unsigned int ms)
+{
+    timer16_0.match(MAT0, ms * PULSE_TICKS_PER_MS);
+    timer16_0.restart();
+}
+
+/*
+ * Start the pulse of the lowest waiting channel, called with the
+ * interrupts disabled or from the timer interrupt.
+ */
+void OutputsBiStable::nextPulse(void)
+{
+    unsigned int waiting = _pulseSet | _pulseReset;
+    unsigned int channel = 0;
+
+    if (!waiting)
+    {
+        _pulseState = PULSE_IDLE;
+        return;
+    }
+    while (!(waiting & (1 << channel)))
+        channel++;
+
+    unsigned int mask = 1 << channel;
+    if (_pulseSet & mask)
     {
         digitalWrite(_outputPins[pinOff(channel)], 0);
         digitalWrite(_outputPins[pinOn(channel)],  1);
@@ -34,28 +86,79 @@ unsigned int OutputsBiStable::updateOutput(unsigned int channel)
         digitalWrite(_outputPins[pinOn(channel)],  0);
         digitalWrite(_outputPins[pinOff(channel)], 1);
     }
+    _pulseSet     &= ~mask;
+    _pulseReset   &= ~mask;
+    _pulseChannel  = channel;
+    _pulseState    = PULSE_COIL_ON;
+    startPulseTimer(ON_DELAY);
+}
+
+void OutputsBiStable::pulseTimerHandler(void)
+{
+    timer16_0.resetFlags();
+    if (_pulseState == PULSE_COIL_ON)
+    {   // end of the pulse, let the supply recover before the next one
+        digitalWrite(_outputPins[pinOn(_pulseChannel)],  0);
+        digitalWrite(_outputPins[pinOff(_pulseChannel)], 0);
+        _completed |= 1 << _pulseChannel;
+        _pulseState = PULSE_RECOVER;
+        startPulseTimer(PULSE_PAUSE);
+    }
+    else
+        nextPulse();
+}
 
-    _prevRelayState ^= mask; // toggle the bit of the channel we changed
-    _pwm_timeout.start(ON_DELAY);
+/*
+ * Report the completed pulses to the main loop.
+ */
+void OutputsBiStable::checkPWM(void)
+{
+    noInterrupts();
+    unsigned int completed = _completed;
+    _completed = 0;
+    interrupts();
 
 #ifdef HAND_ACTUATION
-    if (_handAct != nullptr)
-        _handAct->setLedState(channel, value);
+    for (unsigned int channel = 0; completed; channel++, completed >>= 1)
+    {
+        if ((completed & 0x01) && (_handAct != nullptr))
+            _handAct->setLedState(channel, ((_prevRelayState ^ _inverted) >> channel) & 0x01);
+    }
+#else
+    (void) completed;
 #endif
-    return true;
 }
 
-void OutputsBiStable::checkPWM(void)
+/*
+ * Can be called from an interrupt service routine (bus voltage failure).
+ * A running pulse is cut short instead of waiting for its end, the coil
+ * would otherwise drain the supply that is left for saving the state.
+ * This is safe as begin() pulses every channel again after the bus
+ * voltage has returned.
+ */
+void OutputsBiStable::stopPulses(void)
 {
-    if (_pwm_timeout.started () && _pwm_timeout.expired ())
+    noInterrupts();
+    _pulseSet = _pulseReset = 0;
+    timer16_0.stop();
+    timer16_0.resetFlags();
+    NVIC_ClearPendingIRQ(TIMER_16_0_IRQn); // no late interrupt of the stopped timer
+    if (_pulseState == PULSE_COIL_ON)
     {
-        for (unsigned int i = 0; i < outputCount(); i++)
-            digitalWrite (_outputPins[i], 0);
+        digitalWrite(_outputPins[pinOn(_pulseChannel)],  0);
+        digitalWrite(_outputPins[pinOff(_pulseChannel)], 0);
     }
+    _pulseState = PULSE_IDLE;
+    interrupts();
 }
 
 #ifdef BI_STABLE
     OutputsBiStable relays;
+
+extern "C" void TIMER16_0_IRQHandler(void)
+{
+    relays.pulseTimerHandler();
+}
 #endif
 
 
@@ -0,0 +1,70 @@
+/*
+ *  timeout_queue.cpp - Timeouts of the channels, sorted by their deadline
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <sblib/timer.h>
+#include "timeout_queue.h"
+
+TimeoutQueue::TimeoutQueue()
+  : _first(TIMEOUT_QUEUE_END)
+  , _running(0)
+{
+    for (unsigned int id = 0; id < TIMEOUT_QUEUE_SIZE; id++)
+    {
+        _deadline[id] = 0;
+        _next[id]     = TIMEOUT_QUEUE_END;
+    }
+}
+
+void TimeoutQueue::start(unsigned int id, unsigned int msec)
+{
+    unsigned int deadline = millis() + msec;
+
+    remove(id);
+    // behind all timeouts with the same or an earlier deadline
+    byte * link = &_first;
+    while ((*link != TIMEOUT_QUEUE_END) && ((int) (_deadline[*link] - deadline) <= 0))
+        link = &_next[*link];
+    _deadline[id] = deadline;
+    _next[id]     = *link;
+    *link         = id;
+    _running     |= 1 << id;
+}
+
+void TimeoutQueue::stop(unsigned int id)
+{
+    remove(id);
+}
+
+void TimeoutQueue::remove(unsigned int id)
+{
+    if (!started(id))
+        return;
+    byte * link = &_first;
+    while (*link != id)
+        link = &_next[*link];
+    *link     = _next[id];
+    _running &= ~(1 << id);
+}
+
+bool TimeoutQueue::expired(unsigned int id)
+{
+    if (!started(id) || ((int) (millis() - _deadline[id]) < 0))
+        return false;
+    remove(id);
+    return true;
+}
+
+int TimeoutQueue::nextExpired(void)
+{
+    unsigned int id = _first;
+    if ((id == TIMEOUT_QUEUE_END) || ((int) (millis() - _deadline[id]) < 0))
+        return -1;
+    _first    = _next[id];
+    _running &= ~(1 << id);
+    return id;
+}
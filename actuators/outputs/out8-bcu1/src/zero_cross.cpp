@@ -0,0 +1,119 @@
+/*
+ *  zero_cross.cpp - Predict the zero crossings of the mains voltage from the
+ *                   edges of the zero detector
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "zero_cross.h"
+
+ZeroCrossScheduler::ZeroCrossScheduler()
+  : _period16(0)
+  , _lastEdge(0)
+  , _nextEdge(0)
+  , _edges(0)
+  , _rejected(0)
+  , _locked(false)
+  , _operateTime(ZC_OPERATE_TIME)
+  , _releaseTime(ZC_RELEASE_TIME)
+{
+}
+
+/*
+ * not locked: wait for ZC_LOCK_EDGES periods which differ by less than
+ * 1/16 from their average
+ */
+void ZeroCrossScheduler::acquire(unsigned int time)
+{
+    unsigned int dt = time - _lastEdge;
+    _lastEdge = time;
+    if ((dt < ZC_MIN_PERIOD) || (dt > ZC_MAX_PERIOD))
+    {
+        _edges = 0;
+        return;
+    }
+    unsigned int dt16 = dt << 4;
+    unsigned int diff = dt16 > _period16 ? dt16 - _period16 : _period16 - dt16;
+    if (!_edges || (diff > _period16 / 16))
+    {   // start again with this period
+        _period16 = dt16;
+        _edges    = 1;
+        return;
+    }
+    _period16 = (_period16 * _edges + dt16) / (_edges + 1);
+    if (++_edges >= ZC_LOCK_EDGES)
+    {
+        _locked   = true;
+        _rejected = 0;
+        _nextEdge = time + (_period16 >> 4);
+    }
+}
+
+void ZeroCrossScheduler::edge(unsigned int time)
+{
+    if (_locked && !locked(time))
+    {   // no edges for a while, the mains has been gone
+        _locked = false;
+        _edges  = 0;
+    }
+    if (!_locked)
+    {
+        acquire(time);
+        return;
+    }
+
+    int period = _period16 >> 4;
+    unsigned int predicted = _nextEdge;
+    int error  = time - predicted;
+    if (error > period / 2)
+    {   // edges have been missed, compare with the prediction of this edge
+        unsigned int missed = (error + period / 2) / period;
+        predicted += (missed * _period16 + 8) >> 4;
+        error = time - predicted;
+    }
+    if ((error > period / 8) || (error < -period / 8))
+    {   // a spike on the mains, not the zero crossing
+        if (++_rejected >= ZC_MAX_REJECTED)
+        {
+            _locked   = false;
+            _edges    = 0;
+            _lastEdge = time;
+        }
+        return;
+    }
+    _rejected  = 0;
+    // a spike close to the prediction cannot be told from a late edge,
+    // limit what a single edge can change
+    if (error > ZC_MAX_CORRECTION)
+        error = ZC_MAX_CORRECTION;
+    if (error < -ZC_MAX_CORRECTION)
+        error = -ZC_MAX_CORRECTION;
+    _lastEdge  = predicted + error / 4;
+    _period16 += error; // 1/16 of the error in ticks
+    if (_period16 < (ZC_MIN_PERIOD << 4))
+        _period16 = ZC_MIN_PERIOD << 4;
+    if (_period16 > (ZC_MAX_PERIOD << 4))
+        _period16 = ZC_MAX_PERIOD << 4;
+    _nextEdge  = _lastEdge + ((_period16 + 8) >> 4);
+}
+
+unsigned int ZeroCrossScheduler::nextZeroCross(unsigned int now) const
+{
+    unsigned int half16 = _period16 / 2;
+    unsigned int coil   = _operateTime > _releaseTime ? _operateTime : _releaseTime;
+    unsigned int base   = _lastEdge + ZC_DETECTOR_OFFSET;
+    int ahead = now + ZC_MIN_LEAD + coil - base;
+    unsigned int n = 0;
+
+    if (ahead > 0)
+        n = ((ahead << 4) + half16 - 1) / half16;
+    return base + ((n * half16) >> 4);
+}
+
+void ZeroCrossScheduler::contactMoved(bool closing, unsigned int delay)
+{
+    unsigned int & learned = closing ? _operateTime : _releaseTime;
+    learned += ((int) delay - (int) learned) / 4;
+}
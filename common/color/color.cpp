@@ -0,0 +1,218 @@
+/*
+ *  color.cpp - Integer conversion between the HSV and RGB(W) color spaces
+ *              and color fades in the HSV and RGBW space for the LED controllers.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "color.h"
+
+#define FADE_FIXED(value) ((value) * 65536)
+
+/*
+ * The hue is split into 6 sectors of 255/6 with fraction fr/255. The
+ * floating point formulas are
+ *   p = v * (1 - s)
+ *   q = v * (1 - s * f)
+ *   t = v * (1 - s * (1 - f))
+ * with s and f in 0..1. With s and f scaled to 0..255 the divisors are
+ * 255 and 255*255, both are odd so the rounding never hits a tie.
+ */
+void hsvToRgb(const ColorHsv & hsv, ColorRgbw & rgb)
+{
+    unsigned int v  = hsv.v;
+    unsigned int s  = hsv.s;
+    unsigned int hh = hsv.h * 6;
+    unsigned int sector = hh / 255;
+    unsigned int fr     = hh - sector * 255;
+
+    unsigned int p = (v * (255 - s) + 127) / 255;
+    unsigned int q = (v * (65025 - s * fr) + 32512) / 65025;
+    unsigned int t = (v * (65025 - s * (255 - fr)) + 32512) / 65025;
+
+    rgb.w = 0;
+    switch (sector)
+    {
+    case 1:  rgb.r = q; rgb.g = v; rgb.b = p; break;
+    case 2:  rgb.r = p; rgb.g = v; rgb.b = t; break;
+    case 3:  rgb.r = p; rgb.g = q; rgb.b = v; break;
+    case 4:  rgb.r = t; rgb.g = p; rgb.b = v; break;
+    case 5:  rgb.r = v; rgb.g = p; rgb.b = q; break;
+    default: rgb.r = v; rgb.g = t; rgb.b = p; break; // sector 0 and hue 255
+    }
+}
+
+void rgbToHsv(const ColorRgbw & rgb, ColorHsv & hsv)
+{
+    unsigned int max = rgb.r;
+    unsigned int min = rgb.r;
+    int n;
+
+    if (rgb.g > max) max = rgb.g;
+    if (rgb.b > max) max = rgb.b;
+    if (rgb.g < min) min = rgb.g;
+    if (rgb.b < min) min = rgb.b;
+
+    int delta = max - min;
+    hsv.v = max;
+    if (!delta)
+    {
+        hsv.h = 0;
+        hsv.s = 0;
+        return;
+    }
+    hsv.s = (510 * delta + max) / (2 * max);
+
+    // the hue in sixths of the color circle is n / delta
+    if (max == rgb.r)
+    {
+        n = rgb.g - rgb.b;
+        if (n < 0)
+            n += 6 * delta;
+    }
+    else if (max == rgb.g)
+        n = rgb.b - rgb.r + 2 * delta;
+    else
+        n = rgb.r - rgb.g + 4 * delta;
+    hsv.h = (510 * n + 6 * delta) / (12 * delta);
+}
+
+void extractWhite(ColorRgbw & rgbw)
+{
+    unsigned char white = rgbw.r;
+    if (rgbw.g < white) white = rgbw.g;
+    if (rgbw.b < white) white = rgbw.b;
+    rgbw.r -= white;
+    rgbw.g -= white;
+    rgbw.b -= white;
+    rgbw.w  = white;
+}
+
+HsvFade::HsvFade()
+  : ticksLeft(0)
+{
+    targetColor.h = 0;
+    targetColor.s = 0;
+    targetColor.v = 0;
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        current[i]   = 0;
+        increment[i] = 0;
+    }
+}
+
+void HsvFade::start(const ColorHsv & from, const ColorHsv & to, unsigned int ticks)
+{
+    targetColor = to;
+    ticksLeft   = ticks;
+    if (!ticks)
+    {
+        current[0] = FADE_FIXED(to.h);
+        current[1] = FADE_FIXED(to.s);
+        current[2] = FADE_FIXED(to.v);
+        return;
+    }
+    current[0] = FADE_FIXED(from.h);
+    current[1] = FADE_FIXED(from.s);
+    current[2] = FADE_FIXED(from.v);
+    // the hue wraps around, the signed 8 bit difference is the shorter way
+    increment[0] = FADE_FIXED((signed char) (to.h - from.h)) / (int) ticks;
+    increment[1] = FADE_FIXED(to.s - from.s) / (int) ticks;
+    increment[2] = FADE_FIXED(to.v - from.v) / (int) ticks;
+}
+
+void HsvFade::stop(void)
+{
+    ticksLeft = 0;
+}
+
+bool HsvFade::step(void)
+{
+    if (!ticksLeft)
+        return false;
+    for (unsigned int i = 0; i < 3; i++)
+        current[i] += increment[i];
+    if (--ticksLeft)
+        return false;
+    current[0] = FADE_FIXED(targetColor.h);
+    current[1] = FADE_FIXED(targetColor.s);
+    current[2] = FADE_FIXED(targetColor.v);
+    return true;
+}
+
+ColorHsv HsvFade::color(void) const
+{
+    ColorHsv result;
+    result.h = (current[0] + 0x8000) >> 16; // modulo 256, the hue may have wrapped around
+    result.s = (current[1] + 0x8000) >> 16;
+    result.v = (current[2] + 0x8000) >> 16;
+    return result;
+}
+
+RgbwFade::RgbwFade()
+  : ticksLeft(0)
+{
+    targetColor.r = 0;
+    targetColor.g = 0;
+    targetColor.b = 0;
+    targetColor.w = 0;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        current[i]   = 0;
+        increment[i] = 0;
+    }
+}
+
+void RgbwFade::start(const ColorRgbw & from, const ColorRgbw & to, unsigned int ticks)
+{
+    targetColor = to;
+    ticksLeft   = ticks;
+    if (!ticks)
+    {
+        current[0] = FADE_FIXED(to.r);
+        current[1] = FADE_FIXED(to.g);
+        current[2] = FADE_FIXED(to.b);
+        current[3] = FADE_FIXED(to.w);
+        return;
+    }
+    current[0] = FADE_FIXED(from.r);
+    current[1] = FADE_FIXED(from.g);
+    current[2] = FADE_FIXED(from.b);
+    current[3] = FADE_FIXED(from.w);
+    increment[0] = FADE_FIXED(to.r - from.r) / (int) ticks;
+    increment[1] = FADE_FIXED(to.g - from.g) / (int) ticks;
+    increment[2] = FADE_FIXED(to.b - from.b) / (int) ticks;
+    increment[3] = FADE_FIXED(to.w - from.w) / (int) ticks;
+}
+
+void RgbwFade::stop(void)
+{
+    ticksLeft = 0;
+}
+
+bool RgbwFade::step(void)
+{
+    if (!ticksLeft)
+        return false;
+    for (unsigned int i = 0; i < 4; i++)
+        current[i] += increment[i];
+    if (--ticksLeft)
+        return false;
+    current[0] = FADE_FIXED(targetColor.r);
+    current[1] = FADE_FIXED(targetColor.g);
+    current[2] = FADE_FIXED(targetColor.b);
+    current[3] = FADE_FIXED(targetColor.w);
+    return true;
+}
+
+ColorRgbw RgbwFade::color(void) const
+{
+    ColorRgbw result;
+    result.r = (current[0] + 0x8000) >> 16;
+    result.g = (current[1] + 0x8000) >> 16;
+    result.b = (current[2] + 0x8000) >> 16;
+    result.w = (current[3] + 0x8000) >> 16;
+    return result;
+}
@@ -0,0 +1,169 @@
+/*
+ *  color.h - Integer conversion between the HSV and RGB(W) color spaces
+ *            and color fades in the HSV and RGBW space for the LED controllers.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ *
+ *  All components are 0..255, the hue covers the full color circle like
+ *  the KNX HSV objects (0 = 255 = red, 85 = green, 170 = blue).
+ *
+ *  The conversions only use integer arithmetic. The results are the ones
+ *  of the floating point formulas rounded to the nearest integer, for all
+ *  16.7 million input colors.
+ */
+
+#ifndef COMMON_COLOR_COLOR_H_
+#define COMMON_COLOR_COLOR_H_
+
+struct ColorHsv
+{
+    unsigned char h;
+    unsigned char s;
+    unsigned char v;
+};
+
+struct ColorRgbw
+{
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char w;
+};
+
+/**
+ * Convert a HSV color to RGB, the white component is set to 0.
+ */
+void hsvToRgb(const ColorHsv & hsv, ColorRgbw & rgb);
+
+/**
+ * Convert the RGB components of a color to HSV, the white component is
+ * ignored. Gray and black have the hue 0, black has the saturation 0.
+ */
+void rgbToHsv(const ColorRgbw & rgb, ColorHsv & hsv);
+
+/**
+ * Move the part of the color which is common to red, green and blue to
+ * the white channel of a RGBW controller.
+ */
+void extractWhite(ColorRgbw & rgbw);
+
+/**
+ * A fade from one color to another in the HSV space. The hue moves the
+ * shorter way around the color circle, saturation and brightness
+ * change linearly. The fade is advanced with step() once per tick, for
+ * example per PWM period, which only costs three additions. The target
+ * is reached exactly after the number of ticks given to start().
+ */
+class HsvFade
+{
+public:
+    HsvFade();
+
+    /**
+     * Start a fade.
+     *
+     * @param from the color at the start
+     * @param to the color at the end
+     * @param ticks the number of steps of the fade, 0 jumps to the target
+     */
+    void start(const ColorHsv & from, const ColorHsv & to, unsigned int ticks);
+
+    void stop(void);
+
+    /**
+     * Advance the fade by one tick.
+     *
+     * @return true if the target has been reached with this step
+     */
+    bool step(void);
+
+    bool isRunning(void) const;
+
+    /**
+     * @return the current color of the fade
+     */
+    ColorHsv color(void) const;
+
+    /**
+     * @return the color at the end of the fade
+     */
+    const ColorHsv & target(void) const;
+
+protected:
+    unsigned int current[3];   //!< h, s, v as fixed point numbers with 16 fraction bits
+    int          increment[3]; //!< change of h, s and v per tick
+    unsigned int ticksLeft;    //!< steps until the target is reached
+    ColorHsv     targetColor;
+};
+
+inline bool HsvFade::isRunning(void) const
+{
+    return ticksLeft != 0;
+}
+
+inline const ColorHsv & HsvFade::target(void) const
+{
+    return targetColor;
+}
+
+/**
+ * A linear fade of the four channels of a RGBW color, for example to a
+ * scene. All channels start and reach their target in the same tick, the
+ * mixed color does not drift during the fade. Like HsvFade, step() is
+ * called once per tick and only does additions.
+ */
+class RgbwFade
+{
+public:
+    RgbwFade();
+
+    /**
+     * Start a fade.
+     *
+     * @param from the color at the start
+     * @param to the color at the end
+     * @param ticks the number of steps of the fade, 0 jumps to the target
+     */
+    void start(const ColorRgbw & from, const ColorRgbw & to, unsigned int ticks);
+
+    void stop(void);
+
+    /**
+     * Advance the fade by one tick.
+     *
+     * @return true if the target has been reached with this step
+     */
+    bool step(void);
+
+    bool isRunning(void) const;
+
+    /**
+     * @return the current color of the fade
+     */
+    ColorRgbw color(void) const;
+
+    /**
+     * @return the color at the end of the fade
+     */
+    const ColorRgbw & target(void) const;
+
+protected:
+    unsigned int current[4];   //!< r, g, b, w as fixed point numbers with 16 fraction bits
+    int          increment[4]; //!< change of r, g, b and w per tick
+    unsigned int ticksLeft;    //!< steps until the target is reached
+    ColorRgbw    targetColor;
+};
+
+inline bool RgbwFade::isRunning(void) const
+{
+    return ticksLeft != 0;
+}
+
+inline const ColorRgbw & RgbwFade::target(void) const
+{
+    return targetColor;
+}
+
+#endif /* COMMON_COLOR_COLOR_H_ */
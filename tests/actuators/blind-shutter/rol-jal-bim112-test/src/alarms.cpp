@@ -0,0 +1,165 @@
+/*
+ *  alarms.cpp - Tests of the alarm priorities and the alarm monitoring
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include "shutters.h"
+#include <virtual_clock.h>
+#include <alarm_supervisor.h>
+
+#define ALARM_OBJ(ch, alarm) (13 + (ch) * 20 + 16 + (alarm))
+
+#define WIND  0
+#define RAIN  1
+#define FROST 2
+
+#define ACTION_UP      1
+#define ACTION_DOWN    2
+#define ACTION_RESTORE 4
+
+#define TRAVEL (TRAVEL_TIME * 1000 * 110 / 100) // including the extension in the end position
+#define MONITOR(ch) ((ch) + 3)                 // monitoring time of the wind alarm in minutes
+
+static void sendAlarm(unsigned int ch, unsigned int alarm, unsigned int value)
+{
+    bcu.comObjects->objectUpdate(ALARM_OBJ(ch, alarm), value);
+    virtualClockRun(1);
+}
+
+TEST_CASE("Alarm priorities", "[ALARM]")
+{
+    setupShutters();
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+    {   // the monitoring time of the wind alarm differs for each channel
+        configureAlarm(ch, WIND,  4, MONITOR(ch), ACTION_UP, ACTION_UP);
+        configureAlarm(ch, RAIN,  1, 0, ACTION_DOWN, ACTION_UP);
+        configureAlarm(ch, FROST, 2, 0, ACTION_DOWN, ACTION_UP);
+    }
+    initApplication();
+    virtualClockRun(ONE_MINUTE);
+    bcu.comObjects->objectUpdate(0, 0); // central up, all channels start in the top position
+    virtualClockRun(2 * TRAVEL);
+    REQUIRE(outputs() == 0);
+
+    sendAlarm(0, RAIN, 1);
+    virtualClockRun(TRAVEL);
+    REQUIRE(channels[0]->currentPosition() == 255);
+    REQUIRE(channels[1]->currentPosition() == 0);
+
+    SECTION("the alarm with the highest priority wins")
+    {
+        sendAlarm(0, WIND, 1);
+        virtualClockRun(TRAVEL);
+        REQUIRE(channels[0]->currentPosition() == 0);
+        // an alarm with a lower priority does not move the channel
+        sendAlarm(0, FROST, 1);
+        virtualClockRun(TRAVEL);
+        REQUIRE(channels[0]->currentPosition() == 0);
+        // the wind alarm is not sent again, after the monitoring time the frost alarm takes over
+        virtualClockRun(MONITOR(0) * ONE_MINUTE - 2 * TRAVEL - 1000);
+        REQUIRE(channels[0]->isRunning() == Channel::STOP);
+        virtualClockRun(2000);
+        REQUIRE(channels[0]->isRunning() == Channel::DOWN);
+        virtualClockRun(TRAVEL);
+        REQUIRE(channels[0]->currentPosition() == 255);
+        // the rain alarm is still active
+        sendAlarm(0, FROST, 0);
+        virtualClockRun(TRAVEL);
+        REQUIRE(channels[0]->currentPosition() == 255);
+        // the last alarm is released
+        sendAlarm(0, RAIN, 0);
+        virtualClockRun(TRAVEL);
+        REQUIRE(channels[0]->currentPosition() == 0);
+        REQUIRE(outputs() == 0);
+    }
+    SECTION("the monitoring is retriggered by the alarm object")
+    {
+        sendAlarm(0, WIND, 1);
+        virtualClockRun(TRAVEL);
+        REQUIRE(channels[0]->currentPosition() == 0);
+        virtualClockRun(MONITOR(0) * ONE_MINUTE - TRAVEL - 10 * 1000);
+        sendAlarm(0, WIND, 1);
+        virtualClockRun(MONITOR(0) * ONE_MINUTE - 1000);
+        REQUIRE(channels[0]->isRunning() == Channel::STOP);
+        // the rain alarm takes over after the monitoring time
+        virtualClockRun(2000);
+        REQUIRE(channels[0]->isRunning() == Channel::DOWN);
+        virtualClockRun(TRAVEL);
+        REQUIRE(channels[0]->currentPosition() == 255);
+    }
+    SECTION("only the affected channels react on an expired monitor")
+    {
+        for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        {
+            sendAlarm(ch, WIND, 1);
+            sendAlarm(ch, FROST, 1);
+        }
+        virtualClockRun(TRAVEL);
+        REQUIRE(outputs() == 0);
+        virtualClockRun(MONITOR(0) * ONE_MINUTE - TRAVEL - 1000);
+        for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        {   // the wind alarms expire one after the other, one minute apart
+            virtualClockRun(2000);
+            for (unsigned int i = 0; i < NO_OF_CHANNELS; i++)
+                REQUIRE(channels[i]->isRunning() == ((i == ch) ? Channel::DOWN : Channel::STOP));
+            virtualClockRun(ONE_MINUTE - 2000);
+        }
+        virtualClockRun(TRAVEL);
+        for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+            REQUIRE(channels[ch]->currentPosition() == 255);
+    }
+}
+
+TEST_CASE("Alarm supervisor", "[ALARM]")
+{
+    AlarmSupervisor supervisor;
+
+    SECTION("monitors expire in the order of their expiry time")
+    {
+        supervisor.start(4, 3000, 1000);
+        supervisor.start(1, 1000, 1000);
+        supervisor.start(9, 2000, 1000);
+        REQUIRE(supervisor.runningMonitors() == 3);
+        REQUIRE(supervisor.timeToDeadline(1500) == 500);
+        REQUIRE(supervisor.nextExpired(1999) == -1);
+        REQUIRE(supervisor.nextExpired(2000) == 1);
+        REQUIRE(supervisor.nextExpired(2000) == -1);
+        REQUIRE(supervisor.nextExpired(5000) == 9);
+        REQUIRE(supervisor.nextExpired(5000) == 4);
+        REQUIRE(supervisor.nextExpired(5000) == -1);
+        REQUIRE(supervisor.timeToDeadline(5000) == 0xFFFFFFFF);
+    }
+    SECTION("a monitor is re-triggered")
+    {
+        supervisor.start(1, 1000, 0);
+        supervisor.start(2, 1500, 0);
+        supervisor.start(1, 1000, 900);
+        REQUIRE(supervisor.runningMonitors() == 2);
+        REQUIRE(supervisor.nextExpired(1500) == 2);
+        REQUIRE(supervisor.nextExpired(1899) == -1);
+        REQUIRE(supervisor.nextExpired(1900) == 1);
+    }
+    SECTION("a stopped monitor does not expire")
+    {
+        supervisor.start(1, 1000, 0);
+        supervisor.start(2, 1000, 0);
+        supervisor.stop(1);
+        supervisor.stop(3);
+        REQUIRE(!supervisor.isRunning(1));
+        REQUIRE(supervisor.isRunning(2));
+        REQUIRE(supervisor.nextExpired(1000) == 2);
+        REQUIRE(supervisor.nextExpired(1000) == -1);
+    }
+    SECTION("millis() wraps around")
+    {
+        supervisor.start(5, 1000, 0xFFFFFFFF - 100);
+        supervisor.start(6, 50, 0xFFFFFFFF - 100);
+        REQUIRE(supervisor.nextExpired(0xFFFFFFFF) == 6);
+        REQUIRE(supervisor.timeToDeadline(0xFFFFFFFF) == 900);
+        REQUIRE(supervisor.nextExpired(898) == -1);
+        REQUIRE(supervisor.nextExpired(899) == 5);
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ *  arbiter.cpp - Tests of the relay arbiter of the rol-jal-bim112
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <relay_arbiter.h>
+
+#define CHANNELS 4
+#define SPACING  50
+#define BUDGET   2
+
+// the outputs which are switched on by a central "down" command
+static unsigned int centralDown(RelayArbiter & arbiter, unsigned int channels)
+{
+    for (unsigned int ch = 0; ch < channels; ch++)
+        arbiter.request(ch * 2 + 1);
+    return arbiter.pendingRequests();
+}
+
+/*
+ * Run the arbiter once per ms like the main loop does and return the time
+ * until all requested relays are on. grantTime receives the time each output
+ * has been switched on.
+ */
+static unsigned int timeToAllMoving(RelayArbiter & arbiter, unsigned int start, unsigned int * grantTime)
+{
+    unsigned int now = start;
+    unsigned int ms;
+    for (ms = 0; arbiter.pendingRequests() && (ms < 10000); ms++, now++)
+    {
+        unsigned int granted = arbiter.process(now);
+        for (unsigned int i = 0; i < MAX_RELAY_OUTPUTS; i++)
+        {
+            if (granted & (1 << i))
+                grantTime[i] = ms;
+        }
+    }
+    return ms - 1;
+}
+
+TEST_CASE("Relay arbiter central command", "[ARBITER]")
+{
+    unsigned int grantTime[MAX_RELAY_OUTPUTS] = { 0 };
+
+    SECTION("budget of two relays")
+    {
+        RelayArbiter arbiter(SPACING, BUDGET);
+        REQUIRE(centralDown(arbiter, CHANNELS) == CHANNELS);
+        REQUIRE(timeToAllMoving(arbiter, 1000, grantTime) == SPACING);
+        // the channels start in the order of the requests, two at a time
+        REQUIRE(grantTime[1] == 0);
+        REQUIRE(grantTime[3] == 0);
+        REQUIRE(grantTime[5] == SPACING);
+        REQUIRE(grantTime[7] == SPACING);
+        for (unsigned int ch = 0; ch < CHANNELS; ch++)
+        {
+            REQUIRE(arbiter.isGranted(ch * 2 + 1));
+            REQUIRE(!arbiter.isGranted(ch * 2));
+        }
+    }
+    SECTION("one relay at a time")
+    {
+        RelayArbiter arbiter(SPACING, 1);
+        centralDown(arbiter, CHANNELS);
+        REQUIRE(timeToAllMoving(arbiter, 1000, grantTime) == (CHANNELS - 1) * SPACING);
+        for (unsigned int ch = 0; ch < CHANNELS; ch++)
+            REQUIRE(grantTime[ch * 2 + 1] == ch * SPACING);
+    }
+    SECTION("budget covers all channels")
+    {
+        RelayArbiter arbiter(SPACING, CHANNELS);
+        centralDown(arbiter, CHANNELS);
+        REQUIRE(timeToAllMoving(arbiter, 1000, grantTime) == 0);
+    }
+    SECTION("millis() wraps around")
+    {
+        RelayArbiter arbiter(SPACING, BUDGET);
+        centralDown(arbiter, CHANNELS);
+        REQUIRE(timeToAllMoving(arbiter, 0xFFFFFFFF - 10, grantTime) == SPACING);
+    }
+}
+
+TEST_CASE("Relay arbiter requests", "[ARBITER]")
+{
+    RelayArbiter arbiter(SPACING, BUDGET);
+
+    SECTION("a request in a running group")
+    {
+        arbiter.request(1);
+        REQUIRE(arbiter.process(100) == 0x02);
+        arbiter.request(3);
+        REQUIRE(arbiter.process(120) == 0x08);
+        // the budget of the group is used up
+        arbiter.request(5);
+        REQUIRE(arbiter.process(149) == 0);
+        REQUIRE(arbiter.isPending(5));
+        REQUIRE(arbiter.process(150) == 0x20);
+    }
+    SECTION("requests are not queued twice")
+    {
+        arbiter.request(1);
+        arbiter.request(1);
+        REQUIRE(arbiter.pendingRequests() == 1);
+        arbiter.process(0);
+        arbiter.request(1);
+        REQUIRE(arbiter.pendingRequests() == 0);
+    }
+    SECTION("release drops a pending request")
+    {
+        arbiter.request(1);
+        arbiter.request(3);
+        arbiter.request(5);
+        arbiter.release(3);
+        REQUIRE(arbiter.pendingRequests() == 2);
+        REQUIRE(arbiter.process(0) == 0x22);
+    }
+    SECTION("both relays of a channel are never on")
+    {
+        arbiter.request(0);
+        REQUIRE(arbiter.process(0) == 0x01);
+        arbiter.request(1);
+        REQUIRE(arbiter.process(SPACING) == 0);
+        arbiter.release(0);
+        REQUIRE(arbiter.process(SPACING + 1) == 0x02);
+        REQUIRE(!arbiter.isGranted(0));
+    }
+}
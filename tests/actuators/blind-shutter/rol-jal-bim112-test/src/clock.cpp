@@ -0,0 +1,46 @@
+/*
+ *  clock.cpp - Tests of the virtual clock runner of the test scripts
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include "shutters.h"
+#include <virtual_clock.h>
+
+TEST_CASE("Virtual clock runner", "[CLOCK]")
+{
+    VirtualClockStats stats;
+
+    startShutters();
+    virtualClockRun(ONE_MINUTE);
+    virtualClockReset();
+
+    bcu.comObjects->objectUpdate(0, 1); // central down
+    virtualClockRun(ONE_MINUTE / 100);
+    REQUIRE(outputs() == 0xAA);
+    virtualClockRun(20 * ONE_MINUTE - ONE_MINUTE / 100);
+    REQUIRE(outputs() == 0);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(channels[ch]->currentPosition() == 255);
+
+    bcu.comObjects->objectUpdate(3, 128); // central position 50%
+    virtualClockRun(20 * ONE_MINUTE);
+    REQUIRE(outputs() == 0);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(channels[ch]->currentPosition() == 128);
+
+    bcu.comObjects->objectUpdate(0, 0); // central up
+    virtualClockRun(20 * ONE_MINUTE);
+    REQUIRE(outputs() == 0);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(channels[ch]->currentPosition() == 0);
+
+    virtualClockReport("Virtual clock runner");
+    virtualClockStats(&stats);
+    REQUIRE(stats.simulated == ONE_HOUR);
+    // the main loop runs only while the shutters move or wait for a timeout
+    REQUIRE(stats.iterations < ONE_HOUR / 10);
+    REQUIRE(stats.jumps > 0);
+}
@@ -0,0 +1,173 @@
+/*
+ *  coalescer.cpp - Tests of the status coalescer of the rol-jal-bim112
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <stdio.h>
+#include <status_coalescer.h>
+#include "shutters.h"
+#include <virtual_clock.h>
+
+#define WINDOW 200
+#define BUDGET 4
+
+// object numbers of the status objects of channel 0..3, see COM_OBJ_... in channel.h
+#define POSITION(ch)  (13 + (ch) * 20 + 7)
+#define VISU(ch)      (13 + (ch) * 20 + 4)
+
+TEST_CASE("Status coalescer", "[COALESCER]")
+{
+    StatusCoalescer coalescer(WINDOW, BUDGET);
+
+    SECTION("only the newest value is sent")
+    {
+        coalescer.changed(POSITION(0), 1000);
+        coalescer.changed(POSITION(0), 1050);
+        coalescer.changed(POSITION(0), 1100);
+        REQUIRE(coalescer.pendingObjects() == 1);
+        REQUIRE(coalescer.nextDue(1199) == -1);
+        REQUIRE(coalescer.timeToDeadline(1199) == 1);
+        REQUIRE(coalescer.nextDue(1200) == POSITION(0));
+        REQUIRE(coalescer.nextDue(1200) == -1);
+        REQUIRE(coalescer.timeToDeadline(1200) == 0xFFFFFFFF);
+        REQUIRE(coalescer.changes() == 3);
+        REQUIRE(coalescer.telegrams() == 1);
+    }
+    SECTION("objects are sent in the order of their first change")
+    {
+        coalescer.changed(VISU(2), 0);
+        coalescer.changed(VISU(0), 10);
+        coalescer.changed(VISU(2), 20);
+        coalescer.changed(VISU(1), 30);
+        REQUIRE(coalescer.nextDue(WINDOW) == VISU(2));
+        REQUIRE(coalescer.nextDue(WINDOW) == VISU(0));
+        REQUIRE(coalescer.nextDue(WINDOW) == VISU(1));
+        REQUIRE(coalescer.nextDue(WINDOW) == -1);
+    }
+    SECTION("the budget limits the telegrams per window")
+    {
+        for (unsigned int ch = 0; ch < 4; ch++)
+        {
+            coalescer.changed(VISU(ch), 0);
+            coalescer.changed(POSITION(ch), 0);
+        }
+        unsigned int sent = 0;
+        while (coalescer.nextDue(WINDOW) >= 0)
+            sent++;
+        REQUIRE(sent == BUDGET);
+        REQUIRE(coalescer.pendingObjects() == 8 - BUDGET);
+        REQUIRE(coalescer.timeToDeadline(WINDOW) == WINDOW);
+        // a change of a pending object does not delay it
+        coalescer.changed(POSITION(3), WINDOW + 100);
+        REQUIRE(coalescer.nextDue(2 * WINDOW - 1) == -1);
+        while (coalescer.nextDue(2 * WINDOW) >= 0)
+            sent++;
+        REQUIRE(sent == 8);
+        REQUIRE(coalescer.pendingObjects() == 0);
+    }
+    SECTION("millis() wraps around")
+    {
+        coalescer.changed(POSITION(1), 0xFFFFFFFF - 50);
+        REQUIRE(coalescer.nextDue(100) == -1);
+        REQUIRE(coalescer.nextDue(WINDOW - 51) == POSITION(1));
+    }
+}
+
+// the status telegrams of a movement are sent one window after the motor start and the stop
+TEST_CASE("Status telegrams of a movement", "[COALESCER]")
+{
+    startShutters();
+    virtualClockRun(ONE_MINUTE);
+    bcu.comObjects->objectUpdate(0, 0); // central up, all channels start in the top position
+    virtualClockRun(2 * TRAVEL_TIME * 1000);
+    REQUIRE(outputs() == 0);
+    virtualClockRun(STATUS_WINDOW);
+    REQUIRE(statusCoalescer.pendingObjects() == 0);
+
+    unsigned int sent = statusCoalescer.telegrams();
+    bcu.comObjects->objectUpdate(0, 1); // central down
+    virtualClockRun(1);
+    REQUIRE(outputs() != 0);
+    virtualClockRun(STATUS_WINDOW - 1);
+    REQUIRE(statusCoalescer.telegrams() == sent);
+    virtualClockRun(1);
+    REQUIRE(statusCoalescer.telegrams() == sent + STATUS_BUDGET);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(bcu.comObjects->objectRead(VISU(ch)) == 1);
+
+    while (outputs() != 0)
+        virtualClockRun(1);
+    // the end positions of the four channels wait for the window
+    REQUIRE(statusCoalescer.pendingObjects() >= NO_OF_CHANNELS);
+    virtualClockRun(2 * STATUS_WINDOW);
+    REQUIRE(statusCoalescer.pendingObjects() == 0);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(bcu.comObjects->objectRead(POSITION(ch)) == 255);
+}
+
+typedef struct
+{
+    unsigned int changes;   //!< status changes, each was a telegram before the coalescer
+    unsigned int telegrams; //!< status telegrams sent
+    unsigned int peakChanges;   //!< most changes within one STATUS_WINDOW
+    unsigned int peakTelegrams; //!< most telegrams within one STATUS_WINDOW
+} BusLoad;
+
+// run in steps of one window and record the most changes and telegrams of a window
+static void runCounted(unsigned int ms, BusLoad & load)
+{
+    for (unsigned int i = 0; i < ms; i += STATUS_WINDOW)
+    {
+        unsigned int changes   = statusCoalescer.changes();
+        unsigned int telegrams = statusCoalescer.telegrams();
+        virtualClockRun(STATUS_WINDOW);
+        changes   = statusCoalescer.changes()   - changes;
+        telegrams = statusCoalescer.telegrams() - telegrams;
+        load.changes   += changes;
+        load.telegrams += telegrams;
+        if (changes > load.peakChanges)
+            load.peakChanges = changes;
+        if (telegrams > load.peakTelegrams)
+            load.peakTelegrams = telegrams;
+    }
+}
+
+// status telegrams of a sequence of central commands, without (changes) and with the coalescer (telegrams)
+TEST_CASE("Bus load of the status telegrams", "[COALESCER]")
+{
+    BusLoad load = { 0, 0, 0, 0 };
+
+    startShutters();
+    virtualClockRun(ONE_MINUTE);
+    bcu.comObjects->objectUpdate(0, 0); // central up, all channels start in the top position
+    virtualClockRun(2 * TRAVEL_TIME * 1000);
+    virtualClockRun(STATUS_WINDOW);
+    REQUIRE(statusCoalescer.pendingObjects() == 0);
+
+    bcu.comObjects->objectUpdate(0, 1); // central down
+    runCounted(5000, load);
+    bcu.comObjects->objectUpdate(0, 0); // and up again after 5s
+    runCounted(5000, load);
+    bcu.comObjects->objectUpdate(3, 64); // central position 25%
+    runCounted(400, load);
+    bcu.comObjects->objectUpdate(0, 1); // quick down/up
+    virtualClockRun(100);
+    bcu.comObjects->objectUpdate(0, 0);
+    runCounted(400, load);
+    bcu.comObjects->objectUpdate(3, 128); // corrected to 50% right away
+    runCounted(2 * TRAVEL_TIME * 1000, load);
+    bcu.comObjects->objectUpdate(0, 1); // central down
+    runCounted(2 * TRAVEL_TIME * 1000, load);
+    bcu.comObjects->objectUpdate(0, 0); // central up
+    runCounted(2 * TRAVEL_TIME * 1000, load);
+    REQUIRE(outputs() == 0);
+    REQUIRE(statusCoalescer.pendingObjects() == 0);
+
+    printf("status objects: %u changes in %u telegrams, at most %u changes and %u telegrams per %u ms\n",
+           load.changes, load.telegrams, load.peakChanges, load.peakTelegrams, STATUS_WINDOW);
+    REQUIRE(load.telegrams <= load.changes);
+    REQUIRE(load.peakTelegrams <= STATUS_BUDGET);
+}
@@ -0,0 +1,86 @@
+/*
+ *  schedule.cpp - Benchmark of the deadline based processing of the channels
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <stdio.h>
+#include "shutters.h"
+
+typedef struct
+{
+    unsigned int iterations; //!< passes of the main loop
+    unsigned int wakeups;    //!< passes which processed the channels
+    unsigned int burst;      //!< most status telegrams sent in one pass
+} LoopStats;
+
+// the same as loop() in app_main.cpp, but counts the passes which had something to do
+static void runFor(unsigned int ms, LoopStats & stats)
+{
+    for (unsigned int i = 0; i < ms; i++)
+    {
+        int objno;
+        unsigned int telegrams = statusCoalescer.telegrams();
+        systemTime++;
+        bcu.loop();
+        while ((objno = bcu.comObjects->nextUpdatedObject()) >= 0)
+        {
+            objectUpdated(objno);
+        }
+        stats.iterations++;
+        if (checkPeriodicFuntions())
+            stats.wakeups++;
+        if (statusCoalescer.telegrams() - telegrams > stats.burst)
+            stats.burst = statusCoalescer.telegrams() - telegrams;
+    }
+}
+
+TEST_CASE("Deadline scheduling of the channels", "[SCHEDULE]")
+{
+    LoopStats stats = { 0, 0, 0 };
+
+    systemTime = 0;
+    startShutters();
+
+    runFor(ONE_MINUTE, stats);
+    // after the initial protection time all channels are idle
+    REQUIRE(stats.wakeups < 10);
+    stats.iterations = stats.wakeups = stats.burst = 0;
+    unsigned int changes   = statusCoalescer.changes();
+    unsigned int telegrams = statusCoalescer.telegrams();
+
+    bcu.comObjects->objectUpdate(0, 1); // central down
+    runFor(ONE_MINUTE / 100, stats);
+    REQUIRE(outputs() == 0xAA);
+    runFor(20 * ONE_MINUTE - ONE_MINUTE / 100, stats);
+    REQUIRE(outputs() == 0);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(channels[ch]->currentPosition() == 255);
+
+    bcu.comObjects->objectUpdate(3, 128); // central position 50%
+    runFor(20 * ONE_MINUTE, stats);
+    REQUIRE(outputs() == 0);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(channels[ch]->currentPosition() == 128);
+
+    bcu.comObjects->objectUpdate(0, 0); // central up
+    runFor(20 * ONE_MINUTE, stats);
+    REQUIRE(outputs() == 0);
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+        REQUIRE(channels[ch]->currentPosition() == 0);
+
+    printf("main loop: %u iterations, %u wakeups per simulated hour (%u.%u%%)\n",
+           stats.iterations, stats.wakeups,
+           stats.wakeups * 100 / stats.iterations, (stats.wakeups * 1000 / stats.iterations) % 10);
+    changes   = statusCoalescer.changes()   - changes;
+    telegrams = statusCoalescer.telegrams() - telegrams;
+    printf("status objects: %u changes, %u telegrams per simulated hour, at most %u at once\n",
+           changes, telegrams, stats.burst);
+    REQUIRE(stats.iterations == ONE_HOUR);
+    REQUIRE(telegrams <= changes);
+    REQUIRE(stats.burst <= STATUS_BUDGET);
+    // the channels are only processed while they move or wait for a timeout
+    REQUIRE(stats.wakeups < stats.iterations / 10);
+}
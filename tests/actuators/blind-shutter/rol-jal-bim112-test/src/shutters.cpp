@@ -0,0 +1,80 @@
+/*
+ *  shutters.cpp - Common functions for the tests with four shutters
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "shutters.h"
+#include <sblib/digital_pin.h>
+#include <config.h>
+
+BcuBase* setup();
+
+static void setUInt16(unsigned int address, unsigned int value)
+{
+    (*bcu.userEeprom)[address]     = value >> 8;
+    (*bcu.userEeprom)[address + 1] = value;
+}
+
+// four shutters which react on the central objects, no automatic, no alarms
+static void configureShutters(void)
+{
+    unsigned int base = currentVersion->baseAddress;
+    unsigned int global = base + NO_OF_CHANNELS
+                        * (EE_CHANNEL_CFG_SIZE + EE_ALARM_HEADER_SIZE + EE_ALARM_CFG_SIZE * NO_OF_ALARMS);
+
+    for (unsigned int ch = 0; ch < NO_OF_CHANNELS; ch++)
+    {
+        unsigned int address = base + ch * EE_CHANNEL_CFG_SIZE;
+        (*bcu.userEeprom)[address] = 1; // shutter
+        setUInt16(address +  2, 500);   // pause on change of direction
+        setUInt16(address +  4, TRAVEL_TIME);
+        (*bcu.userEeprom)[address + 55] = 100; // motor on delay
+        (*bcu.userEeprom)[address + 58] = 5;   // 5% extension in the end positions
+        setUInt16(address + 62, TRAVEL_TIME);
+
+        address = base + NO_OF_CHANNELS * EE_CHANNEL_CFG_SIZE
+                + (EE_ALARM_HEADER_SIZE + EE_ALARM_CFG_SIZE * NO_OF_ALARMS) * ch + EE_ALARM_HEADER_SIZE;
+        for (unsigned int i = 0; i < NO_OF_ALARMS; i++, address += EE_ALARM_CFG_SIZE)
+            (*bcu.userEeprom)[address + 4] = 255; // alarm disabled
+
+        (*bcu.userEeprom)[global + 0x10 + ch] = 0xFF; // no automatic
+        (*bcu.userEeprom)[global + 0x18 + ch] = 1;    // central objects enabled
+    }
+}
+
+void setupShutters(void)
+{
+    setup();
+    configureShutters();
+}
+
+void startShutters(void)
+{
+    setupShutters();
+    initApplication();
+}
+
+void configureAlarm(unsigned int ch, unsigned int alarm, unsigned int priority,
+                    unsigned int monitorTime, unsigned int engageAction, unsigned int releaseAction)
+{
+    unsigned int address = currentVersion->baseAddress + NO_OF_CHANNELS * EE_CHANNEL_CFG_SIZE
+                         + (EE_ALARM_HEADER_SIZE + EE_ALARM_CFG_SIZE * NO_OF_ALARMS) * ch;
+
+    (*bcu.userEeprom)[address + 8] = releaseAction;
+    address += EE_ALARM_HEADER_SIZE + EE_ALARM_CFG_SIZE * alarm;
+    setUInt16(address + 0, monitorTime);
+    setUInt16(address + 2, priority);
+    (*bcu.userEeprom)[address + 4] = 0; // alarm enabled
+    (*bcu.userEeprom)[address + 6] = engageAction;
+}
+
+unsigned int outputs(void)
+{
+    unsigned int result = 0;
+    for (unsigned int i = 0; i < NO_OF_OUTPUTS; i++)
+        result |= digitalRead(outputPins[i]) << i;
+    return result;
+}
@@ -0,0 +1,52 @@
+/*
+ *  shutters.h - Common functions for the tests with four shutters
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef ROL_JAL_BIM112_TEST_SHUTTERS_H_
+#define ROL_JAL_BIM112_TEST_SHUTTERS_H_
+
+#include <app-rol-jal.h>
+
+#define TRAVEL_TIME 60    // s from fully open to fully closed
+#define ONE_MINUTE  (60 * 1000)
+#define ONE_HOUR    (60 * ONE_MINUTE)
+
+extern volatile unsigned int systemTime;
+
+/**
+ * Start the application with four shutters which react on the central
+ * objects, no automatic and no alarms.
+ */
+void startShutters(void);
+
+/**
+ * Write the configuration of startShutters() to the EEPROM, but do not start
+ * the application. This allows a test to change the configuration before it
+ * calls initApplication().
+ */
+void setupShutters(void);
+
+/**
+ * Enable an alarm of a channel.
+ *
+ * @param ch the channel
+ * @param alarm 0 = wind, 1 = rain, 2 = frost, 3 = lock
+ * @param priority bitmask, the alarm with the higher value wins
+ * @param monitorTime the alarm is released if it is not sent again within
+ *        this time in minutes, 0 = no monitoring
+ * @param engageAction action when the alarm becomes the highest active alarm
+ * @param releaseAction the action after the last alarm has been released
+ */
+void configureAlarm(unsigned int ch, unsigned int alarm, unsigned int priority,
+                    unsigned int monitorTime, unsigned int engageAction, unsigned int releaseAction);
+
+/**
+ * @return bitmask of the relay outputs which are on
+ */
+unsigned int outputs(void);
+
+#endif /* ROL_JAL_BIM112_TEST_SHUTTERS_H_ */
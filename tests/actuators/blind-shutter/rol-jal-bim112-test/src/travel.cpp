@@ -0,0 +1,112 @@
+/*
+ *  travel.cpp - Tests of the fixed point position tracking of the rol-jal-bim112
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include "shutters.h"
+#include <virtual_clock.h>
+#include <config.h>
+
+// the longest travel time which can be configured: 65535 s
+#define MAX_TRAVEL_TIME (65535U * 1000)
+
+// the division which was done in every pass of the main loop before
+static unsigned int refTravel(unsigned int diff, unsigned int maxTime)
+{
+    if (diff >= maxTime)
+        return POS_FULL_TRAVEL;
+    return ((uint64_t) diff * POS_FULL_TRAVEL) / maxTime;
+}
+
+// the first ms in which the position reaches 255, the old code used (diff * 256) / maxTime
+static unsigned int refEndOfTravel(unsigned int maxTime)
+{
+    return ((uint64_t) 255 * maxTime + 255) / 256;
+}
+
+static unsigned int endOfTravel(uint64_t factor, unsigned int maxTime)
+{
+    unsigned int lo = 0, hi = maxTime;
+    while (lo < hi)
+    {
+        unsigned int mid = lo + (hi - lo) / 2;
+        if (Channel::travel(mid, factor, maxTime) >= (unsigned int) POS_FIXED(255))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+static void checkTravelTime(unsigned int maxTime)
+{
+    uint64_t factor = Channel::travelFactor(maxTime);
+    unsigned int diffs[] = { 0, 1, 2, maxTime / 3, maxTime / 2, maxTime - 2, maxTime - 1, maxTime, maxTime + 1 };
+
+    for (unsigned int i = 0; i < sizeof(diffs) / sizeof(diffs[0]); i++)
+    {
+        if (Channel::travel(diffs[i], factor, maxTime) != refTravel(diffs[i], maxTime))
+            FAIL("travel time " << maxTime << " ms, " << diffs[i] << " ms travelled");
+    }
+    if (endOfTravel(factor, maxTime) != refEndOfTravel(maxTime))
+        FAIL("travel time " << maxTime << " ms, end of travel after " << endOfTravel(factor, maxTime) << " ms");
+}
+
+TEST_CASE("Position tracking", "[TRAVEL]")
+{
+    SECTION("every ms of a short travel time")
+    {
+        unsigned int maxTime = 1200;
+        uint64_t factor = Channel::travelFactor(maxTime);
+        for (unsigned int diff = 0; diff <= maxTime; diff++)
+            REQUIRE(Channel::travel(diff, factor, maxTime) == refTravel(diff, maxTime));
+    }
+    SECTION("all travel times up to 100 s")
+    {
+        for (unsigned int maxTime = 1; maxTime <= 100000; maxTime++)
+            checkTravelTime(maxTime);
+        SUCCEED();
+    }
+    SECTION("travel times up to the maximum")
+    {
+        for (unsigned int maxTime = 100000; maxTime < MAX_TRAVEL_TIME; maxTime += 997)
+            checkTravelTime(maxTime);
+        checkTravelTime(150000);
+        checkTravelTime(200000);
+        checkTravelTime(600000);
+        checkTravelTime(MAX_TRAVEL_TIME);
+        SUCCEED();
+    }
+    SECTION("a travel time of 0 is the full travel at once")
+    {
+        REQUIRE(Channel::travel(0, Channel::travelFactor(0), 0) == POS_FULL_TRAVEL);
+    }
+}
+
+// the relay is switched off at the same ms as with the division in every pass of the main loop
+TEST_CASE("End of travel", "[TRAVEL]")
+{
+    unsigned int travelTime = 600; // s
+    setupShutters();
+    unsigned int address = currentVersion->baseAddress; // channel 0
+    (*bcu.userEeprom)[address +  4] = travelTime >> 8;
+    (*bcu.userEeprom)[address +  5] = travelTime;
+    (*bcu.userEeprom)[address + 62] = travelTime >> 8;
+    (*bcu.userEeprom)[address + 63] = travelTime;
+    initApplication();
+    virtualClockRun(ONE_MINUTE);
+    bcu.comObjects->objectUpdate(0, 0); // central up, all channels start in the top position
+    virtualClockRun(2 * travelTime * 1000);
+    REQUIRE(outputs() == 0);
+
+    bcu.comObjects->objectUpdate(0, 1);
+    unsigned int start = systemTime;
+    virtualClockRun(1);
+    while (outputs() & 0x02)
+        virtualClockRun(1);
+    // the telegram, the motor on delay of 100 ms, the travel to position 255 and 5% extension
+    REQUIRE(systemTime - start == 1 + 100 + refEndOfTravel(travelTime * 1000) + travelTime * 1000 * 5 / 100);
+}
@@ -74,7 +74,7 @@ extern "C" void queryChannel(unsigned    int no, ChannelInfo * info)
         COPY(info, ch, startTime);
         COPY(info, ch, features);
         COPY(info, ch, position);
-        COPY(info, ch, startPosition);
+        info->startPosition = POS_ROUND(ch->startPosition);
         COPY(info, ch, targetPosition);
         COPY(info, ch, savedPosition);
         info->timeout = ch->timeout.timeout;
@@ -82,9 +82,15 @@ extern "C" void queryChannel(unsigned    int no, ChannelInfo * info)
         {
             Blind * obj = (Blind *) ch;
             COPY(info, obj, slatPosition);
-            COPY(info, obj, slatStartPosition);
+            info->slatStartPosition = POS_ROUND(obj->slatStartPosition);
             COPY(info, obj, slatTargetPosition);
             COPY(info, obj, slatSavedPosition);
         }
     }
 }
+
+extern "C" void queryStatusTelegrams(unsigned int * changes, unsigned int * telegrams)
+{   // bus load of the status objects: reported changes and telegrams actually sent
+    * changes   = statusCoalescer.changes();
+    * telegrams = statusCoalescer.telegrams();
+}
@@ -0,0 +1,76 @@
+/*
+ *  virtual_clock.cc - Run the application in virtual time for the test scripts
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "virtual_clock.h"
+#include "app-rol-jal.h"
+#include "hand_actuation.h"
+
+extern volatile unsigned int systemTime;
+extern HandActuation* handAct;
+void loop();
+
+static VirtualClockStats stats;
+
+static unsigned int hostMicros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+extern "C" void virtualClockReset(void)
+{
+    stats.simulated  = 0;
+    stats.iterations = 0;
+    stats.jumps      = 0;
+    stats.hostMicros = 0;
+}
+
+extern "C" unsigned int virtualClockRun(unsigned int ms)
+{
+    unsigned int start      = hostMicros();
+    unsigned int iterations = 0;
+    unsigned int end        = systemTime + ms;
+
+    while ((int) (end - systemTime) > 0)
+    {
+        unsigned int skip = timeToWakeup();
+        // the first pass handles the telegrams the script has sent before this call,
+        // the hand actuation buttons are polled in every pass, no jumps with them
+        if (iterations && (skip > 1) && (handAct == nullptr) && bcu.bus->idle())
+        {   // nothing to do before the deadline, let the last ms run through the loop
+            if (skip > end - systemTime)
+                skip = end - systemTime;
+            systemTime += skip - 1;
+            stats.jumps++;
+        }
+        systemTime++;
+        bcu.loop();
+        loop();
+        iterations++;
+    }
+    stats.simulated  += ms;
+    stats.iterations += iterations;
+    stats.hostMicros += hostMicros() - start;
+    return iterations;
+}
+
+extern "C" void virtualClockStats(VirtualClockStats * result)
+{
+    * result = stats;
+}
+
+extern "C" void virtualClockReport(const char * testCase)
+{
+    printf("%s: %u.%03u s simulated in %u.%03u ms, %u loop passes, %u jumps\n", testCase,
+           stats.simulated / 1000, stats.simulated % 1000,
+           stats.hostMicros / 1000, stats.hostMicros % 1000,
+           stats.iterations, stats.jumps);
+}
@@ -0,0 +1,51 @@
+/*
+ *  virtual_clock.h - Run the application in virtual time for the test scripts
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef ROL_JAL_BIM112_TEST_VIRTUAL_CLOCK_H_
+#define ROL_JAL_BIM112_TEST_VIRTUAL_CLOCK_H_
+
+typedef struct
+{
+    unsigned int simulated;   //!< ms of simulated time
+    unsigned int iterations;  //!< passes of the main loop
+    unsigned int jumps;       //!< idle periods which have been skipped
+    unsigned int hostMicros;  //!< host time spent in the main loop
+} VirtualClockStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start a new test case, clears the statistics.
+ */
+void virtualClockReset(void);
+
+/**
+ * Advance the application by ms. While no channel has a deadline and
+ * the bus is idle the clock jumps to the next deadline (or to the end of
+ * the period) instead of running the main loop for every ms. Telegrams
+ * are injected by the test script between two calls, so none can be due
+ * inside the period.
+ *
+ * @return the number of main loop passes
+ */
+unsigned int virtualClockRun(unsigned int ms);
+
+void virtualClockStats(VirtualClockStats * stats);
+
+/**
+ * Print the timing of the current test case to stdout.
+ */
+void virtualClockReport(const char * testCase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROL_JAL_BIM112_TEST_VIRTUAL_CLOCK_H_ */
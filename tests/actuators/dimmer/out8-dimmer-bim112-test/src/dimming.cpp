@@ -0,0 +1,207 @@
+/*
+ *  dimming.cpp - Tests of the dimming engine with a simulated frame timer
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <stdio.h>
+#include <time.h>
+#include <channel.h>
+
+// run the engine like the frame interrupt does until the channel has reached its target
+static unsigned int framesUntilDone(DimmingEngine & engine, unsigned int channel)
+{
+    unsigned int frames = 0;
+    while (engine.isRamping(channel) && (frames < 100000))
+    {
+        engine.frame();
+        frames++;
+    }
+    return frames;
+}
+
+static void runFrames(DimmingEngine & engine, unsigned int frames)
+{
+    for (unsigned int i = 0; i < frames; i++)
+        engine.frame();
+}
+
+TEST_CASE("Dimming ramps", "[DIMMING]")
+{
+    DimmingEngine engine;
+
+    SECTION("soft on ends exactly at the target in time")
+    {
+        engine.rampTo(0, 255, 2000);
+        runFrames(engine, 2000 / DIM_FRAME_MS / 2);
+        REQUIRE(engine.brightness(0) >= 127);
+        REQUIRE(engine.brightness(0) <= 129);
+        REQUIRE(engine.finishedRamps() == 0);
+        REQUIRE(framesUntilDone(engine, 0) == 2000 / DIM_FRAME_MS / 2);
+        REQUIRE(engine.brightness(0) == 255);
+        REQUIRE(engine.finishedRamps() == 0x01);
+        REQUIRE(engine.finishedRamps() == 0);
+    }
+    SECTION("soft off is monotonic")
+    {
+        engine.rampTo(3, 200, 0);
+        REQUIRE(framesUntilDone(engine, 3) == 1);
+        REQUIRE(engine.brightness(3) == 200);
+        engine.rampTo(3, 0, 750);
+        unsigned int last = engine.brightness(3);
+        unsigned int frames = 0;
+        while (engine.isRamping(3))
+        {
+            engine.frame();
+            frames++;
+            REQUIRE(engine.brightness(3) <= last);
+            last = engine.brightness(3);
+        }
+        REQUIRE(frames == 750 / DIM_FRAME_MS);
+        REQUIRE(engine.brightness(3) == 0);
+    }
+    SECTION("the dimming speed is independent of the distance")
+    {
+        engine.dimTo(1, 255, 5000);
+        REQUIRE(framesUntilDone(engine, 1) == 5000 / DIM_FRAME_MS);
+        engine.dimTo(1, 128, 5000);
+        unsigned int frames = framesUntilDone(engine, 1);
+        REQUIRE(frames >= 127 * 5000 / DIM_FRAME_MS / 255);
+        REQUIRE(frames <= 127 * 5000 / DIM_FRAME_MS / 255 + 1);
+        REQUIRE(engine.brightness(1) == 128);
+    }
+    SECTION("a stopped ramp stays at a whole brightness value")
+    {
+        engine.dimTo(2, 255, 5000);
+        runFrames(engine, 123);
+        engine.stop(2);
+        unsigned int stopped = engine.brightness(2);
+        REQUIRE(!engine.isRamping(2));
+        REQUIRE(engine.finishedRamps() == 0x04);
+        REQUIRE(engine.frame() == 0);
+        REQUIRE(engine.brightness(2) == stopped);
+        REQUIRE(engine.target(2) == stopped);
+    }
+    SECTION("only a change of the brightness is reported to the outputs")
+    {
+        unsigned int changes = 0;
+        engine.rampTo(5, 2, 1000);
+        while (engine.isRamping(5))
+        {
+            if (engine.frame() & (1 << 5))
+                changes++;
+        }
+        REQUIRE(changes == 2);
+    }
+}
+
+TEST_CASE("All eight channels ramping at once", "[DIMMING]")
+{
+    DimmingEngine engine;
+    struct timespec start, end;
+    unsigned int frames = 0;
+
+    for (unsigned int ch = 0; ch < MAX_DIM_CHANNELS; ch++)
+        engine.rampTo(ch, 255 - ch * 20, 3000);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (engine.isRamping(0) && (frames < 1000))
+    {
+        engine.frame();
+        frames++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    REQUIRE(frames == 3000 / DIM_FRAME_MS);
+    for (unsigned int ch = 0; ch < MAX_DIM_CHANNELS; ch++)
+    {
+        REQUIRE(!engine.isRamping(ch));
+        REQUIRE(engine.brightness(ch) == 255 - ch * 20);
+    }
+    REQUIRE(engine.finishedRamps() == 0xFF);
+
+    unsigned int nanos = (end.tv_sec - start.tv_sec) * 1000000000 + end.tv_nsec - start.tv_nsec;
+    printf("dimming engine: %u frames with 8 ramps, %u ns per frame on the host\n", frames, nanos / frames);
+    // far below the frame period, even on the slower target
+    REQUIRE(nanos / frames < DIM_FRAME_MS * 1000000 / 100);
+}
+
+#define CHANNEL_BASE (0xADF0 + EE_GLOBAL_CFG_SIZE)
+#define OBJ(ch, obj) (FIRST_CHANNEL_OBJ_NO + (ch) * OBJS_PER_CHANNEL + (obj))
+
+static void setUInt16(unsigned int address, unsigned int value)
+{
+    (*bcu.userEeprom)[address]     = value >> 8;
+    (*bcu.userEeprom)[address + 1] = value;
+}
+
+// the main loop and the frame interrupt for ms
+static void runChannels(Channel * chn, unsigned int ms)
+{
+    for (unsigned int i = 0; i < ms / DIM_FRAME_MS; i++)
+    {
+        dimmingEngine.frame();
+        if (dimmingEngine.finishedRamps() & 0x01)
+            chn->rampFinished();
+    }
+}
+
+TEST_CASE("Dimmer channel", "[CHANNEL]")
+{
+    unsigned int address = CHANNEL_BASE;
+    setUInt16(address + 0x43, 10); // soft on 1 s
+    setUInt16(address + 0x45, 5);  // soft off 0.5 s
+    setUInt16(address + 0x47, 50); // relative dimming 5 s
+    setUInt16(address + 0x49, 20); // brightness value 2 s
+    (*bcu.userEeprom)[address + 0x31] = 10;
+    (*bcu.userEeprom)[address + 0x32] = 255;
+    (*bcu.userEeprom)[address + 0x66] = 0;
+    Channel chn(0, address);
+    unsigned int writes;
+
+    // switch on, the status is only sent at the end of the soft on ramp
+    bcu.comObjects->objectUpdate(OBJ(0, COM_OBJ_SWITCH), 1);
+    chn.objectUpdateCh(OBJ(0, COM_OBJ_SWITCH));
+    writes = bcu.comObjects->writes;
+    runChannels(&chn, 500);
+    REQUIRE(bcu.comObjects->writes == writes);
+    runChannels(&chn, 500);
+    REQUIRE(chn.brightness() == 255);
+    REQUIRE(bcu.comObjects->writes == writes + 2);
+    REQUIRE(bcu.comObjects->objectRead(OBJ(0, COM_OBJ_SWITCH_STATUS)) == 1);
+    REQUIRE(bcu.comObjects->objectRead(OBJ(0, COM_OBJ_BRIGHTNESS_STATUS)) == 255);
+
+    // dim down for one second, then stop
+    bcu.comObjects->objectUpdate(OBJ(0, COM_OBJ_REL_DIMMING), 0x01);
+    chn.objectUpdateCh(OBJ(0, COM_OBJ_REL_DIMMING));
+    runChannels(&chn, 1000);
+    bcu.comObjects->objectUpdate(OBJ(0, COM_OBJ_REL_DIMMING), 0x00);
+    chn.objectUpdateCh(OBJ(0, COM_OBJ_REL_DIMMING));
+    runChannels(&chn, DIM_FRAME_MS);
+    REQUIRE(chn.brightness() == 204);
+    REQUIRE(bcu.comObjects->writes == writes + 3);
+    REQUIRE(bcu.comObjects->objectRead(OBJ(0, COM_OBJ_BRIGHTNESS_STATUS)) == 204);
+
+    // dimming down stops at the lower limit
+    bcu.comObjects->objectUpdate(OBJ(0, COM_OBJ_REL_DIMMING), 0x01);
+    chn.objectUpdateCh(OBJ(0, COM_OBJ_REL_DIMMING));
+    runChannels(&chn, 5000);
+    REQUIRE(chn.brightness() == 10);
+
+    bcu.comObjects->objectUpdate(OBJ(0, COM_OBJ_BRIGHTNESS), 100);
+    chn.objectUpdateCh(OBJ(0, COM_OBJ_BRIGHTNESS));
+    runChannels(&chn, 2000);
+    REQUIRE(chn.brightness() == 100);
+    REQUIRE(bcu.comObjects->objectRead(OBJ(0, COM_OBJ_BRIGHTNESS_STATUS)) == 100);
+
+    // switch off and on again restores the last brightness
+    bcu.comObjects->objectUpdate(OBJ(0, COM_OBJ_SWITCH), 0);
+    chn.objectUpdateCh(OBJ(0, COM_OBJ_SWITCH));
+    runChannels(&chn, 500);
+    REQUIRE(chn.brightness() == 0);
+    REQUIRE(bcu.comObjects->objectRead(OBJ(0, COM_OBJ_SWITCH_STATUS)) == 0);
+    bcu.comObjects->objectUpdate(OBJ(0, COM_OBJ_SWITCH), 1);
+    chn.objectUpdateCh(OBJ(0, COM_OBJ_SWITCH));
+    runChannels(&chn, 1000);
+    REQUIRE(chn.brightness() == 100);
+}
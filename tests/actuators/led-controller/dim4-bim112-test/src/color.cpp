@@ -0,0 +1,213 @@
+/*
+ *  color.cpp - Compare the integer color conversions with the floating
+ *              point formulas and test the HSV fades
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <color.h>
+
+static unsigned char roundToByte(double value)
+{
+    return (unsigned char) floor(value + 0.5);
+}
+
+// the textbook floating point conversion, the hue 0..255 is the full circle
+static void hsvToRgbFloat(const ColorHsv & hsv, ColorRgbw & rgb)
+{
+    double h  = hsv.h * 6.0 / 255.0;
+    double s  = hsv.s / 255.0;
+    double v  = hsv.v;
+    int    hi = (int) floor(h);
+    double f  = h - hi;
+    double p  = v * (1.0 - s);
+    double q  = v * (1.0 - s * f);
+    double t  = v * (1.0 - s * (1.0 - f));
+    double r, g, b;
+
+    switch (hi % 6)
+    {
+    case 0:  r = v, g = t, b = p; break;
+    case 1:  r = q, g = v, b = p; break;
+    case 2:  r = p, g = v, b = t; break;
+    case 3:  r = p, g = q, b = v; break;
+    case 4:  r = t, g = p, b = v; break;
+    default: r = v, g = p, b = q; break;
+    }
+    rgb.r = roundToByte(r);
+    rgb.g = roundToByte(g);
+    rgb.b = roundToByte(b);
+    rgb.w = 0;
+}
+
+static void rgbToHsvFloat(const ColorRgbw & rgb, ColorHsv & hsv)
+{
+    double r = rgb.r, g = rgb.g, b = rgb.b;
+    double max = fmax(r, fmax(g, b));
+    double min = fmin(r, fmin(g, b));
+    double h = 0, s = 0;
+
+    // the hue is scaled to 0..255 with one division, so the ties at x.5 are exact
+    if (max > min)
+    {
+        s = (max - min) / max;
+        if (max == r)
+            h = (g - b) * 255.0 / (6 * (max - min));
+        else if (max == g)
+            h = (b - r) * 255.0 / (6 * (max - min)) + 85;
+        else
+            h = (r - g) * 255.0 / (6 * (max - min)) + 170;
+        if (h < 0)
+            h += 255;
+    }
+    hsv.h = roundToByte(h);
+    hsv.s = roundToByte(s * 255.0);
+    hsv.v = roundToByte(max);
+}
+
+static double nanosSince(struct timespec & start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1e9 + end.tv_nsec - start.tv_nsec;
+}
+
+TEST_CASE("HSV to RGB for all colors", "[COLOR]")
+{
+    ColorHsv hsv;
+    ColorRgbw rgb, ref;
+    unsigned int errors = 0;
+
+    for (unsigned int color = 0; color < 0x1000000; color++)
+    {
+        hsv.h = color >> 16;
+        hsv.s = color >> 8;
+        hsv.v = color;
+        hsvToRgb(hsv, rgb);
+        hsvToRgbFloat(hsv, ref);
+        if ((rgb.r != ref.r) || (rgb.g != ref.g) || (rgb.b != ref.b) || rgb.w)
+            errors++;
+    }
+    REQUIRE(errors == 0);
+}
+
+TEST_CASE("RGB to HSV for all colors", "[COLOR]")
+{
+    ColorHsv hsv, ref;
+    ColorRgbw rgb;
+    unsigned int errors = 0;
+
+    rgb.w = 0;
+    for (unsigned int color = 0; color < 0x1000000; color++)
+    {
+        rgb.r = color >> 16;
+        rgb.g = color >> 8;
+        rgb.b = color;
+        rgbToHsv(rgb, hsv);
+        rgbToHsvFloat(rgb, ref);
+        if ((hsv.h != ref.h) || (hsv.s != ref.s) || (hsv.v != ref.v))
+            errors++;
+    }
+    REQUIRE(errors == 0);
+}
+
+TEST_CASE("Color conversion speed", "[COLOR]")
+{
+    struct timespec start;
+    volatile unsigned int sink = 0;
+    ColorHsv hsv;
+    ColorRgbw rgb;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int color = 0; color < 0x1000000; color += 7)
+    {
+        hsv.h = color >> 16; hsv.s = color >> 8; hsv.v = color;
+        hsvToRgb(hsv, rgb);
+        sink = sink + rgb.r;
+    }
+    double integer = nanosSince(start);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int color = 0; color < 0x1000000; color += 7)
+    {
+        hsv.h = color >> 16; hsv.s = color >> 8; hsv.v = color;
+        hsvToRgbFloat(hsv, rgb);
+        sink = sink + rgb.r;
+    }
+    double floating = nanosSince(start);
+    // the host has a FPU, the Cortex-M0 has to emulate every float operation
+    printf("HSV to RGB: integer %.1f ns, floating point %.1f ns per color on the host\n",
+            integer / (0x1000000 / 7), floating / (0x1000000 / 7));
+    REQUIRE(integer < floating);
+}
+
+TEST_CASE("White extraction", "[COLOR]")
+{
+    ColorRgbw color = { 200, 120, 150, 0 };
+    extractWhite(color);
+    REQUIRE(color.r == 80);
+    REQUIRE(color.g == 0);
+    REQUIRE(color.b == 30);
+    REQUIRE(color.w == 120);
+
+    ColorRgbw gray = { 77, 77, 77, 0 };
+    extractWhite(gray);
+    REQUIRE(gray.r == 0);
+    REQUIRE(gray.g == 0);
+    REQUIRE(gray.b == 0);
+    REQUIRE(gray.w == 77);
+}
+
+TEST_CASE("HSV fades", "[COLOR]")
+{
+    HsvFade fade;
+    ColorHsv from, to;
+
+    SECTION("the hue takes the shorter way around the circle")
+    {
+        from.h = 250; from.s = 255; from.v = 100;
+        to.h   =  10; to.s   = 255; to.v   = 200;
+        fade.start(from, to, 1000);
+        unsigned int steps = 0;
+        int lastV = from.v;
+        while (fade.isRunning())
+        {
+            bool done = fade.step();
+            steps++;
+            ColorHsv c = fade.color();
+            REQUIRE(((c.h >= 250) || (c.h <= 10)));
+            REQUIRE(c.v >= lastV);
+            REQUIRE(done == !fade.isRunning());
+            lastV = c.v;
+        }
+        REQUIRE(steps == 1000);
+        REQUIRE(fade.color().h == 10);
+        REQUIRE(fade.color().v == 200);
+    }
+    SECTION("the target is reached exactly")
+    {
+        from.h = 0;   from.s = 0;   from.v = 255;
+        to.h   = 171; to.s   = 254; to.v   = 3;
+        fade.start(from, to, 333);
+        for (unsigned int i = 0; i < 332; i++)
+            REQUIRE(!fade.step());
+        REQUIRE(fade.step());
+        REQUIRE(fade.color().h == 171);
+        REQUIRE(fade.color().s == 254);
+        REQUIRE(fade.color().v == 3);
+        REQUIRE(!fade.step());
+    }
+    SECTION("a fade without ticks jumps to the target")
+    {
+        from.h = 1; from.s = 2; from.v = 3;
+        to.h   = 4; to.s   = 5; to.v   = 6;
+        fade.start(from, to, 0);
+        REQUIRE(!fade.isRunning());
+        REQUIRE(fade.color().h == 4);
+        REQUIRE(fade.color().v == 6);
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ *  curves.cpp - Compare the dimming curve tables with the float calculation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <stdio.h>
+#include <time.h>
+#include <DimmingCurves.h>
+#include <config.h>
+#include <com_objs.h>
+#include <pwmout.h>
+
+MASK0701 bcu = MASK0701(); // defined in Appl.cpp of the application
+
+// the calculation setOutput() did for each dimming step before the tables,
+// with the fourth power in float (the int product overflowed above 215),
+// scaled to the PWM duty cycle 0..PWM_DUTY_MAX
+static int reference(int ch, int value)
+{
+    float outputValue;
+    float v;
+    if (value < 1) {
+        outputValue = 0;
+    } else {
+        int max = (2*MAXOUTPUTVALUE*bcu.userEeprom->getUInt8(APP_MAX_LIGHT + ch * APP_CH_OFFS)/255+1)/2;
+        int min = (2*MAXOUTPUTVALUE*bcu.userEeprom->getUInt8(APP_MIN_LIGHT + ch * APP_CH_OFFS)/255+1)/2;
+        if (value > max) {
+            value = max;
+        } else if (value < min) {
+            value = min;
+        }
+        v = value;
+        switch (bcu.userEeprom->getUInt8(APP_DIMM_CURVE)) {
+        case 0:
+            outputValue = v*v*0.0001f;
+            break;
+        case 2:
+            outputValue = 0.0000000000009f*(v * v * v * v) + 0.1f*v;
+            break;
+        default:
+            outputValue = value;
+            break;
+        }
+    }
+    return outputValue * (PWM_DUTY_MAX / MAXOUTPUTVALUE) + 0.5f;
+}
+
+static void setup(int curve)
+{
+    const int limits[4][2] = { { 0, 255 }, { 25, 255 }, { 0, 128 }, { 77, 200 } };
+    (*bcu.userEeprom)[APP_DIMM_CURVE] = curve;
+    for (int ch = 0; ch < 4; ch++)
+    {
+        (*bcu.userEeprom)[APP_MIN_LIGHT + ch * APP_CH_OFFS] = limits[ch][0];
+        (*bcu.userEeprom)[APP_MAX_LIGHT + ch * APP_CH_OFFS] = limits[ch][1];
+    }
+    initDimmingCurves();
+}
+
+// largest difference between table and float calculation over all values of all channels,
+// in steps of the PWM duty cycle
+static int maxError(void)
+{
+    int error = 0;
+    for (int ch = 0; ch < 4; ch++)
+    {
+        int last = 0;
+        for (int value = 0; value <= MAXOUTPUTVALUE; value++)
+        {
+            int out = dimmingCurveValue(ch, value);
+            int diff = out - reference(ch, value);
+            if (diff < 0)
+                diff = -diff;
+            if (diff > error)
+                error = diff;
+            // the brightness must never go down while dimming up
+            REQUIRE(out >= last);
+            last = out;
+        }
+    }
+    return error;
+}
+
+TEST_CASE("Dimming curve tables", "[CURVES]")
+{
+    SECTION("linear")
+    {
+        setup(7);
+        REQUIRE(maxError() <= 2);
+    }
+    SECTION("quadratic")
+    {
+        setup(0);
+        REQUIRE(maxError() <= 2);
+    }
+    SECTION("semi-logarithmic")
+    {
+        setup(2);
+        REQUIRE(maxError() <= 2);
+    }
+    SECTION("off, minimum and maximum brightness are exact")
+    {
+        setup(0);
+        for (int ch = 0; ch < 4; ch++)
+        {
+            REQUIRE(dimmingCurveValue(ch, 0) == 0);
+            REQUIRE(dimmingCurveValue(ch, 1) == reference(ch, 1));
+            REQUIRE(dimmingCurveValue(ch, MAXOUTPUTVALUE) == reference(ch, MAXOUTPUTVALUE));
+        }
+    }
+    SECTION("minimum above the maximum")
+    {
+        (*bcu.userEeprom)[APP_MIN_LIGHT] = 200;
+        (*bcu.userEeprom)[APP_MAX_LIGHT] = 100;
+        initDimmingCurves();
+        REQUIRE(dimmingCurveValue(0, 1) == dimmingCurveValue(0, MAXOUTPUTVALUE));
+    }
+}
+
+TEST_CASE("Dimming curve speed", "[CURVES]")
+{
+    struct timespec start, middle, end;
+    volatile int sink = 0;
+
+    setup(2);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int value = 0; value <= MAXOUTPUTVALUE; value++)
+        sink = sink + dimmingCurveValue(value & 3, value);
+    clock_gettime(CLOCK_MONOTONIC, &middle);
+    for (int value = 0; value <= MAXOUTPUTVALUE; value++)
+        sink = sink + reference(value & 3, value);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    unsigned int table = (middle.tv_sec - start.tv_sec) * 1000000000 + middle.tv_nsec - start.tv_nsec;
+    unsigned int calc  = (end.tv_sec - middle.tv_sec) * 1000000000 + end.tv_nsec - middle.tv_nsec;
+    printf("dimming curves: table %u ns, float calculation %u ns for 10001 values on the host\n", table, calc);
+    REQUIRE(table < calc);
+}
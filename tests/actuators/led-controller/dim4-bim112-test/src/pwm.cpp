@@ -0,0 +1,200 @@
+/*
+ *  pwm.cpp - Tests of the dithered PWM outputs with simulated match registers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <stdio.h>
+#include <time.h>
+#include <pwmout.h>
+#include <config.h>
+#include <com_objs.h>
+
+pwmout pwmout[4]; // defined in Appl.cpp of the application
+
+extern "C" void TIMER16_0_IRQHandler(void);
+extern "C" void TIMER32_1_IRQHandler(void);
+
+static void setUInt16(unsigned int address, unsigned int value)
+{
+    (*bcu.userEeprom)[address]     = value >> 8;
+    (*bcu.userEeprom)[address + 1] = value;
+}
+
+static void beginOutputs(unsigned int frequency)
+{
+    setUInt16(APP_PWM_O, frequency);
+    for (int ch = 0; ch < 4; ch++)
+        pwmout[ch].begin(ch);
+}
+
+/*
+ * run the PWM of channel 2 for the given number of periods and sum up
+ * the time the output is on, in timer clocks
+ */
+static unsigned long long onTime(unsigned int periods, unsigned int pwmmax, unsigned int & minOn, unsigned int & maxOn)
+{
+    unsigned long long sum = 0;
+    minOn = pwmmax;
+    maxOn = 0;
+    for (unsigned int i = 0; i < periods; i++)
+    {
+        TIMER32_1_IRQHandler();
+        unsigned int on = pwmmax - timer32_1.match(MAT0);
+        if (on < minOn) minOn = on;
+        if (on > maxOn) maxOn = on;
+        sum += on;
+    }
+    return sum;
+}
+
+TEST_CASE("Dithered PWM", "[PWM]")
+{
+    const unsigned int duties[] = { 0, 1, 2, 3, 7, 100, 1000, 12345, 32768, 65000, 65534, PWM_DUTY_MAX };
+    const unsigned int pwmmax = PWM_MAX_1000;
+    unsigned int minOn, maxOn;
+
+    beginOutputs(0xA00);
+    for (unsigned int duty : duties)
+    {
+        pwmout[2].setpwm(duty);
+        pwmout::update();
+        // over 2^16 periods the on time must be exact to one clock
+        unsigned long long sum = onTime(0x10000, pwmmax, minOn, maxOn);
+        double expected = (double) duty * pwmmax * 0x10000 / PWM_DUTY_MAX;
+        INFO("duty " << duty);
+        REQUIRE(sum >= expected - 1);
+        REQUIRE(sum <= expected + 1);
+        // the on time of a single period only varies by one clock
+        REQUIRE(maxOn - minOn <= 1);
+    }
+    pwmout[2].setpwm(0);
+    pwmout::update();
+    onTime(1, pwmmax, minOn, maxOn);
+    REQUIRE(timer32_1.match(MAT0) == pwmmax);
+    pwmout[2].setpwm(PWM_DUTY_MAX);
+    pwmout::update();
+    onTime(1, pwmmax, minOn, maxOn);
+    REQUIRE(timer32_1.match(MAT0) == 0);
+    pwmout[2].setpwm(PWM_DUTY_MAX + 1000);
+    pwmout::update();
+    onTime(1, pwmmax, minOn, maxOn);
+    REQUIRE(timer32_1.match(MAT0) == 0);
+}
+
+TEST_CASE("Dithered PWM resolution at 600Hz", "[PWM]")
+{
+    unsigned int minOn, maxOn;
+    unsigned long long last = 0;
+
+    beginOutputs(0x600);
+    // each of the lowest duty values gives a different average brightness
+    for (unsigned int duty = 1; duty < 64; duty++)
+    {
+        pwmout[2].setpwm(duty);
+        pwmout::update();
+        unsigned long long sum = onTime(0x10000, PWM_MAX_600, minOn, maxOn);
+        REQUIRE(sum > last);
+        last = sum;
+    }
+}
+
+TEST_CASE("PWM interrupt budget", "[PWM]")
+{
+    struct timespec start, end;
+    const unsigned int periods = 1000000;
+
+    beginOutputs(0xA00);
+    for (int ch = 0; ch < 4; ch++)
+        pwmout[ch].setpwm(12345 * (ch + 1));
+    pwmout::update();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned int i = 0; i < periods; i++)
+    {
+        TIMER16_0_IRQHandler();
+        TIMER32_1_IRQHandler();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    unsigned int nanos = ((end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec) / periods;
+    printf("dithered PWM: %u ns for the interrupts of one period of 4 channels on the host\n", nanos);
+    // a few additions per channel, far below the 1ms period even on the target
+    REQUIRE(nanos < 1000);
+}
+
+// on time of the channels 1..3 in the last period, channel 0 is not used
+static void periodEnd(unsigned int * on)
+{
+    TIMER16_0_IRQHandler();
+    TIMER32_1_IRQHandler();
+    on[1] = PWM_MAX_1000 - timer16_0.match(MAT1);
+    on[2] = PWM_MAX_1000 - timer32_1.match(MAT0);
+    on[3] = PWM_MAX_1000 - timer32_1.match(MAT1);
+}
+
+TEST_CASE("Synchronous update of all channels", "[PWM]")
+{
+    unsigned int on[4];
+
+    beginOutputs(0xA00);
+    for (int ch = 0; ch < 4; ch++)
+        pwmout[ch].setpwm(0);
+    pwmout::update();
+    periodEnd(on);
+
+    // the prepared values are not output before the update
+    pwmout[1].setpwm(PWM_DUTY_MAX);
+    pwmout[2].setpwm(PWM_DUTY_MAX / 2 + 1);
+    pwmout[3].setpwm(PWM_DUTY_MAX);
+    periodEnd(on);
+    REQUIRE(on[1] == 0);
+    REQUIRE(on[2] == 0);
+    REQUIRE(on[3] == 0);
+
+    // both timers take the complete set at the same period end
+    pwmout::update();
+    periodEnd(on);
+    REQUIRE(on[1] == PWM_MAX_1000);
+    REQUIRE(on[2] >= PWM_MAX_1000 / 2);
+    REQUIRE(on[2] <= PWM_MAX_1000 / 2 + 1); // dithered
+    REQUIRE(on[3] == PWM_MAX_1000);
+
+    // a channel without a new value keeps its duty
+    pwmout[3].setpwm(0);
+    pwmout::update();
+    periodEnd(on);
+    REQUIRE(on[1] == PWM_MAX_1000);
+    REQUIRE(on[2] >= PWM_MAX_1000 / 2);
+    REQUIRE(on[2] <= PWM_MAX_1000 / 2 + 1);
+    REQUIRE(on[3] == 0);
+
+    // two updates between the period ends of the timers, both output the newer set
+    pwmout[1].setpwm(0);
+    pwmout[3].setpwm(0);
+    pwmout::update();
+    TIMER16_0_IRQHandler();
+    REQUIRE(timer16_0.match(MAT1) == PWM_MAX_1000);
+    pwmout[1].setpwm(PWM_DUTY_MAX);
+    pwmout[3].setpwm(PWM_DUTY_MAX);
+    pwmout::update();
+    periodEnd(on);
+    REQUIRE(on[1] == PWM_MAX_1000);
+    REQUIRE(on[3] == PWM_MAX_1000);
+
+    // an update without new values keeps the set
+    pwmout::update();
+    periodEnd(on);
+    REQUIRE(on[1] == PWM_MAX_1000);
+    REQUIRE(on[3] == PWM_MAX_1000);
+}
+
+TEST_CASE("Both PWM timers are restarted together", "[PWM]")
+{
+    beginOutputs(0xA00);
+    unsigned int restarts16 = timer16_0.restarts;
+    unsigned int restarts32 = timer32_1.restarts;
+    pwmout::synchronize();
+    REQUIRE(timer16_0.restarts == restarts16 + 1);
+    REQUIRE(timer32_1.restarts == restarts32 + 1);
+}
@@ -0,0 +1,137 @@
+/*
+ *  ramps.cpp - Tests of the incremental dimming ramps
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <dimming.h>
+#include <config.h>
+#include <sblib/timer.h>
+
+// advance the system time and run the main loop once per ms
+static unsigned int runUntilDone(dimming & dim, unsigned int limit)
+{
+    unsigned int ms = 0;
+    while (dim.getIsDimming() && (ms < limit))
+    {
+        systemTime++;
+        ms++;
+        dim.checkperiodic();
+    }
+    return ms;
+}
+
+TEST_CASE("Dimming ramps", "[RAMPS]")
+{
+    dimming dim;
+    dim.init(1);
+    systemTime = 0xFFFFF000; // the ramps have to survive the wrap around of the system time
+
+    SECTION("the full range takes the dimming speed")
+    {
+        int last = 0;
+        dim.start(255, 2);
+        for (unsigned int ms = 1; ms < 2000; ms++)
+        {
+            systemTime++;
+            dim.checkperiodic();
+            REQUIRE(dim.getIsDimming());
+            REQUIRE(dim.getactualdimvalue() >= last);
+            last = dim.getactualdimvalue();
+        }
+        REQUIRE(runUntilDone(dim, 10) == 1);
+        REQUIRE(dim.getactualdimvalue() == 255);
+        REQUIRE(dim.finished);
+        REQUIRE(dim.getswitchstatus());
+    }
+    SECTION("a shorter distance takes proportionally less time")
+    {
+        dim.start(255, 0);
+        REQUIRE(dim.getactualdimvalue() == 255);
+        dim.start(51, 5);
+        REQUIRE(runUntilDone(dim, 10000) == 4000);
+        REQUIRE(dim.getactualdimvalue() == 51);
+        dim.start(0, 5);
+        REQUIRE(runUntilDone(dim, 10000) == 1000);
+        REQUIRE(dim.getactualdimvalue() == 0);
+        REQUIRE(!dim.getswitchstatus());
+    }
+    SECTION("missed steps are caught up")
+    {
+        dimming ref;
+        ref.init(2);
+        dim.start(200, 3);
+        ref.start(200, 3);
+        for (unsigned int i = 0; i < 37; i++)
+        {
+            systemTime++;
+            ref.checkperiodic();
+        }
+        dim.checkperiodic();
+        REQUIRE(dim.getactualdimvalue() == ref.getactualdimvalue());
+        systemTime += 5000;
+        dim.checkperiodic();
+        REQUIRE(!dim.getIsDimming());
+        REQUIRE(dim.getactualdimvalue() == 200);
+    }
+    SECTION("a stopped ramp keeps its value")
+    {
+        dim.start(255, 1);
+        for (unsigned int i = 0; i < 500; i++)
+        {
+            systemTime++;
+            dim.checkperiodic();
+        }
+        dim.stop();
+        int stopped = dim.getactualdimvalue();
+        REQUIRE(stopped >= 126);
+        REQUIRE(stopped <= 128);
+        systemTime += 100;
+        dim.checkperiodic();
+        REQUIRE(dim.getactualdimvalue() == stopped);
+    }
+    SECTION("every brightness value is reached exactly")
+    {
+        for (int value = 0; value <= 255; value++)
+        {
+            dim.start(value, 0);
+            REQUIRE(dim.getactualdimvalue() == value);
+        }
+    }
+}
+
+TEST_CASE("Synchronised colour fade", "[RAMPS]")
+{
+    const int from[3] = { 0, 200, 17 };
+    const int to[3]   = { 255, 3, 18 };
+    dimming dim[3];
+    unsigned int ends[3] = { 0, 0, 0 };
+
+    for (int ch = 0; ch < 3; ch++)
+    {
+        dim[ch].init(ch);
+        dim[ch].start(from[ch], 0);
+    }
+    unsigned int start = millis();
+    for (int ch = 0; ch < 3; ch++)
+        dim[ch].fadeTo(to[ch], 1234, start);
+
+    for (unsigned int ms = 1; ms <= 2000; ms++)
+    {
+        systemTime++;
+        for (int ch = 0; ch < 3; ch++)
+        {
+            bool before = dim[ch].getIsDimming();
+            dim[ch].checkperiodic();
+            if (before && !dim[ch].getIsDimming())
+                ends[ch] = ms;
+        }
+    }
+    for (int ch = 0; ch < 3; ch++)
+    {
+        REQUIRE(ends[ch] == 1234);
+        REQUIRE(dim[ch].getactualdimvalue() == to[ch]);
+    }
+}
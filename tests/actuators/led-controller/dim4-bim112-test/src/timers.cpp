@@ -0,0 +1,158 @@
+/*
+ *  timers.cpp - Tests of the timer queue and the time functions at the
+ *               wrap around of the system time
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <vector>
+#include <TimerQueue.h>
+#include <Timefunctions.h>
+#include <dimming.h>
+#include <config.h>
+#include <com_objs.h>
+#include <sblib/timer.h>
+
+// defined in Appl.cpp of the application
+dimming dimming[4];
+TimerQueue timerQueue;
+
+static std::vector<int> fired;
+
+static void record(void * context)
+{
+    fired.push_back(* (int *) context);
+}
+
+static int ids[TIMER_QUEUE_SIZE] = { 0, 1, 2, 3 };
+
+TEST_CASE("Timer queue", "[TIMER]")
+{
+    TimerQueue queue;
+    const unsigned int now = 0xFFFFFF00;
+    fired.clear();
+
+    SECTION("the deadlines expire in order across the wrap around")
+    {
+        queue.start(0, 0x200, now, record, &ids[0]); // 0x00000100
+        queue.start(1, 0x080, now, record, &ids[1]); // 0xFFFFFF80
+        queue.start(2, 0x100, now, record, &ids[2]); // 0x00000000
+        queue.run(0xFFFFFF7F);
+        REQUIRE(fired.empty());
+        queue.run(0xFFFFFF80);
+        REQUIRE(fired == std::vector<int>({ 1 }));
+        queue.run(0xFFFFFFFF);
+        REQUIRE(fired.size() == 1);
+        queue.run(0x00000000);
+        REQUIRE(fired == std::vector<int>({ 1, 2 }));
+        queue.run(0x000000FF);
+        REQUIRE(queue.isRunning(0));
+        queue.run(0x00000100);
+        REQUIRE(fired == std::vector<int>({ 1, 2, 0 }));
+        REQUIRE(!queue.isRunning(0));
+    }
+    SECTION("a late run fires all expired entries in the order of their deadlines")
+    {
+        queue.start(3, 300, now, record, &ids[3]);
+        queue.start(0, 100, now, record, &ids[0]);
+        queue.start(1, 200, now, record, &ids[1]);
+        queue.run(now + 1000);
+        REQUIRE(fired == std::vector<int>({ 0, 1, 3 }));
+    }
+    SECTION("a restarted or stopped entry does not fire at its old deadline")
+    {
+        queue.start(0, 100, now, record, &ids[0]);
+        queue.start(1, 150, now, record, &ids[1]);
+        queue.start(0, 500, now, record, &ids[0]);
+        queue.stop(1);
+        queue.stop(2); // not running
+        queue.run(now + 499);
+        REQUIRE(fired.empty());
+        REQUIRE(!queue.isRunning(1));
+        queue.run(now + 500);
+        REQUIRE(fired == std::vector<int>({ 0 }));
+    }
+    SECTION("a delay of 0 expires at the next run")
+    {
+        queue.start(2, 0, now, record, &ids[2]);
+        queue.run(now);
+        REQUIRE(fired == std::vector<int>({ 2 }));
+    }
+}
+
+static int restarts;
+
+static void periodic(void * context)
+{
+    TimerQueue * queue = (TimerQueue *) context;
+    if (++restarts < 10)
+        queue->start(0, 1000, millis(), periodic, queue);
+}
+
+TEST_CASE("Timer restarted from its callback", "[TIMER]")
+{
+    TimerQueue queue;
+    restarts = 0;
+    systemTime = 0xFFFFF000;
+    queue.start(0, 1000, millis(), periodic, &queue);
+    for (unsigned int ms = 0; ms < 20000; ms++)
+    {
+        systemTime++;
+        queue.run(millis());
+    }
+    REQUIRE(restarts == 10);
+    REQUIRE(!queue.isRunning(0));
+}
+
+static void setUInt16(unsigned int address, unsigned int value)
+{
+    (*bcu.userEeprom)[address]     = value >> 8;
+    (*bcu.userEeprom)[address + 1] = value;
+}
+
+// run the main loop for ms, the system time wraps around in between
+static void runMainLoop(unsigned int ms)
+{
+    for (unsigned int i = 0; i < ms; i++)
+    {
+        systemTime++;
+        timerQueue.run(millis());
+        dimming[1].checkperiodic();
+    }
+}
+
+TEST_CASE("Staircase function across the wrap around", "[TIMER]")
+{
+    const unsigned int channel = 1;
+    const unsigned int offs = channel * APP_CH_OFFS;
+    Timefunctions timefunction;
+
+    setUInt16(APP_ON_DELAY + offs, 2);
+    setUInt16(APP_STAIR_DUR + offs, 5);
+    setUInt16(APP_STAIR_PREWARN + offs, 3);
+    (*bcu.userEeprom)[APP_STAIR_DIM + offs] = 128;
+    (*bcu.userEeprom)[APP_STAIR_EXTENSION + offs] = 0;
+    (*bcu.userEeprom)[APP_ON_SPEED + offs] = 0;
+    (*bcu.userEeprom)[APP_OFF_SPEED + offs] = 0;
+    dimming[channel].init(channel);
+    timefunction.init(channel);
+    systemTime = 0xFFFFFFFF - 4000;
+
+    timefunction.objStairs(1);
+    runMainLoop(1999);
+    REQUIRE(dimming[channel].getactualdimvalue() == 0);
+    runMainLoop(1);
+    REQUIRE(dimming[channel].getactualdimvalue() == 255);
+    runMainLoop(4999);  // the system time has wrapped around
+    REQUIRE(systemTime < 0x10000);
+    REQUIRE(dimming[channel].getactualdimvalue() == 255);
+    runMainLoop(1);
+    REQUIRE(dimming[channel].getactualdimvalue() == 128);
+    runMainLoop(2999);
+    REQUIRE(dimming[channel].getactualdimvalue() == 128);
+    runMainLoop(1);
+    REQUIRE(dimming[channel].getactualdimvalue() == 0);
+    REQUIRE(!timerQueue.isRunning(channel));
+}
@@ -0,0 +1,276 @@
+/*
+ *  scenes.cpp - Tests of the scene storage with power cycles and torn
+ *               writes, and of the synchronized fade to a scene
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <string.h>
+#include <scenes.h>
+#include <color.h>
+
+static byte flash[SCENE_SECTOR_COUNT * SCENE_SECTOR_SIZE];
+
+// flash in RAM: erasing sets 0xFF, programming can only clear bits.
+// A power failure is simulated by the number of bytes which can still be
+// programmed, or erased, before the supply is gone.
+class RamSceneStore : public SceneStore
+{
+public:
+    unsigned int eraseCnt[SCENE_SECTOR_COUNT];
+    unsigned int programCnt;
+    int powerBytes;
+    int tornErase;
+
+    RamSceneStore()
+    {
+        memset(eraseCnt, 0, sizeof(eraseCnt));
+        programCnt = 0;
+        powerBytes = -1;
+        tornErase  = -1;
+    }
+
+protected:
+    virtual bool eraseSector(unsigned int sector)
+    {
+        unsigned int len = SCENE_SECTOR_SIZE;
+        if (tornErase >= 0)
+            len = tornErase;
+        memset(flash + sector * SCENE_SECTOR_SIZE, 0xff, len);
+        eraseCnt[sector]++;
+        return len == SCENE_SECTOR_SIZE;
+    }
+
+    virtual bool programPage(unsigned int sector, unsigned int page, const byte * data)
+    {
+        unsigned int len = SCENE_PAGE_SIZE;
+        if ((powerBytes >= 0) && (powerBytes < SCENE_PAGE_SIZE))
+            len = powerBytes;
+        if (powerBytes >= 0)
+            powerBytes -= len;
+        byte * ptr = flash + sector * SCENE_SECTOR_SIZE + page * SCENE_PAGE_SIZE;
+        for (unsigned int i = 0; i < len; i++)
+            ptr[i] &= data[i];
+        programCnt++;
+        return len == SCENE_PAGE_SIZE;
+    }
+
+    virtual const byte * pagePtr(unsigned int sector, unsigned int page)
+    {
+        return flash + sector * SCENE_SECTOR_SIZE + page * SCENE_PAGE_SIZE;
+    }
+};
+
+static Scene makeScene(unsigned int number, unsigned int variant)
+{
+    Scene scene;
+    scene.color.r  = number * 3 + variant;
+    scene.color.g  = 255 - number;
+    scene.color.b  = number ^ variant;
+    scene.color.w  = variant;
+    scene.fadeTime = number * 100 + variant;
+    return scene;
+}
+
+static bool sameScene(const Scene & a, const Scene & b)
+{
+    return (a.color.r == b.color.r) && (a.color.g == b.color.g) && (a.color.b == b.color.b)
+        && (a.color.w == b.color.w) && (a.fadeTime == b.fadeTime);
+}
+
+TEST_CASE("Scene storage", "[SCENES]")
+{
+    Scene scene;
+    memset(flash, 0xff, sizeof(flash));
+
+    SECTION("no scene has been learned after the first start")
+    {
+        RamSceneStore store;
+        store.init();
+        for (unsigned int i = 0; i < SCENE_COUNT; i++)
+            REQUIRE(!store.get(i, scene));
+    }
+    SECTION("learned scenes survive a power cycle")
+    {
+        RamSceneStore store;
+        store.init();
+        for (unsigned int i = 0; i < SCENE_COUNT; i += 2)
+            REQUIRE(store.store(i, makeScene(i, 1)));
+        REQUIRE(store.store(63, makeScene(63, 2)));
+        // one erase and three page programs per learn, both sectors in turn
+        REQUIRE(store.programCnt == 33 * (SCENE_TABLE_PAGES + 1));
+        REQUIRE(store.eraseCnt[0] == 17);
+        REQUIRE(store.eraseCnt[1] == 16);
+
+        RamSceneStore restarted;
+        restarted.init();
+        for (unsigned int i = 0; i < SCENE_COUNT - 1; i++)
+        {
+            INFO("scene " << i);
+            if (i & 1)
+                REQUIRE(!restarted.get(i, scene));
+            else
+            {
+                REQUIRE(restarted.get(i, scene));
+                REQUIRE(sameScene(scene, makeScene(i, 1)));
+            }
+        }
+        REQUIRE(restarted.get(63, scene));
+        REQUIRE(sameScene(scene, makeScene(63, 2)));
+        REQUIRE(!restarted.get(64, scene));
+    }
+    SECTION("a learn interrupted by a power failure keeps the previous scenes")
+    {
+        // the new table becomes valid with the last programmed byte of the header,
+        // for sequence number 3 the upper 3 bytes of the complement stay 0xFF
+        const int valid = SCENE_TABLE_PAGES * SCENE_PAGE_SIZE + 6;
+        for (int torn = 0; torn <= (SCENE_TABLE_PAGES + 1) * SCENE_PAGE_SIZE; torn++)
+        {
+            memset(flash, 0xff, sizeof(flash));
+            RamSceneStore store;
+            store.init();
+            REQUIRE(store.store(5, makeScene(5, 1)));
+            REQUIRE(store.store(40, makeScene(40, 1)));
+            store.powerBytes = torn;
+            bool written = store.store(40, makeScene(40, 3));
+            REQUIRE(written == (torn == (SCENE_TABLE_PAGES + 1) * SCENE_PAGE_SIZE));
+
+            RamSceneStore restarted;
+            restarted.init();
+            INFO("torn after " << torn << " bytes");
+            REQUIRE(restarted.get(5, scene));
+            REQUIRE(sameScene(scene, makeScene(5, 1)));
+            REQUIRE(restarted.get(40, scene));
+            REQUIRE(sameScene(scene, makeScene(40, torn >= valid ? 3 : 1)));
+        }
+    }
+    SECTION("an interrupted erase keeps the previous scenes")
+    {
+        RamSceneStore store;
+        store.init();
+        REQUIRE(store.store(7, makeScene(7, 1)));
+        store.tornErase = 100;
+        REQUIRE(!store.store(7, makeScene(7, 2)));
+        RamSceneStore restarted;
+        restarted.init();
+        REQUIRE(restarted.get(7, scene));
+        REQUIRE(sameScene(scene, makeScene(7, 1)));
+    }
+    SECTION("a learned scene is written in the main loop into a sector erased in advance")
+    {
+        RamSceneStore store;
+        store.init();
+        store.process(); // an empty sector is only read
+        REQUIRE(store.store(3, makeScene(3, 1)));
+        store.process();
+        REQUIRE(store.store(3, makeScene(3, 2)));
+        REQUIRE(store.eraseCnt[0] == 0);
+        REQUIRE(store.eraseCnt[1] == 0);
+
+        store.process(); // idle time: erase the sector for the next learn
+        REQUIRE(store.eraseCnt[0] == 1);
+        store.process();
+        REQUIRE(store.eraseCnt[0] == 1);
+
+        store.learn(3, makeScene(3, 3));
+        REQUIRE(store.programCnt == 2 * (SCENE_TABLE_PAGES + 1));
+        REQUIRE(store.get(3, scene));
+        REQUIRE(sameScene(scene, makeScene(3, 3)));
+        store.process();
+        REQUIRE(store.programCnt == 3 * (SCENE_TABLE_PAGES + 1));
+        REQUIRE(store.eraseCnt[0] == 1);
+
+        // further learns before the first one has been written are queued and written in one table
+        REQUIRE(store.learn(4, makeScene(4, 1)));
+        REQUIRE(store.learn(40, makeScene(40, 1)));
+        REQUIRE(store.learn(4, makeScene(4, 2)));
+        REQUIRE(store.programCnt == 3 * (SCENE_TABLE_PAGES + 1));
+        REQUIRE(store.get(4, scene));
+        REQUIRE(sameScene(scene, makeScene(4, 2)));
+        store.process();
+        REQUIRE(store.programCnt == 4 * (SCENE_TABLE_PAGES + 1));
+        store.process();
+        REQUIRE(store.eraseCnt[1] == 1);
+
+        // a full queue refuses a further scene but still takes a queued one
+        for (unsigned int i = 0; i < SCENE_QUEUE_LEN; i++)
+            REQUIRE(store.learn(10 + i, makeScene(10 + i, 1)));
+        REQUIRE(!store.learn(5, makeScene(5, 1)));
+        REQUIRE(store.learn(10, makeScene(10, 2)));
+        REQUIRE(store.programCnt == 4 * (SCENE_TABLE_PAGES + 1));
+        store.process();
+        REQUIRE(store.programCnt == 5 * (SCENE_TABLE_PAGES + 1));
+
+        RamSceneStore restarted;
+        restarted.init();
+        REQUIRE(restarted.get(3, scene));
+        REQUIRE(sameScene(scene, makeScene(3, 3)));
+        REQUIRE(restarted.get(4, scene));
+        REQUIRE(sameScene(scene, makeScene(4, 2)));
+        REQUIRE(restarted.get(40, scene));
+        REQUIRE(sameScene(scene, makeScene(40, 1)));
+        REQUIRE(!restarted.get(5, scene));
+        REQUIRE(restarted.get(10, scene));
+        REQUIRE(sameScene(scene, makeScene(10, 2)));
+        for (unsigned int i = 1; i < SCENE_QUEUE_LEN; i++)
+        {
+            REQUIRE(restarted.get(10 + i, scene));
+            REQUIRE(sameScene(scene, makeScene(10 + i, 1)));
+        }
+    }
+    SECTION("the sequence number decides after the sectors have been used many times")
+    {
+        RamSceneStore store;
+        store.init();
+        for (unsigned int i = 0; i < 301; i++)
+            REQUIRE(store.store(i % SCENE_COUNT, makeScene(i % SCENE_COUNT, i / SCENE_COUNT)));
+        RamSceneStore restarted;
+        restarted.init();
+        REQUIRE(restarted.get(300 % SCENE_COUNT, scene));
+        REQUIRE(sameScene(scene, makeScene(300 % SCENE_COUNT, 300 / SCENE_COUNT)));
+        REQUIRE(restarted.get(299 % SCENE_COUNT, scene));
+        REQUIRE(sameScene(scene, makeScene(299 % SCENE_COUNT, 299 / SCENE_COUNT)));
+    }
+}
+
+TEST_CASE("Fade to a scene", "[SCENES]")
+{
+    RgbwFade fade;
+    ColorRgbw from = { 255, 0, 30, 200 };
+    ColorRgbw to   = { 0, 128, 31, 200 };
+    const unsigned int ticks = 1500;
+
+    fade.start(from, to, ticks);
+    ColorRgbw last = from;
+    for (unsigned int i = 1; i <= ticks; i++)
+    {
+        REQUIRE(fade.isRunning());
+        bool done = fade.step();
+        ColorRgbw color = fade.color();
+        // all channels change monotonically and reach the target in the same step
+        REQUIRE(color.r <= last.r);
+        REQUIRE(color.g >= last.g);
+        REQUIRE(color.b >= last.b);
+        REQUIRE(color.w == 200);
+        if (i == ticks / 2)
+        {
+            REQUIRE(color.r >= 127);
+            REQUIRE(color.r <= 128);
+            REQUIRE(color.g == 64);
+        }
+        REQUIRE(done == (i == ticks));
+        last = color;
+    }
+    REQUIRE(!fade.isRunning());
+    REQUIRE(last.r == 0);
+    REQUIRE(last.g == 128);
+    REQUIRE(last.b == 31);
+
+    // a fade time of 0 sets the scene at once
+    fade.start(to, from, 0);
+    REQUIRE(!fade.isRunning());
+    REQUIRE(fade.color().r == 255);
+    REQUIRE(fade.color().b == 30);
+}
@@ -0,0 +1,86 @@
+/*
+ *  SimJournal.cpp - State journal of the simulation, kept in RAM
+ *
+ *  Ersetzt src/StateJournal.cpp in der Simulation. Das Journal selbst wird in
+ *  out-cs-bim112-test geprüft. Hier bleibt nur der zuletzt geschriebene Datensatz
+ *  im Puffer, die Anzahl der Schreibvorgänge wird mitgezählt.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <string.h>
+#include <StateJournal.h>
+
+StateJournal journal;
+
+unsigned simJournalCommits = 0;
+
+StateJournal::StateJournal(void)
+{
+ NextSlot = 0;
+ NextSeq = 1;
+ memset(SlotBuf, 0xff, JOURNALSLOTSIZE);
+}
+
+bool StateJournal::EraseSector(unsigned SectorIdx)
+{
+ return true;
+}
+
+bool StateJournal::ProgramSlot(unsigned SlotIdx, const byte *data)
+{
+ simJournalCommits++;
+ return true;
+}
+
+const byte* StateJournal::SlotPtr(unsigned SlotIdx)
+{
+ return SlotBuf;
+}
+
+bool StateJournal::SlotValid(unsigned SlotIdx, unsigned &Seq)
+{
+ Seq = NextSeq-1;
+ return NextSeq > 1;
+}
+
+bool StateJournal::SlotErased(unsigned SlotIdx)
+{
+ return true;
+}
+
+bool StateJournal::SectorErased(unsigned SectorIdx)
+{
+ return true;
+}
+
+void StateJournal::SkipUsedSlots(void)
+{
+}
+
+void StateJournal::Init(void)
+{
+ // Der Puffer bleibt über einen Neustart der Applikation erhalten, wie der Flash
+ if (NextSeq == 1)
+  memset(SlotBuf, 0xff, JOURNALSLOTSIZE);
+}
+
+byte* StateJournal::Buffer(void)
+{
+ return SlotBuf+JOURNALHEADERLEN;
+}
+
+void StateJournal::PrepareNextSlot(void)
+{
+}
+
+bool StateJournal::Commit(unsigned len)
+{
+ if (len > JOURNALPAYLOADLEN)
+  return false;
+ NextSlot = (NextSlot+1) % JOURNALSLOTCNT;
+ NextSeq++;
+ return ProgramSlot(NextSlot, SlotBuf);
+}
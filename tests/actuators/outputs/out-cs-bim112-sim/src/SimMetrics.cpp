@@ -0,0 +1,143 @@
+/*
+ *  SimMetrics.cpp - Latency and CPU budget figures of the closed-loop simulation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "SimMetrics.h"
+
+SimStat::SimStat(void)
+{
+ Count = 0;
+ Sum = 0;
+ Min = 0;
+ Max = 0;
+}
+
+void SimStat::Add(double val)
+{
+ if ((Count == 0) || (val < Min))
+  Min = val;
+ if ((Count == 0) || (val > Max))
+  Max = val;
+ Sum += val;
+ Count++;
+}
+
+double SimStat::Mean(void)
+{
+ return Count ? Sum / Count : 0;
+}
+
+void SimStat::Print(FILE *f, const char *name, double scale, const char *unit)
+{
+ if (Count == 0)
+ {
+  fprintf(f, "  %-22s -\n", name);
+  return;
+ }
+ fprintf(f, "  %-22s n=%-6u avg %8.3f  min %8.3f  max %8.3f %s\n", name, Count,
+   Mean() * scale, Min * scale, Max * scale, unit);
+}
+
+SimMetrics::SimMetrics(void)
+{
+ UnsolicitedChanges = 0;
+ IneffectiveTelegrams = 0;
+ MissedThresholds = 0;
+ IsrCallsPerTick = 0;
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  TelegramTime[ch] = -1;
+  LoadTime[ch] = -1;
+ }
+}
+
+void SimMetrics::Telegram(unsigned ch, double t)
+{
+ for (unsigned i = 0; i < CHANNELCNT; i++)
+ {
+  if ((ch != i) && (ch < CHANNELCNT))
+   continue;
+  // Ein noch offenes Telegramm hat bisher nichts bewirkt, gemessen wird ab dem neuen
+  if (TelegramTime[i] >= 0)
+   IneffectiveTelegrams++;
+  TelegramTime[i] = t;
+ }
+}
+
+void SimMetrics::ContactChanged(unsigned ch, double t)
+{
+ if ((TelegramTime[ch] >= 0) && (t - TelegramTime[ch] > SIMMAXCONTACTLATENCY))
+ { // Das Telegramm liegt zu weit zurück, es hat keine Kontaktänderung ausgelöst
+  IneffectiveTelegrams++;
+  TelegramTime[ch] = -1;
+ }
+ if (TelegramTime[ch] >= 0)
+ {
+  ContactLatency[ch].Add(t - TelegramTime[ch]);
+  TelegramTime[ch] = -1;
+ } else {
+  UnsolicitedChanges++;
+ }
+}
+
+void SimMetrics::LoadStep(unsigned ch, double t)
+{
+ if (LoadTime[ch] >= 0)
+  MissedThresholds++;
+ LoadTime[ch] = t;
+}
+
+void SimMetrics::ThresholdChanged(unsigned ch, double t)
+{
+ if (LoadTime[ch] >= 0)
+ {
+  ThresholdReaction[ch].Add(t - LoadTime[ch]);
+  LoadTime[ch] = -1;
+ }
+}
+
+void SimMetrics::Tick(double Isr, double Loop, unsigned IsrCalls)
+{
+ IsrTime.Add(Isr);
+ LoopTime.Add(Loop);
+ TickTime.Add(Isr + Loop);
+ IsrCallsPerTick = IsrCalls;
+}
+
+void SimMetrics::Report(FILE *f, double CpuScale)
+{
+ char name[32];
+ fprintf(f, "Telegram to contact:\n");
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  snprintf(name, sizeof(name), "channel %u", ch+1);
+  ContactLatency[ch].Print(f, name, 1000, "ms");
+ }
+ fprintf(f, "  contact changes without telegram: %u\n", UnsolicitedChanges);
+ unsigned Ineffective = IneffectiveTelegrams;
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  if (TelegramTime[ch] >= 0) // bis zum Ende der Simulation ohne Kontaktänderung
+   Ineffective++;
+ }
+ fprintf(f, "  telegrams without contact change: %u\n", Ineffective);
+
+ fprintf(f, "Load step to current threshold object:\n");
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  snprintf(name, sizeof(name), "channel %u", ch+1);
+  ThresholdReaction[ch].Print(f, name, 1000, "ms");
+ }
+ fprintf(f, "  load steps without reaction: %u\n", MissedThresholds);
+
+ fprintf(f, "CPU per 1ms tick (%u ADC interrupts, host time x %.1f):\n", IsrCallsPerTick, CpuScale);
+ IsrTime.Print(f, "ADC ISR", 1e6 * CpuScale, "us");
+ LoopTime.Print(f, "main loop", 1e6 * CpuScale, "us");
+ TickTime.Print(f, "total", 1e6 * CpuScale, "us");
+ fprintf(f, "  budget used: avg %.1f%%  max %.1f%%\n", TickTime.Mean() * CpuScale * 100 / 0.001,
+   TickTime.Max * CpuScale * 100 / 0.001);
+}
@@ -0,0 +1,70 @@
+/*
+ *  SimMetrics.h - Latency and CPU budget figures of the closed-loop simulation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef SIMMETRICS_H_
+#define SIMMETRICS_H_
+
+#include <stdio.h>
+#include <config.h>
+
+#define SIMMAXCONTACTLATENCY 1.0 // s, spätere Kontaktänderungen gehören nicht mehr zum Telegramm
+
+class SimStat
+{
+public:
+ SimStat(void);
+ void Add(double val);
+ double Mean(void);
+ void Print(FILE *f, const char *name, double scale, const char *unit);
+
+ unsigned Count;
+ double Sum;
+ double Min;
+ double Max;
+};
+
+/*
+ * Gemessen wird:
+ * - Telegramm bis Kontakt: vom Empfang eines Telegramms, das einen Kanal betrifft, bis zum
+ *   Umschlagen dessen Kontakts (Warteschlange, Energieverwaltung, 5ms-Raster, SPI, Ansprechzeit).
+ *   Allgemeine Objekte (Objektnummer < OFSCHANNELOBJECTS) betreffen alle Kanäle.
+ *   Gemessen wird ab dem letzten Telegramm. Ein Telegramm, auf das innerhalb von
+ *   SIMMAXCONTACTLATENCY keine Kontaktänderung folgt, hat keine ausgelöst (z.B. Einschalten
+ *   eines bereits geschlossenen Kontakts) und wird verworfen.
+ * - Stromschwelle: von einer Laständerung bis zur Änderung eines Stromschwellenobjekts des Kanals.
+ * - CPU-Budget je 1ms-Tick: Laufzeit der ADC-ISR und der Hauptschleife auf dem Host. Mit einem
+ *   Skalierungsfaktor (Option -k) lässt sich grob auf das Ziel hochrechnen.
+ */
+class SimMetrics
+{
+public:
+ SimMetrics(void);
+
+ void Telegram(unsigned ch, double t);
+ void ContactChanged(unsigned ch, double t);
+ void LoadStep(unsigned ch, double t);
+ void ThresholdChanged(unsigned ch, double t);
+ void Tick(double IsrTime, double LoopTime, unsigned IsrCalls);
+ void Report(FILE *f, double CpuScale);
+
+ SimStat ContactLatency[CHANNELCNT];
+ SimStat ThresholdReaction[CHANNELCNT];
+ unsigned UnsolicitedChanges; // Kontaktänderungen ohne vorheriges Telegramm (Zeitfunktionen, Schwellen...)
+ unsigned IneffectiveTelegrams; // Telegramme, die keine Kontaktänderung ausgelöst haben
+ unsigned MissedThresholds;   // Laständerungen, auf die bis zur nächsten keine Reaktion kam
+ SimStat IsrTime;
+ SimStat LoopTime;
+ SimStat TickTime;
+ unsigned IsrCallsPerTick;
+
+protected:
+ double TelegramTime[CHANNELCNT]; // < 0: kein Telegramm offen
+ double LoadTime[CHANNELCNT];
+};
+
+#endif /* SIMMETRICS_H_ */
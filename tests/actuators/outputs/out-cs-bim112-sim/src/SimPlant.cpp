@@ -0,0 +1,112 @@
+/*
+ *  SimPlant.cpp - Simulated loads, storage rail and ADC front end of the out-cs
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <math.h>
+#include "SimPlant.h"
+
+unsigned SimVoltageToAdc(double U)
+{
+ double val = U * 1023 / MAXURAIL;
+ if (val < 0)
+  return 0;
+ if (val > 1023)
+  return 1023;
+ return (unsigned) (val + 0.5);
+}
+
+SimPlant::SimPlant(void)
+{
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  Loads[ch].Irms = 0;
+  Loads[ch].InrushFactor = 1;
+  Loads[ch].InrushTau = 0.02;
+  Loads[ch].Harmonic3 = 0;
+  Loads[ch].CloseTime = 0;
+  Loads[ch].Closed = false;
+ }
+ UBus = SIMUBUSDEFAULT;
+ URail = 0;
+ NoiseState = 4711;
+}
+
+void SimPlant::SetLoad(unsigned ch, float Irms, float InrushFactor, float InrushTau)
+{
+ if (ch >= CHANNELCNT)
+  return;
+ Loads[ch].Irms = Irms;
+ Loads[ch].InrushFactor = InrushFactor < 1 ? 1 : InrushFactor;
+ Loads[ch].InrushTau = InrushTau;
+}
+
+void SimPlant::SetContact(unsigned ch, bool Closed, double t)
+{
+ if (ch >= CHANNELCNT)
+  return;
+ if (Closed && !Loads[ch].Closed)
+  Loads[ch].CloseTime = t;
+ Loads[ch].Closed = Closed;
+}
+
+void SimPlant::Step(double dt, double CoilPower)
+{
+ // Die Ladeschaltung liefert einen konstanten Strom, solange die Rail unter Ubus-Verlust liegt.
+ // Die Spulen werden über die PWM versorgt, der Rail wird also nur deren Leistung entnommen.
+ double Icharge = (URail < UBus - SIMRAILVOLTLOSS) ? SIMRAILCHARGECURR : 0;
+ double Iload = URail > 1 ? CoilPower / URail : 0;
+ URail += (Icharge - Iload) / SIMRAILCAPACITY * dt;
+ if (URail < 0)
+  URail = 0;
+}
+
+double SimPlant::Current(unsigned ch, double t)
+{
+ if ((ch >= CHANNELCNT) || !Loads[ch].Closed)
+  return 0;
+ double wt = 2 * M_PI * SIMMAINSFREQ * t;
+ double amp = Loads[ch].Irms * M_SQRT2;
+ double since = t - Loads[ch].CloseTime;
+ if ((Loads[ch].InrushFactor > 1) && (Loads[ch].InrushTau > 0))
+  amp *= 1 + (Loads[ch].InrushFactor - 1) * exp(-since / Loads[ch].InrushTau);
+ return amp * (sin(wt) + Loads[ch].Harmonic3 * sin(3 * wt));
+}
+
+int SimPlant::Noise(void)
+{
+ NoiseState = NoiseState * 1103515245 + 12345;
+ int r = (NoiseState >> 16) & 0x7fff;
+ return (int) ((r - 16384) * (2 * SIMADCNOISE) / 32768);
+}
+
+unsigned SimPlant::AdcSample(unsigned ChIdx, double t)
+{
+ double val;
+ if (ChIdx < IMEASMUXCHANNELS)
+ {
+  unsigned ch = ChIdx >> 1;
+  bool LowRange = (ChIdx & 1) != 0;
+  double range = LowRange ? MAXCURRLOWRANGE : MAXCURRHIGHRANGE;
+  double gainerr = LowRange ? SIMGAINERRLOW : SIMGAINERRHIGH;
+  val = SIMADCOFFSET + Current(ch, t) * 512 / range / gainerr + Noise();
+ } else {
+  switch (ChIdx - IMEASMUXCHANNELS)
+  {
+  case 0:
+   return SimVoltageToAdc(URail);
+  case 1:
+   return SimVoltageToAdc(UBus);
+  default:
+   val = 0; // Die Dummy-Wandlungen werden nicht ausgewertet
+  }
+ }
+ if (val < 0)
+  return 0;
+ if (val > 1023)
+  return 1023;
+ return (unsigned) (val + 0.5);
+}
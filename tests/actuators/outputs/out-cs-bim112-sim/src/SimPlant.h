@@ -0,0 +1,95 @@
+/*
+ *  SimPlant.h - Simulated loads, storage rail and ADC front end of the out-cs
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef SIMPLANT_H_
+#define SIMPLANT_H_
+
+#include <config.h>
+#include <AdcIsr.h>
+
+/*
+ * Die "Strecke" des Regelkreises: Lasten an den Relaiskontakten, der Messverstärker mit
+ * den beiden Messbereichen vor dem ADC sowie Bus- und Railspannung.
+ * Die Werte sind so gewählt, dass sie der Hardware des out-cs ungefähr entsprechen.
+ */
+#define SIMMAINSFREQ 50.0             // Netzfrequenz in Hz
+#define SIMADCOFFSET 511.6            // Nullpunkt des Messverstärkers in Digits
+#define SIMADCNOISE 1.0               // Rauschen in Digits (Spitze)
+#define SIMGAINERRHIGH 1.0125         // Verstärkungsfehler, den die Firmware mit GainCorr ausgleicht
+#define SIMGAINERRLOW 1.0275
+
+#define SIMUBUSDEFAULT 28.0           // Busspannung in V
+#define SIMRAILVOLTLOSS 3.5           // Spannungsverlust der Konstantstromladeschaltung in V
+#define SIMRAILCHARGECURR 0.008       // Ladestrom der Speicherkondensatoren in A
+#define SIMRAILCAPACITY 1000e-6       // Speicherkondensatoren in F
+#define SIMCOILVOLTAGE 12.0           // Die PWM hält die mittlere Spulenspannung bei 12V
+#define SIMCOILRESISTANCE 360.0       // Spulenwiderstand der bistabilen Relais in Ohm
+
+typedef struct
+{
+ float Irms;         // Effektivstrom bei geschlossenem Kontakt in A
+ float InrushFactor; // Einschaltstromspitze als Vielfaches des Nennstroms (1: keine)
+ float InrushTau;    // Abklingzeit des Einschaltstroms in s
+ float Harmonic3;    // Anteil der 3. Oberwelle (z.B. Schaltnetzteile)
+ double CloseTime;   // Zeitpunkt, zu dem der Kontakt zuletzt geschlossen wurde
+ bool Closed;
+} TSimLoad;
+
+class SimPlant;
+
+extern SimPlant simPlant;
+extern double simTime; // Simulationszeit in s
+
+class SimPlant
+{
+public:
+ SimPlant(void);
+
+ /*
+  * Setzt die Last eines Kanals. Wirksam wird sie, sobald (bzw. solange) der Kontakt geschlossen ist.
+  */
+ void SetLoad(unsigned ch, float Irms, float InrushFactor, float InrushTau);
+
+ /*
+  * Wird von der Relaisplatine bei jeder Kontaktänderung aufgerufen.
+  */
+ void SetContact(unsigned ch, bool Closed, double t);
+
+ /*
+  * Führt die Railspannung um dt nach. CoilPower ist die Leistung, die die bestromten
+  * Relaisspulen gerade der Rail entnehmen.
+  */
+ void Step(double dt, double CoilPower);
+
+ /*
+  * Liefert den ADC-Wert (0..1023) der Wandlung mit dem ISR-Index ChIdx (siehe AdcChCfg in AdcIsr.cpp):
+  * gerade Indizes High-Range, ungerade Low-Range, danach Rail- und Busspannung im Wechsel.
+  */
+ unsigned AdcSample(unsigned ChIdx, double t);
+
+ /*
+  * Momentanwert des Laststroms eines Kanals in A
+  */
+ double Current(unsigned ch, double t);
+
+ double UBus;  // Busspannung in V, vom Skript vorgegeben
+ double URail; // Spannung der Speicherkondensatoren in V
+
+protected:
+ TSimLoad Loads[CHANNELCNT];
+ unsigned NoiseState;
+
+ int Noise(void);
+};
+
+/*
+ * Umrechnung einer Spannung in den ADC-Wert, Spannungsteiler wie in config.h (MAXURAIL)
+ */
+unsigned SimVoltageToAdc(double U);
+
+#endif /* SIMPLANT_H_ */
@@ -0,0 +1,60 @@
+/*
+ *  SimRelSpi.cpp - Relay SPI functions on the simulated relay board
+ *
+ *  Ersetzt src/RelSpi.cpp in der Simulation. Die Schnittstelle ist dieselbe, die Bytes
+ *  gehen aber nicht in den SSP-FIFO, sondern in die Schieberegisterkette von SimRelayBoard.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <RelSpi.h>
+#include "SimRelayBoard.h"
+#include "SimPlant.h"
+
+RelSpi relspi;
+
+// Was beim letzten Transfer aus der Kette herausgeschoben wurde (MISO)
+static unsigned SimRxData[SPICHAINLEN+1];
+static int SimRxSize = 0;
+
+RelSpi::RelSpi(void)
+{
+ TxPtr = 0;
+ RxPtr = 0;
+ RxSize = 0;
+}
+
+int RelSpi::ReadRx(void)
+{
+ RxPtr = 0;
+ RxSize = SimRxSize;
+ for (int i = 0; i < RxSize; i++)
+  ChainDataRx[i] = SimRxData[i];
+ SimRxSize = 0;
+ return RxSize;
+}
+
+void RelSpi::GetRxData(unsigned* Data, unsigned size)
+{
+ while ((RxPtr < RxSize) && (size-- > 0))
+ {
+  *Data++ = ChainDataRx[RxPtr++];
+ }
+}
+
+void RelSpi::SetTxData(unsigned* Data, unsigned size)
+{
+ while ((TxPtr < SPICHAINLEN) && (size-- > 0))
+ {
+  ChainDataTx[TxPtr++] = *Data++;
+ }
+}
+
+void RelSpi::StartTransfer(void)
+{
+ simRelayBoard.Transfer(ChainDataTx, SimRxData, SPICHAINLEN, simTime);
+ SimRxSize = SPICHAINLEN;
+ TxPtr = 0;
+}
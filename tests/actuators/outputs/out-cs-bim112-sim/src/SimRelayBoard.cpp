@@ -0,0 +1,116 @@
+/*
+ *  SimRelayBoard.cpp - Simulated SPI shift register chain, relay coils and contacts
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include "SimRelayBoard.h"
+#include "SimPlant.h"
+
+#define SIMCHAINMASK ((SPICHAINLEN >= 4) ? 0xffffffffu : ((1u << (8*SPICHAINLEN)) - 1))
+
+SimRelayBoard::SimRelayBoard(void)
+{
+ ShiftReg = 0;
+ OutReg = 0;
+ LatchPending = false;
+ LatchTime = 0;
+ PulseCnt = 0;
+ WeakPulseCnt = 0;
+ IllegalPatternCnt = 0;
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  CoilTime[ch] = 0;
+  Contacts[ch] = false;
+ }
+}
+
+void SimRelayBoard::Transfer(const unsigned *Tx, unsigned *Rx, unsigned len, double t)
+{
+ for (unsigned i = 0; i < len; i++)
+ {
+  // Das zuerst gesendete Byte wandert ans Ende der Kette
+  Rx[i] = (ShiftReg >> (8*(SPICHAINLEN-1))) & 0xff;
+  ShiftReg = ((ShiftReg << 8) | (Tx[i] & 0xff)) & SIMCHAINMASK;
+ }
+ LatchPending = true;
+ LatchTime = t + len * 8 / SIMSPICLOCK;
+}
+
+unsigned SimRelayBoard::DriverData(void)
+{
+ return OutReg & ((1u << (2*CHANNELCNT)) - 1);
+}
+
+bool SimRelayBoard::Contact(unsigned ch)
+{
+ return (ch < CHANNELCNT) && Contacts[ch];
+}
+
+double SimRelayBoard::CoilPower(double URail)
+{
+ unsigned Coils = 0;
+ unsigned data = DriverData();
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  unsigned pattern = (data >> (2*ch)) & 3;
+  if (pattern == RELAYPATTERNON || pattern == RELAYPATTERNOFF)
+   Coils++;
+ }
+ double Ucoil = URail < SIMCOILVOLTAGE ? URail : SIMCOILVOLTAGE;
+ return Coils * Ucoil * Ucoil / SIMCOILRESISTANCE;
+}
+
+unsigned SimRelayBoard::Step(double t, double dt, double URail)
+{
+ unsigned Changed = 0;
+ if (LatchPending && (t >= LatchTime))
+ {
+  unsigned Old = DriverData();
+  LatchPending = false;
+  OutReg = ShiftReg;
+  unsigned New = DriverData();
+  for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+  {
+   unsigned OldPattern = (Old >> (2*ch)) & 3;
+   unsigned NewPattern = (New >> (2*ch)) & 3;
+   if (NewPattern == 3)
+    IllegalPatternCnt++;
+   if (OldPattern != NewPattern)
+   {
+    // Ende eines Pulses, der den Kontakt nicht bewegt hat
+    if ((OldPattern == RELAYPATTERNON || OldPattern == RELAYPATTERNOFF) && (CoilTime[ch] >= 0))
+     WeakPulseCnt++;
+    if (NewPattern == RELAYPATTERNON || NewPattern == RELAYPATTERNOFF)
+     PulseCnt++;
+    CoilTime[ch] = 0;
+   }
+  }
+ }
+
+ double Ucoil = URail < SIMCOILVOLTAGE ? URail : SIMCOILVOLTAGE;
+ unsigned data = DriverData();
+ for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+ {
+  unsigned pattern = (data >> (2*ch)) & 3;
+  if ((pattern != RELAYPATTERNON) && (pattern != RELAYPATTERNOFF))
+   continue;
+  if (CoilTime[ch] < 0) // Kontakt in diesem Puls schon umgeschlagen
+   continue;
+  if (Ucoil >= SIMRELAYOPERATEVOLT)
+   CoilTime[ch] += dt;
+  if (CoilTime[ch] >= SIMRELAYOPERATETIME)
+  {
+   bool NewState = (pattern == RELAYPATTERNON);
+   if (Contacts[ch] != NewState)
+   {
+    Contacts[ch] = NewState;
+    Changed |= 1 << ch;
+   }
+   CoilTime[ch] = -1;
+  }
+ }
+ return Changed;
+}
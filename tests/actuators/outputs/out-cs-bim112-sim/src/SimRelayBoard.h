@@ -0,0 +1,66 @@
+/*
+ *  SimRelayBoard.h - Simulated SPI shift register chain, relay coils and contacts
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef SIMRELAYBOARD_H_
+#define SIMRELAYBOARD_H_
+
+#include <config.h>
+
+/*
+ * Die Relaistreiber hängen als Schieberegisterkette am SPI. Die Bytes werden mit SCK
+ * hineingeschoben, mit dem Ende des Chipselects übernommen, erst dann liegen die
+ * Ansteuermuster an den Spulen. Die bistabilen Relais kippen, wenn die Spule lange genug
+ * mit ausreichender Spannung bestromt wurde.
+ */
+#define SIMSPICLOCK 100000.0          // SCK in Hz, siehe RelSpi::RelSpi()
+#define SIMRELAYOPERATEVOLT 8.4       // Mindestspannung an der Spule (70% von 12V)
+#define SIMRELAYOPERATETIME 0.006     // Ansprechzeit bis zum Umschlagen des Kontakts in s
+
+class SimRelayBoard;
+
+extern SimRelayBoard simRelayBoard;
+
+class SimRelayBoard
+{
+public:
+ SimRelayBoard(void);
+
+ /*
+  * Schiebt "len" Bytes zum Zeitpunkt t in die Kette. Die herausgeschobenen Bytes landen in Rx
+  * (MISO). Die Übernahme in die Ausgangsregister erfolgt, wenn alle Bits übertragen sind.
+  */
+ void Transfer(const unsigned *Tx, unsigned *Rx, unsigned len, double t);
+
+ /*
+  * Führt Latch, Spulen und Kontakte bis zum Zeitpunkt t nach. Rückgabe: Bitmaske der Kanäle,
+  * deren Kontakt sich in diesem Schritt geändert hat.
+  */
+ unsigned Step(double t, double dt, double URail);
+
+ /*
+  * Leistung, die die gerade bestromten Spulen der Rail entnehmen, in W
+  */
+ double CoilPower(double URail);
+
+ bool Contact(unsigned ch);
+
+ unsigned DriverData(void);  // Die an den Spulentreibern anliegenden Muster, 2 Bit je Kanal
+ unsigned PulseCnt;          // Anzahl Spulenpulse insgesamt
+ unsigned WeakPulseCnt;      // Pulse, die wegen zu geringer Spulenspannung nicht geschaltet haben
+ unsigned IllegalPatternCnt; // Beide Spulen eines Kanals gleichzeitig bestromt
+
+protected:
+ unsigned ShiftReg;
+ unsigned OutReg;
+ bool LatchPending;
+ double LatchTime;
+ double CoilTime[CHANNELCNT]; // Bisherige wirksame Bestromungsdauer der aktiven Spule
+ bool Contacts[CHANNELCNT];
+};
+
+#endif /* SIMRELAYBOARD_H_ */
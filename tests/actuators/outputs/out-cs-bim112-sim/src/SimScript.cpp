@@ -0,0 +1,128 @@
+/*
+ *  SimScript.cpp - Stimulus script of the closed-loop simulation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <string.h>
+#include <config.h>
+#include <com_objs.h>
+#include "SimScript.h"
+
+SimScript::SimScript(void)
+{
+ EventCnt = 0;
+ ReadIdx = 0;
+}
+
+// Kanal eines Kommunikationsobjekts, CHANNELCNT für die allgemeinen Objekte
+static unsigned ObjChannel(unsigned ObjNo)
+{
+ if (ObjNo < OFSCHANNELOBJECTS)
+  return CHANNELCNT;
+ unsigned ch = (ObjNo - OFSCHANNELOBJECTS) / SPACINGCHANNELOBJECTS;
+ return ch < CHANNELCNT ? ch : CHANNELCNT;
+}
+
+bool SimScript::Load(const char *filename, FILE *err)
+{
+ FILE *f = fopen(filename, "r");
+ if (!f)
+ {
+  fprintf(err, "%s: cannot open\n", filename);
+  return false;
+ }
+ char line[256];
+ unsigned LineNo = 0;
+ unsigned LastTime = 0;
+ bool Ok = true;
+ EventCnt = 0;
+ ReadIdx = 0;
+ while (Ok && fgets(line, sizeof(line), f))
+ {
+  LineNo++;
+  char *comment = strchr(line, '#');
+  if (comment)
+   *comment = 0;
+  char cmd[16];
+  unsigned time;
+  int pos;
+  if (sscanf(line, "%u %15s %n", &time, cmd, &pos) < 2)
+  {
+   if (strspn(line, " \t\r\n") != strlen(line))
+   {
+    fprintf(err, "%s:%u: syntax error\n", filename, LineNo);
+    Ok = false;
+   }
+   continue;
+  }
+  if ((time < LastTime) || (EventCnt >= SIMMAXEVENTS))
+  {
+   fprintf(err, "%s:%u: events must be in ascending order, at most %u\n", filename, LineNo, SIMMAXEVENTS);
+   Ok = false;
+   break;
+  }
+  LastTime = time;
+  TSimEvent &ev = Events[EventCnt];
+  memset(&ev, 0, sizeof(ev));
+  ev.Time = time;
+  const char *args = line + pos;
+  int n;
+  if (strcmp(cmd, "tel") == 0)
+  {
+   ev.Cmd = SimCmd::Telegram;
+   n = sscanf(args, "%u %u", &ev.ObjNo, &ev.Value);
+   Ok = (n == 2);
+   ev.Ch = ObjChannel(ev.ObjNo);
+  } else if (strcmp(cmd, "switch") == 0)
+  {
+   ev.Cmd = SimCmd::Telegram;
+   n = sscanf(args, "%u %u", &ev.Ch, &ev.Value);
+   Ok = (n == 2) && (ev.Ch < CHANNELCNT);
+   ev.ObjNo = OFSCHANNELOBJECTS + ev.Ch*SPACINGCHANNELOBJECTS + OBJ_SWITCH;
+  } else if (strcmp(cmd, "load") == 0)
+  {
+   ev.Cmd = SimCmd::Load;
+   ev.Val[1] = 1;
+   ev.Val[2] = 20;
+   n = sscanf(args, "%u %f %f %f", &ev.Ch, &ev.Val[0], &ev.Val[1], &ev.Val[2]);
+   Ok = (n >= 2) && (ev.Ch < CHANNELCNT);
+  } else if (strcmp(cmd, "ubus") == 0)
+  {
+   ev.Cmd = SimCmd::BusVoltage;
+   Ok = sscanf(args, "%f", &ev.Val[0]) == 1;
+  } else if (strcmp(cmd, "end") == 0)
+  {
+   ev.Cmd = SimCmd::End;
+  } else {
+   Ok = false;
+  }
+  if (!Ok)
+   fprintf(err, "%s:%u: invalid event \"%s\"\n", filename, LineNo, cmd);
+  else
+   EventCnt++;
+ }
+ fclose(f);
+ return Ok;
+}
+
+bool SimScript::NextDue(unsigned time, TSimEvent &ev)
+{
+ if ((ReadIdx >= EventCnt) || (Events[ReadIdx].Time > time))
+  return false;
+ ev = Events[ReadIdx++];
+ return true;
+}
+
+unsigned SimScript::EndTime(void)
+{
+ for (unsigned i = 0; i < EventCnt; i++)
+ {
+  if (Events[i].Cmd == SimCmd::End)
+   return Events[i].Time;
+ }
+ // Ohne "end" läuft die Simulation noch 2s nach dem letzten Ereignis
+ return EventCnt ? Events[EventCnt-1].Time + 2000 : 2000;
+}
@@ -0,0 +1,66 @@
+/*
+ *  SimScript.h - Stimulus script of the closed-loop simulation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#ifndef SIMSCRIPT_H_
+#define SIMSCRIPT_H_
+
+#include <stdio.h>
+
+/*
+ * Ein Skript ist eine Textdatei mit einem Ereignis je Zeile, aufsteigend nach Zeit:
+ *   <ms> tel <objno> <wert>          Telegramm auf ein Kommunikationsobjekt
+ *   <ms> switch <kanal> <0|1>        Telegramm auf das Schaltobjekt eines Kanals (Kanal ab 0)
+ *   <ms> load <kanal> <A> [<faktor> [<tau ms>]]  Last am Kontakt, optional mit Einschaltstrom
+ *   <ms> ubus <V>                    Busspannung
+ *   <ms> end                         Ende der Simulation
+ * Alles ab '#' ist Kommentar.
+ */
+#define SIMMAXEVENTS 1024
+
+enum class SimCmd
+{
+ Telegram,
+ Load,
+ BusVoltage,
+ End
+};
+
+typedef struct
+{
+ unsigned Time;  // ms
+ SimCmd Cmd;
+ unsigned ObjNo; // Telegram
+ unsigned Value; // Telegram
+ unsigned Ch;    // Load; bei Telegram der Kanal des Objekts oder CHANNELCNT für allgemeine Objekte
+ float Val[3];   // Load: Strom, Einschaltfaktor, Tau; BusVoltage: Spannung
+} TSimEvent;
+
+class SimScript
+{
+public:
+ SimScript(void);
+
+ /*
+  * Liest ein Skript, Fehler werden mit Zeilennummer nach "err" ausgegeben.
+  */
+ bool Load(const char *filename, FILE *err);
+
+ /*
+  * Liefert das nächste Ereignis, das bis zum Zeitpunkt "time" fällig ist.
+  */
+ bool NextDue(unsigned time, TSimEvent &ev);
+
+ unsigned EndTime(void);
+
+protected:
+ TSimEvent Events[SIMMAXEVENTS];
+ unsigned EventCnt;
+ unsigned ReadIdx;
+};
+
+#endif /* SIMSCRIPT_H_ */
@@ -0,0 +1,223 @@
+/*
+ *  sim_main.cpp - Closed-loop simulation of the out-cs current and relay stack
+ *
+ *  Die Firmware (ADC-ISR, Relay, Appl, app_main) läuft unverändert auf dem Host gegen
+ *  die Modelle in SimPlant und SimRelayBoard. Die Zeitbasis ist die ADC-Abtastung:
+ *  je Abtastung werden Strecke und Relaisplatine nachgeführt und ADC_IRQHandler() aufgerufen,
+ *  nach jedem vollständigen ADC-Zyklus läuft einmal die Hauptschleife, jede Millisekunde
+ *  wird systemTime erhöht.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sblib/platform.h>
+#include <config.h>
+#include <com_objs.h>
+#include <AdcIsr.h>
+#include <Appl.h>
+#include <app_main.h>
+#include "SimPlant.h"
+#include "SimRelayBoard.h"
+#include "SimScript.h"
+#include "SimMetrics.h"
+
+#ifdef HW_2CH_WO_CS
+#error The relays of this hardware are driven by GPIOs, the simulation only models the SPI relay drivers
+#endif
+
+#define SIMSAMPLESPERMS (ADCSAMPLEFREQ/1000)
+#define SIMSAMPLEPERIOD (1.0/ADCSAMPLEFREQ)
+
+extern volatile unsigned int systemTime;
+extern "C" void ADC_IRQHandler(void);
+BcuBase* setup();
+void loop();
+void loop_noapp();
+extern unsigned simJournalCommits; // SimJournal.cpp
+
+SimPlant simPlant;
+SimRelayBoard simRelayBoard;
+double simTime = 0;
+
+static SimScript script;
+static SimMetrics metrics;
+static unsigned ThresholdState[CHANNELCNT];
+
+static double HostTime(void)
+{
+ struct timespec ts;
+ clock_gettime(CLOCK_MONOTONIC, &ts);
+ return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Ein mit der ETS erzeugtes Abbild des Konfigurationsspeichers, Rohdaten ab Adresse StartAddr
+static bool LoadEeprom(const char *filename, unsigned StartAddr)
+{
+ FILE *f = fopen(filename, "rb");
+ if (!f)
+ {
+  fprintf(stderr, "%s: cannot open\n", filename);
+  return false;
+ }
+ unsigned addr = StartAddr;
+ int val;
+ while ((val = fgetc(f)) != EOF)
+ {
+  if (addr < bcu.userEeprom->endAddr())
+   (*bcu.userEeprom)[addr] = val;
+  else
+   memMapper.writeMem(addr, val); // Die Parameter jenseits des User-EEPROMs, siehe app_main.cpp
+  addr++;
+ }
+ fclose(f);
+ return true;
+}
+
+static unsigned ReadThresholds(unsigned ch)
+{
+ unsigned ObjBase = OFSCHANNELOBJECTS + ch*SPACINGCHANNELOBJECTS;
+ return bcu.comObjects->objectRead(ObjBase + OBJ_STATECTH1) |
+   (bcu.comObjects->objectRead(ObjBase + OBJ_STATECTH2) << 1);
+}
+
+static bool ApplyEvent(const TSimEvent &ev)
+{
+ switch (ev.Cmd)
+ {
+ case SimCmd::Telegram:
+  bcu.comObjects->objectUpdate(ev.ObjNo, ev.Value);
+  metrics.Telegram(ev.Ch, simTime);
+  break;
+ case SimCmd::Load:
+  simPlant.SetLoad(ev.Ch, ev.Val[0], ev.Val[1], ev.Val[2] / 1000);
+  if (simRelayBoard.Contact(ev.Ch)) // Ohne geschlossenen Kontakt ändert sich der Strom nicht
+  {
+   ThresholdState[ev.Ch] = ReadThresholds(ev.Ch);
+   metrics.LoadStep(ev.Ch, simTime);
+  }
+  break;
+ case SimCmd::BusVoltage:
+  simPlant.UBus = ev.Val[0];
+  break;
+ case SimCmd::End:
+  return false;
+ }
+ return true;
+}
+
+static void usage(const char *name)
+{
+ fprintf(stderr, "usage: %s [-e eeprom.bin] [-a address] [-k factor] script\n"
+   "  -e  image of the configuration memory written by the ETS\n"
+   "  -a  address of the first byte of the image (default 0x%x)\n"
+   "  -k  host to target factor for the CPU figures (default 1)\n", name, APP_STARTADDR);
+}
+
+int main(int argc, char **argv)
+{
+ const char *EepromFile = NULL;
+ unsigned EepromAddr = APP_STARTADDR;
+ double CpuScale = 1;
+ int opt;
+ while ((opt = getopt(argc, argv, "e:a:k:")) != -1)
+ {
+  switch (opt)
+  {
+  case 'e':
+   EepromFile = optarg;
+   break;
+  case 'a':
+   EepromAddr = strtoul(optarg, NULL, 0);
+   break;
+  case 'k':
+   CpuScale = atof(optarg);
+   break;
+  default:
+   usage(argv[0]);
+   return 2;
+  }
+ }
+ if (optind != argc-1)
+ {
+  usage(argv[0]);
+  return 2;
+ }
+ if (!script.Load(argv[optind], stderr))
+  return 1;
+
+ systemTime = 0;
+ setup();
+ // Erst nach bcu.begin(), sonst überschreibt die BCU den Speicher mit dem Inhalt des Flashs
+ if (EepromFile && !LoadEeprom(EepromFile, EepromAddr))
+  return 1;
+
+ unsigned EndTime = script.EndTime();
+ bool Running = true;
+ for (unsigned ms = 0; Running && (ms < EndTime); ms++)
+ {
+  simTime = ms * 0.001;
+  TSimEvent ev;
+  while (Running && script.NextDue(ms, ev))
+   Running = ApplyEvent(ev);
+
+  double IsrTime = 0;
+  double LoopTime = 0;
+  for (unsigned s = 0; s < SIMSAMPLESPERMS; s++)
+  {
+   simTime = ms * 0.001 + s * SIMSAMPLEPERIOD;
+   simPlant.Step(SIMSAMPLEPERIOD, simRelayBoard.CoilPower(simPlant.URail));
+   unsigned Changed = simRelayBoard.Step(simTime, SIMSAMPLEPERIOD, simPlant.URail);
+   for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+   {
+    if (Changed & (1 << ch))
+    {
+     simPlant.SetContact(ch, simRelayBoard.Contact(ch), simTime);
+     metrics.ContactChanged(ch, simTime);
+    }
+   }
+
+   unsigned AdcVal = simPlant.AdcSample(IsrData.ActChIdx, simTime);
+   for (unsigned i = 0; i < 8; i++)
+    LPC_ADC->DR[i] = (AdcVal << 6) | 0x80000000;
+   double t0 = HostTime();
+   ADC_IRQHandler();
+   IsrTime += HostTime() - t0;
+
+   if (IsrData.ActChIdx == 0) // Ein ADC-Zyklus ist komplett
+   {
+    t0 = HostTime();
+    bcu.loop();
+    if (bcu.applicationRunning())
+     loop();
+    else
+     loop_noapp();
+    LoopTime += HostTime() - t0;
+   }
+  }
+  systemTime++;
+
+  for (unsigned ch = 0; ch < CHANNELCNT; ch++)
+  {
+   unsigned State = ReadThresholds(ch);
+   if (State != ThresholdState[ch])
+   {
+    ThresholdState[ch] = State;
+    metrics.ThresholdChanged(ch, simTime);
+   }
+  }
+  metrics.Tick(IsrTime, LoopTime, SIMSAMPLESPERMS);
+ }
+
+ printf("Simulated %.3fs, rail %.1fV, %u coil pulses (%u without effect, %u illegal patterns), %u state records\n",
+   simTime, simPlant.URail, simRelayBoard.PulseCnt, simRelayBoard.WeakPulseCnt, simRelayBoard.IllegalPatternCnt,
+   simJournalCommits);
+ metrics.Report(stdout, CpuScale);
+ return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ *  energy.cpp - Tests of the energy meter with synthetic load profiles
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <math.h>
+#include <EnergyMeter.h>
+
+#define GAIN_1 32768
+
+// Eine Last mit dem Effektivstrom Irms (A) erzeugt über eine Messperiode diese Quadratsumme
+static unsigned sumSqrForCurrent(double Irms, bool LowRange)
+{
+    double digitsRms = Irms / ((LowRange ? MAXCURRLOWRANGE : MAXCURRHIGHRANGE) / 512);
+    return (unsigned) (digitsRms * digitsRms * BUFSIZE + 0.5);
+}
+
+// Referenz: Gleitkommarechnung wie in AdcIsrCurrFilt()
+static double refPowerVA(unsigned SumSqr, unsigned GainCorr, bool LowRange)
+{
+    double I = sqrt((double) SumSqr / BUFSIZE) * GainCorr / 32768
+        * (LowRange ? MAXCURRLOWRANGE : MAXCURRHIGHRANGE) / 512;
+    return I * 1000 < ENERGYMINCURRENT ? 0 : I * ENERGYMAINSVOLTAGE;
+}
+
+static void runLoad(EnergyMeter & meter, unsigned ch, double Irms, bool LowRange, unsigned seconds, double & refWs)
+{
+    unsigned sumSqr = sumSqrForCurrent(Irms, LowRange);
+    for (unsigned i = 0; i < seconds * RMSCURRENTVALUESPERSECOND; i++)
+    {
+        meter.ProcessMeasPeriod(ch, sumSqr, GAIN_1, LowRange);
+        refWs += refPowerVA(sumSqr, GAIN_1, LowRange) / RMSCURRENTVALUESPERSECOND;
+    }
+}
+
+TEST_CASE("Energy meter constant loads", "[ENERGY]")
+{
+    EnergyMeter meter;
+    double ref0 = 0, ref1 = 0;
+
+    SECTION("Resistive load 1A in the low range for one hour")
+    {
+        runLoad(meter, 0, 1.0, true, 3600, ref0);
+        REQUIRE(meter.GetApparentPower(0) == 230);
+        REQUIRE(meter.GetOperatingHours(0) == 1);
+        REQUIRE(fabs(meter.GetEnergyWh(0) - ref0 / 3600) <= 1);
+        REQUIRE(fabs(meter.GetEnergyWh(0) - 230.0) <= 1);
+    }
+
+    SECTION("Heavy load 10A in the high range for half an hour")
+    {
+        runLoad(meter, 1, 10.0, false, 1800, ref1);
+        REQUIRE(fabs(meter.GetApparentPower(1) - 2300.0) <= 3);
+        REQUIRE(meter.GetOperatingHours(1) == 0);
+        REQUIRE(fabs(meter.GetEnergyWh(1) - ref1 / 3600) <= 1);
+        REQUIRE(fabs(meter.GetEnergyWh(1) - 1150.0) <= 2);
+        REQUIRE(meter.GetEnergyWh(0) == 0);
+    }
+
+    SECTION("Noise below the threshold is ignored")
+    {
+        runLoad(meter, CHANNELCNT - 1, 0.005, true, 3600, ref0);
+        REQUIRE(meter.GetEnergyWh(CHANNELCNT - 1) == 0);
+        REQUIRE(meter.GetApparentPower(CHANNELCNT - 1) == 0);
+        REQUIRE(meter.GetOperatingHours(CHANNELCNT - 1) == 0);
+    }
+
+    SECTION("Channels beyond CHANNELCNT are ignored")
+    {
+        runLoad(meter, CHANNELCNT, 1.0, true, 3600, ref0);
+        for (int ch = 0; ch < CHANNELCNT; ch++)
+        {
+            REQUIRE(meter.GetEnergyWh(ch) == 0);
+            REQUIRE(meter.GetOperatingHours(ch) == 0);
+        }
+    }
+
+    SECTION("Reset of one channel")
+    {
+        runLoad(meter, 0, 1.0, true, 3600, ref0);
+        runLoad(meter, 1, 1.0, true, 3600, ref1);
+        meter.ResetChannel(0);
+        REQUIRE(meter.GetEnergyWh(0) == 0);
+        REQUIRE(meter.GetApparentPower(0) == 0);
+        REQUIRE(meter.GetApparentPower(1) == 230);
+        REQUIRE(meter.GetOperatingHours(0) == 0);
+        REQUIRE(meter.GetEnergyWh(1) == 230);
+        REQUIRE(meter.GetOperatingHours(1) == 1);
+    }
+}
+
+TEST_CASE("Energy meter varying load profile", "[ENERGY]")
+{
+    EnergyMeter meter;
+    double ref = 0;
+    // Ein Tag mit wechselnder Last: Bereichsumschaltung, Gain-Korrektur, Pausen
+    for (unsigned hour = 0; hour < 24; hour++)
+    {
+        runLoad(meter, 0, 0.3 + 0.05 * hour, true, 1200, ref);
+        runLoad(meter, 0, 0.0, true, 1200, ref);
+        REQUIRE(meter.GetApparentPower(0) == 0); // Pause ohne Laststrom
+        unsigned sumSqr = sumSqrForCurrent(6.0 + hour * 0.25, false);
+        for (unsigned i = 0; i < 1200 * RMSCURRENTVALUESPERSECOND; i++)
+        {
+            meter.ProcessMeasPeriod(0, sumSqr, 33500, false);
+            ref += refPowerVA(sumSqr, 33500, false) / RMSCURRENTVALUESPERSECOND;
+        }
+    }
+    // Festkomma gegen Gleitkomma: Abweichung unter 0,1%
+    REQUIRE(fabs(meter.GetEnergyWh(0) - ref / 3600) <= ref / 3600 * 0.001 + 1);
+    REQUIRE(meter.GetOperatingHours(0) == 16);
+}
+
+TEST_CASE("Energy meter storage", "[ENERGY]")
+{
+    EnergyMeter meter;
+    byte page[256];
+    double ref = 0;
+
+    runLoad(meter, 0, 2.0, false, 7200, ref);
+    runLoad(meter, CHANNELCNT - 1, 0.5, true, 3600, ref);
+    REQUIRE(meter.GetData(page) == ENERGYDATALEN);
+
+    EnergyMeter recalled;
+    REQUIRE(recalled.SetData(page) == ENERGYDATALEN);
+    for (int ch = 0; ch < CHANNELCNT; ch++)
+    {
+        REQUIRE(recalled.GetEnergyWh(ch) == meter.GetEnergyWh(ch));
+        REQUIRE(recalled.GetOperatingHours(ch) == meter.GetOperatingHours(ch));
+    }
+    REQUIRE(recalled.GetEnergyWh(0) == 920);
+    REQUIRE(recalled.GetOperatingHours(0) == 2);
+
+    // Leere Flashseite: alle Zähler starten bei 0
+    for (unsigned i = 0; i < sizeof(page); i++)
+        page[i] = 0xff;
+    recalled.SetData(page);
+    REQUIRE(recalled.GetEnergyWh(0) == 0);
+    REQUIRE(recalled.GetOperatingHours(0) == 0);
+}
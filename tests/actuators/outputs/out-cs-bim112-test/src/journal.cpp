@@ -0,0 +1,159 @@
+/*
+ *  journal.cpp - Tests of the state journal with power cycles and torn writes
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <string.h>
+#include <StateJournal.h>
+
+// Flash im RAM: Löschen setzt 0xFF, Programmieren kann nur Bits löschen.
+// Schreib- und Löschvorgänge lassen sich nach einer Anzahl Bytes abbrechen (Spannungsausfall).
+class RamJournal : public StateJournal
+{
+public:
+    byte flash[JOURNALSECTORCNT * JOURNALSECTORSIZE];
+    unsigned eraseCnt[JOURNALSECTORCNT];
+    unsigned programCnt;
+    int tornProgram;
+    int tornErase;
+
+    RamJournal()
+    {
+        memset(flash, 0xff, sizeof(flash));
+        memset(eraseCnt, 0, sizeof(eraseCnt));
+        programCnt = 0;
+        tornProgram = -1;
+        tornErase = -1;
+    }
+
+protected:
+    virtual bool EraseSector(unsigned SectorIdx)
+    {
+        unsigned len = JOURNALSECTORSIZE;
+        if (tornErase >= 0)
+            len = tornErase;
+        memset(flash + SectorIdx * JOURNALSECTORSIZE, 0xff, len);
+        eraseCnt[SectorIdx]++;
+        return len == JOURNALSECTORSIZE;
+    }
+
+    virtual bool ProgramSlot(unsigned SlotIdx, const byte *data)
+    {
+        unsigned len = JOURNALSLOTSIZE;
+        if (tornProgram >= 0)
+            len = tornProgram;
+        for (unsigned i = 0; i < len; i++)
+            flash[SlotIdx * JOURNALSLOTSIZE + i] &= data[i];
+        programCnt++;
+        return len == JOURNALSLOTSIZE;
+    }
+
+    virtual const byte* SlotPtr(unsigned SlotIdx)
+    {
+        return flash + SlotIdx * JOURNALSLOTSIZE;
+    }
+};
+
+static unsigned rndState = 12345;
+static unsigned rnd(void)
+{
+    rndState = rndState * 1103515245 + 12345;
+    return (rndState >> 16) & 0x7fff;
+}
+
+static void fillPayload(byte * data)
+{
+    data[0] = 1 + rnd() % 250; // Speichergrund, nie 0 oder 0xFF
+    for (unsigned i = 1; i < JOURNALPAYLOADLEN; i++)
+        data[i] = rnd();
+}
+
+TEST_CASE("Journal starts empty", "[JOURNAL]")
+{
+    RamJournal j;
+    j.Init();
+    REQUIRE(j.Buffer()[0] == 0xff);
+    j.PrepareNextSlot();
+    REQUIRE(j.eraseCnt[0] == 0); // Der Sektor ist schon leer
+}
+
+TEST_CASE("Journal keeps the newest record", "[JOURNAL]")
+{
+    RamJournal j;
+    byte payload[JOURNALPAYLOADLEN];
+    j.Init();
+    for (unsigned i = 0; i < 3 * JOURNALSLOTCNT; i++)
+    {
+        fillPayload(payload);
+        memcpy(j.Buffer(), payload, JOURNALPAYLOADLEN);
+        REQUIRE(j.Commit(JOURNALPAYLOADLEN));
+        // Der Puffer enthält weiterhin die gespeicherten Daten
+        REQUIRE(memcmp(j.Buffer(), payload, JOURNALPAYLOADLEN) == 0);
+        j.Init();
+        REQUIRE(memcmp(j.Buffer(), payload, JOURNALPAYLOADLEN) == 0);
+    }
+    REQUIRE(j.programCnt == 3 * JOURNALSLOTCNT);
+}
+
+TEST_CASE("Journal survives thousands of power cycles with torn writes", "[JOURNAL]")
+{
+    RamJournal j;
+    byte payload[JOURNALPAYLOADLEN];
+    byte lastGood[JOURNALPAYLOADLEN];
+    bool haveGood = false;
+    unsigned commits = 0;
+
+    for (unsigned cycle = 0; cycle < 5000; cycle++)
+    {
+        // Systemstart: Daten wiederherstellen
+        j.tornProgram = -1;
+        j.tornErase = -1;
+        j.Init();
+        if (haveGood)
+            REQUIRE(memcmp(j.Buffer(), lastGood, JOURNALPAYLOADLEN) == 0);
+        else
+            REQUIRE(j.Buffer()[0] == 0xff);
+
+        // Vorbereitung bei ausreichender Busspannung, gelegentlich mit Spannungsausfall beim Löschen
+        if ((rnd() % 16) == 0)
+        {
+            j.tornErase = rnd() % JOURNALSECTORSIZE;
+            j.PrepareNextSlot();
+            continue;
+        }
+        j.PrepareNextSlot();
+
+        // Busspannungsausfall: Zustand speichern, gelegentlich abgebrochen
+        fillPayload(payload);
+        memcpy(j.Buffer(), payload, JOURNALPAYLOADLEN);
+        bool torn = (rnd() % 8) == 0;
+        if (torn)
+            j.tornProgram = rnd() % JOURNALSLOTSIZE;
+        unsigned erasesBefore = j.eraseCnt[0] + j.eraseCnt[1];
+        j.Commit(JOURNALPAYLOADLEN);
+        commits++;
+        // Im Spannungsausfall wird nie gelöscht
+        REQUIRE(j.eraseCnt[0] + j.eraseCnt[1] == erasesBefore);
+        // Ist die CRC noch geschrieben worden, ist der Datensatz vollständig
+        if (!torn || (j.tornProgram > JOURNALHEADERLEN + JOURNALPAYLOADLEN))
+        {
+            memcpy(lastGood, payload, JOURNALPAYLOADLEN);
+            haveGood = true;
+        }
+    }
+    REQUIRE(haveGood);
+
+    // Gleichmäßiger Verschleiß: jede Sektorlöschung nimmt JOURNALSLOTSPERSECTOR Datensätze auf
+    unsigned erases = 0;
+    for (unsigned s = 0; s < JOURNALSECTORCNT; s++)
+        erases += j.eraseCnt[s];
+    REQUIRE(erases <= commits / JOURNALSLOTSPERSECTOR * 2);
+    for (unsigned s = 1; s < JOURNALSECTORCNT; s++)
+    {
+        int diff = (int) j.eraseCnt[s] - (int) j.eraseCnt[0];
+        REQUIRE(abs(diff) <= (int) (erases / 10 + 2));
+    }
+}
@@ -0,0 +1,10 @@
+/*
+ *  Copyright (c) 2014 Martin Glück <martin@mangari.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
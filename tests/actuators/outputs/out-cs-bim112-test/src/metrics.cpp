@@ -0,0 +1,54 @@
+/*
+ *  metrics.cpp - Tests of the latency figures of the closed-loop simulation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <SimMetrics.h>
+
+TEST_CASE("Telegram to contact latency", "[METRICS]")
+{
+    SimMetrics metrics;
+
+    SECTION("Contact change after a telegram")
+    {
+        metrics.Telegram(0, 5.000);
+        metrics.ContactChanged(0, 5.030);
+        REQUIRE(metrics.ContactLatency[0].Count == 1);
+        REQUIRE(metrics.ContactLatency[0].Max == Approx(0.030));
+        REQUIRE(metrics.UnsolicitedChanges == 0);
+        REQUIRE(metrics.IneffectiveTelegrams == 0);
+    }
+
+    SECTION("Telegram without contact change")
+    {
+        // Einschalten eines bereits geschlossenen Kontakts, später schaltet eine Zeitfunktion
+        metrics.Telegram(0, 5.000);
+        metrics.ContactChanged(0, 65.000);
+        REQUIRE(metrics.ContactLatency[0].Count == 0);
+        REQUIRE(metrics.UnsolicitedChanges == 1);
+        REQUIRE(metrics.IneffectiveTelegrams == 1);
+    }
+
+    SECTION("Telegram without contact change followed by one with")
+    {
+        metrics.Telegram(0, 5.000);
+        metrics.Telegram(0, 5.500);
+        metrics.ContactChanged(0, 5.520);
+        REQUIRE(metrics.ContactLatency[0].Count == 1);
+        REQUIRE(metrics.ContactLatency[0].Max == Approx(0.020));
+        REQUIRE(metrics.IneffectiveTelegrams == 1);
+    }
+
+    SECTION("General objects concern all channels")
+    {
+        metrics.Telegram(CHANNELCNT, 5.000);
+        metrics.ContactChanged(CHANNELCNT - 1, 5.040);
+        metrics.ContactChanged(0, 7.000);
+        REQUIRE(metrics.ContactLatency[CHANNELCNT - 1].Count == 1);
+        REQUIRE(metrics.ContactLatency[0].Count == 0);
+        REQUIRE(metrics.UnsolicitedChanges == 1);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ *  bistable.cpp - Tests of the coil pulses of the bistable relays
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include "sblib/digital_pin.h"
+#include "outputsBiStable.h"
+
+#define SET_COIL(ch)   (1 << ((ch) * 2))
+#define RESET_COIL(ch) (1 << ((ch) * 2 + 1))
+
+// the set and the reset coil of 4 channels on the 8 output pins
+class PulseSequencer : public OutputsBiStable
+{
+public:
+    PulseSequencer()
+    {
+        setupOutputs(outputPins, 8);
+    }
+
+    void request(unsigned int channel, unsigned int value)
+    {
+        switchOutput(channel, value);
+    }
+};
+
+static unsigned int coils(void)
+{
+    unsigned int result = 0;
+    for (int i = 0; i < 8; i++)
+        result |= digitalRead(outputPins[i]) << i;
+    return result;
+}
+
+TEST_CASE("Coil pulses of the bistable relays", "[BISTABLE]")
+{
+    PulseSequencer relays;
+    REQUIRE(coils() == 0);
+
+    SECTION("the pulses are driven one after the other")
+    {
+        relays.request(2, 1);
+        REQUIRE(coils() == SET_COIL(2)); // the first one at once
+        relays.request(0, 0);
+        relays.request(1, 1);
+        REQUIRE(coils() == SET_COIL(2));
+
+        relays.pulseTimerHandler(); // end of the pulse
+        REQUIRE(coils() == 0);
+        relays.pulseTimerHandler(); // end of the pause, the lowest channel is next
+        REQUIRE(coils() == RESET_COIL(0));
+        relays.pulseTimerHandler();
+        REQUIRE(coils() == 0);
+        relays.pulseTimerHandler();
+        REQUIRE(coils() == SET_COIL(1));
+        relays.pulseTimerHandler();
+        REQUIRE(coils() == 0);
+        relays.pulseTimerHandler(); // nothing left
+        REQUIRE(coils() == 0);
+
+        relays.request(3, 0); // idle, starts at once
+        REQUIRE(coils() == RESET_COIL(3));
+    }
+
+    SECTION("a newer request replaces a waiting one")
+    {
+        relays.request(0, 1);
+        relays.request(3, 1);
+        relays.request(3, 0);
+        relays.request(0, 0); // the running pulse is not changed, the channel waits
+        REQUIRE(coils() == SET_COIL(0));
+
+        relays.pulseTimerHandler();
+        relays.pulseTimerHandler();
+        REQUIRE(coils() == RESET_COIL(0));
+        relays.pulseTimerHandler();
+        relays.pulseTimerHandler();
+        REQUIRE(coils() == RESET_COIL(3));
+        relays.pulseTimerHandler();
+        relays.pulseTimerHandler();
+        REQUIRE(coils() == 0);
+    }
+
+    SECTION("stopPulses() cuts the running pulse and drops the waiting ones")
+    {
+        relays.request(0, 1);
+        relays.request(1, 1);
+        relays.stopPulses();
+        REQUIRE(coils() == 0);
+        relays.pulseTimerHandler(); // a late call does not start a pulse
+        REQUIRE(coils() == 0);
+
+        relays.request(2, 0); // the sequencer is idle again
+        REQUIRE(coils() == RESET_COIL(2));
+        relays.stopPulses();
+        REQUIRE(coils() == 0);
+    }
+}
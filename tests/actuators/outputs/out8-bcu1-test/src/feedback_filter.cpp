@@ -0,0 +1,72 @@
+/*
+ *  feedback_filter.cpp - Tests of the feedback objects written together after a delay
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include "sblib/timer.h"
+#include "feedback_filter.h"
+
+#define TEST_FEEDBACK_DELAY_MS 50
+
+TEST_CASE("Feedback objects", "[FEEDBACK]")
+{
+    systemTime = 1000;
+
+    SECTION("without a delay every change is written at once")
+    {
+        FeedbackFilter filter(0);
+        REQUIRE(filter.update(0x00, 0xFF) == 0xFF); // startup
+        REQUIRE(filter.changed());
+        REQUIRE(filter.update(0x04) == 0x04);
+        REQUIRE(filter.changed());
+        REQUIRE(filter.update(0x04) == 0x00);
+        systemTime += 1000;
+        REQUIRE(!filter.expired());
+    }
+
+    SECTION("the changes within the delay are written together")
+    {
+        FeedbackFilter filter(TEST_FEEDBACK_DELAY_MS);
+        filter.update(0x00, 0xFF);
+        REQUIRE(!filter.changed()); // channel 1 on
+        systemTime += 20;
+        REQUIRE(!filter.changed()); // channel 3 on, does not restart the delay
+        systemTime += TEST_FEEDBACK_DELAY_MS - 21;
+        REQUIRE(!filter.expired());
+        systemTime += 1;
+        REQUIRE(filter.expired());
+        REQUIRE(filter.update(0x05) == 0x05);
+        REQUIRE(!filter.expired());
+
+        // the next change starts a new delay
+        REQUIRE(!filter.changed());
+        systemTime += TEST_FEEDBACK_DELAY_MS;
+        REQUIRE(filter.expired());
+        REQUIRE(filter.update(0x01) == 0x04);
+    }
+
+    SECTION("a channel switched back within the delay sends nothing")
+    {
+        FeedbackFilter filter(TEST_FEEDBACK_DELAY_MS);
+        filter.update(0x02, 0xFF);
+        REQUIRE(!filter.changed()); // channel 2 off
+        systemTime += 10;
+        REQUIRE(!filter.changed()); // channel 2 on again
+        systemTime += TEST_FEEDBACK_DELAY_MS;
+        REQUIRE(filter.expired());
+        REQUIRE(filter.update(0x02) == 0x00);
+    }
+
+    SECTION("writing all objects ends the delay")
+    {
+        FeedbackFilter filter(TEST_FEEDBACK_DELAY_MS);
+        filter.update(0x00, 0xFF);
+        REQUIRE(!filter.changed());
+        REQUIRE(filter.update(0x08, 0xFF) == 0xFF);
+        systemTime += TEST_FEEDBACK_DELAY_MS;
+        REQUIRE(!filter.expired());
+    }
+}
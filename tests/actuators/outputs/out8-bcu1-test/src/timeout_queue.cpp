@@ -0,0 +1,66 @@
+/*
+ *  timeout_queue.cpp - Tests of the timeouts sorted by their deadline
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include "sblib/timer.h"
+#include "timeout_queue.h"
+
+TEST_CASE("Timeouts expire in the order of their deadlines", "[TIMEOUT_QUEUE]")
+{
+    TimeoutQueue timeouts;
+
+    SECTION("across the wrap around of millis()")
+    {
+        systemTime = 0xFFFFFF00;
+        timeouts.start(3, 0x200);
+        timeouts.start(7, 0x80);
+        timeouts.start(0, 0x100);
+        timeouts.start(5, 0x100); // same deadline as 0, started later
+        REQUIRE(timeouts.started(3));
+        REQUIRE(timeouts.stopped(1));
+
+        systemTime += 0x7F;
+        REQUIRE(timeouts.nextExpired() == -1);
+        systemTime += 1;
+        REQUIRE(timeouts.nextExpired() == 7);
+        REQUIRE(timeouts.nextExpired() == -1);
+        REQUIRE(timeouts.stopped(7));
+
+        systemTime = 0x10; // millis() has wrapped
+        REQUIRE(timeouts.nextExpired() == 0);
+        REQUIRE(timeouts.nextExpired() == 5);
+        REQUIRE(timeouts.nextExpired() == -1);
+        REQUIRE(timeouts.started(3));
+
+        systemTime = 0xFF;
+        REQUIRE(!timeouts.expired(3));
+        systemTime = 0x100;
+        REQUIRE(timeouts.expired(3));
+        REQUIRE(!timeouts.expired(3)); // reported once
+        REQUIRE(timeouts.nextExpired() == -1);
+    }
+    SECTION("restarted and stopped timeouts")
+    {
+        systemTime = 1000;
+        for (unsigned int id = 0; id < TIMEOUT_QUEUE_SIZE; id++)
+            timeouts.start(id, 100 + id * 10);
+        timeouts.start(0, 500);    // moves to the end
+        timeouts.stop(1);
+        timeouts.stop(15);
+        timeouts.start(15, 5);     // moves to the front
+        REQUIRE(!timeouts.expired(1));
+
+        systemTime = 2000;
+        REQUIRE(timeouts.nextExpired() == 15);
+        for (unsigned int id = 2; id < 15; id++)
+            REQUIRE(timeouts.nextExpired() == (int) id);
+        REQUIRE(timeouts.nextExpired() == 0);
+        REQUIRE(timeouts.nextExpired() == -1);
+        for (unsigned int id = 0; id < TIMEOUT_QUEUE_SIZE; id++)
+            REQUIRE(timeouts.stopped(id));
+    }
+}
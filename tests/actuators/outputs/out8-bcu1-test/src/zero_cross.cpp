@@ -0,0 +1,249 @@
+/*
+ *  zero_cross.cpp - Host simulation of a jittery mains for the zero cross
+ *                   scheduler
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3 as
+ *  published by the Free Software Foundation.
+ */
+#include "catch.hpp"
+#include <stdio.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "zero_cross.h"
+
+/*
+ * The simulated mains: the frequency drifts slowly around the nominal one,
+ * the detector edges have a gaussian jitter, some edges are lost and some
+ * spikes produce additional edges at random times. The timer starts shortly
+ * before its wrap around.
+ */
+class Mains
+{
+public:
+    Mains(double frequency, double jitter, double lost, double spikes)
+      : frequency(frequency), jitter(jitter), lost(lost), spikes(spikes)
+      , random(4711), start(0xFFFF0000u)
+    {}
+
+    // the true zero crossings (both half-waves) in ticks since the start
+    std::vector<double> zeros;
+    // the edges of the detector, as timer counts, in order
+    std::vector<unsigned int> edges;
+
+    void run(double seconds)
+    {
+        std::normal_distribution<double> noise(0, jitter);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        double t = 1000; // ticks
+        std::vector<double> times;
+        while (t < seconds * 100000)
+        {
+            // +-0.2Hz within a minute
+            double f = frequency + 0.2 * sin(2 * M_PI * t / 6000000);
+            double period = 100000 / f;
+            zeros.push_back(t);
+            zeros.push_back(t + period / 2);
+            if (uniform(random) >= lost)
+                times.push_back(t - ZC_DETECTOR_OFFSET + noise(random));
+            if (uniform(random) < spikes)
+                times.push_back(t + uniform(random) * period);
+            t += period;
+        }
+        std::sort(times.begin(), times.end());
+        for (double time : times)
+            edges.push_back(count(time));
+    }
+
+    unsigned int count(double ticks) const
+    {
+        return start + (unsigned int) llround(ticks);
+    }
+
+    double ticks(unsigned int count) const
+    {
+        return (double) (unsigned int) (count - start);
+    }
+
+    // the distance to the nearest true zero crossing in ticks
+    double zeroError(unsigned int count) const
+    {
+        double t = ticks(count);
+        std::vector<double>::const_iterator it = std::lower_bound(zeros.begin(), zeros.end(), t);
+        double best = 1e9;
+        if (it != zeros.end())
+            best = *it - t;
+        if (it != zeros.begin())
+            best = std::min(best, t - *(it - 1));
+        return best;
+    }
+
+    double frequency, jitter, lost, spikes;
+    std::mt19937 random;
+    unsigned int start;
+};
+
+TEST_CASE("Zero cross prediction at 50Hz with jitter", "[ZERO_CROSS]")
+{
+    Mains mains(50, 5, 0.02, 0.02); // 50us jitter, 2% lost edges, 2% spikes
+    ZeroCrossScheduler zc;
+    std::mt19937 random(17);
+    double maxError = 0, sumError = 0;
+    unsigned int predictions = 0;
+
+    mains.run(60);
+    for (unsigned int i = 0; i + 1 < mains.edges.size(); i++)
+    {
+        zc.edge(mains.edges[i]);
+        if (i < 50)
+            continue; // 1s to lock
+        REQUIRE(zc.locked(mains.edges[i]));
+        // a switch request somewhere before the next edge
+        unsigned int gap = mains.edges[i + 1] - mains.edges[i];
+        unsigned int now = mains.edges[i] + random() % gap;
+        unsigned int zero = zc.nextZeroCross(now);
+        // enough time to fire the coil, not later than necessary
+        REQUIRE((int) (zero - now) >= (int) (ZC_MIN_LEAD + zc.releaseTime()));
+        REQUIRE((int) (zero - now) <= (int) (ZC_MIN_LEAD + zc.releaseTime() + 2 * ZC_TICKS_PER_MS / 2 * 10 + 20));
+        double error = mains.zeroError(zero);
+        maxError = std::max(maxError, error);
+        sumError += error;
+        predictions++;
+    }
+    printf("zero cross prediction: %u predictions, mean error %.1f us, max %.1f us, edge jitter 50 us\n",
+            predictions, sumError / predictions * 10, maxError * 10);
+    // the timer has wrapped around during the simulation
+    REQUIRE(mains.edges.back() < mains.start);
+    REQUIRE(sumError / predictions < 3);    // 30us
+    REQUIRE(maxError < 15);                 // 150us
+    REQUIRE(zc.period16() >= (1990 << 4));
+    REQUIRE(zc.period16() <= (2010 << 4));
+}
+
+TEST_CASE("Zero cross lock at 60Hz and after a mains failure", "[ZERO_CROSS]")
+{
+    Mains mains(60, 5, 0, 0);
+    ZeroCrossScheduler zc;
+
+    mains.run(2);
+    REQUIRE(!zc.locked(mains.edges[0]));
+    unsigned int i;
+    for (i = 0; i < ZC_LOCK_EDGES + 1; i++)
+        zc.edge(mains.edges[i]);
+    REQUIRE(zc.locked(mains.edges[i - 1]));
+    REQUIRE(zc.period16() >= (1660 << 4));
+    REQUIRE(zc.period16() <= (1673 << 4));
+
+    // no edges for a while, the relays are switched without waiting for the mains
+    unsigned int later = mains.edges[i - 1] + 200 * ZC_TICKS_PER_MS;
+    REQUIRE(!zc.locked(later));
+    // the mains returns, the lock has to be found again
+    for (unsigned int n = 0; n < ZC_LOCK_EDGES; n++)
+        zc.edge(later + n * 1667);
+    REQUIRE(!zc.locked(later + 3 * 1667));
+    zc.edge(later + ZC_LOCK_EDGES * 1667);
+    REQUIRE(zc.locked(later + ZC_LOCK_EDGES * 1667));
+}
+
+TEST_CASE("Relay contacts switch in the zero crossing", "[ZERO_CROSS]")
+{
+    Mains mains(50, 5, 0.01, 0.01);
+    ZeroCrossScheduler zc;
+    std::mt19937 random(99);
+    std::normal_distribution<double> scatter(0, 5); // 50us scatter of the relay
+    const double operate = 560, release = 600;      // the real relay is slower than the datasheet
+    double first = 0, last = 0;
+    unsigned int switches = 0;
+
+    mains.run(30);
+    for (unsigned int i = 0; i + 1 < mains.edges.size(); i++)
+    {
+        zc.edge(mains.edges[i]);
+        if ((i < 50) || (i % 10))
+            continue;
+        // a channel is switched on or off, the contact delay is measured
+        bool closing = (i / 10) & 1;
+        unsigned int now  = mains.edges[i] + 100;
+        unsigned int zero = zc.nextZeroCross(now);
+        unsigned int fire = zero - (closing ? zc.operateTime() : zc.releaseTime());
+        REQUIRE((int) (fire - now) >= ZC_MIN_LEAD);
+        double delay = (closing ? operate : release) + scatter(random);
+        unsigned int contact = fire + (unsigned int) llround(delay);
+        double error = mains.zeroError(contact);
+        if (switches < 2)
+            first = std::max(first, error);
+        last = error;
+        zc.contactMoved(closing, (unsigned int) llround(delay));
+        switches++;
+    }
+    printf("relay contacts: error %.0f us with the datasheet times, %.0f us after %u learned switches\n",
+            first * 10, last * 10, switches);
+    REQUIRE(first > 40);
+    REQUIRE(last < 25);
+    REQUIRE(zc.operateTime() >= 550);
+    REQUIRE(zc.operateTime() <= 570);
+    REQUIRE(zc.releaseTime() >= 590);
+    REQUIRE(zc.releaseTime() <= 610);
+}
+
+TEST_CASE("Channels switched together share the zero crossing", "[ZERO_CROSS]")
+{
+    Mains mains(50, 0, 0, 0);
+    ZeroCrossScheduler zc;
+
+    mains.run(1);
+    for (unsigned int i = 0; i < 10; i++)
+        zc.edge(mains.edges[i]);
+    unsigned int now = mains.edges[9];
+    unsigned int zero = zc.nextZeroCross(now);
+    // requests until the coils have to be fired are batched into the same half-wave
+    unsigned int latest = zero - zc.releaseTime() - ZC_MIN_LEAD;
+    for (unsigned int t = now; (int) (t - latest) <= 0; t += 37)
+        REQUIRE(zc.nextZeroCross(t) == zero);
+    // a later request takes the next half-wave, not the next period
+    unsigned int next = zc.nextZeroCross(latest + 1);
+    REQUIRE(next - zero >= 999);
+    REQUIRE(next - zero <= 1001);
+}
+
+// the port as switched by the match interrupts of timer32_0 in the order they fire
+static unsigned int fireCoils(const ZeroCrossScheduler & zc, unsigned int port, unsigned int & set, unsigned int & clr)
+{
+    REQUIRE(zc.releaseTime() > zc.operateTime()); // MAT1 (clear) fires before MAT0 (set)
+    port &= ~clr;
+    port |= set;
+    set = clr = 0;
+    return port;
+}
+
+TEST_CASE("A channel switched twice within one zero crossing batch", "[ZERO_CROSS]")
+{
+    ZeroCrossScheduler zc;
+    unsigned int set = 0, clr = 0;
+    const unsigned int pin = 1 << 5, other = 1 << 7;
+
+    SECTION("on and off again stays off")
+    {
+        zeroCrossAddPin(set, clr, pin, 1);
+        zeroCrossAddPin(set, clr, other, 1);
+        zeroCrossAddPin(set, clr, pin, 0);
+        REQUIRE(fireCoils(zc, 0, set, clr) == other);
+    }
+    SECTION("off and on again stays on")
+    {
+        zeroCrossAddPin(set, clr, pin, 0);
+        zeroCrossAddPin(set, clr, pin, 1);
+        REQUIRE(fireCoils(zc, pin, set, clr) == pin);
+    }
+    SECTION("on, off and on again is on")
+    {
+        zeroCrossAddPin(set, clr, pin, 1);
+        zeroCrossAddPin(set, clr, pin, 0);
+        zeroCrossAddPin(set, clr, pin, 1);
+        REQUIRE(set == pin);
+        REQUIRE(clr == 0);
+        REQUIRE(fireCoils(zc, other, set, clr) == (pin | other));
+    }
+}